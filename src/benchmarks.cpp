@@ -0,0 +1,486 @@
+/**
+ * @file benchmarks.cpp
+ * @brief Замеры производительности операций редактора
+ *
+ * Запуск: benchmarks [имя замера] [параметр]. Без аргументов выполняются все замеры.
+ */
+#include "chacha20.h"
+#include "editor.h"
+#include "encrypted_file.h"
+#include "file_writer.h"
+#include "full_screen_editor.h"
+#include "piece_table.h"
+#include "text_kernels.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief Измеряет время выполнения функции
+ * @param fn Измеряемая функция
+ * @return Время в секундах
+ */
+double measure(const std::function<void()>& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+/**
+ * @brief Печатает строку результата замера
+ * @param name Название варианта
+ * @param seconds Время в секундах
+ * @param bytes Объем обработанных данных
+ */
+void report(const std::string& name, double seconds, size_t bytes) {
+    double mb = static_cast<double>(bytes) / (1024.0 * 1024.0);
+    std::printf("  %-36s %9.3f s %10.1f MB/s\n", name.c_str(), seconds, mb / seconds);
+}
+
+/**
+ * @brief Строит документ из коротких строк вида "line <номер>"
+ * @param count Количество строк
+ * @param storage Заполняемое хранилище
+ */
+void makeShortLines(size_t count, TextStorage& storage) {
+    std::string text;
+    std::vector<LineSpan> spans;
+    spans.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        std::string line = "line " + std::to_string(i);
+        spans.push_back({text.size(), line.size()});
+        text += line;
+    }
+    storage.assign(std::move(text), std::move(spans));
+}
+
+/**
+ * @brief Сравнивает запись документа через iostream и через FileWriter
+ * @param lineCount Количество строк документа
+ */
+void benchmarkSave(size_t lineCount) {
+    PieceTable document;
+    makeShortLines(lineCount, document);
+    const size_t bytes = document.byteCount() + document.lineCount();
+    const std::string path = "bench_save.txt";
+
+    std::printf("save: %zu lines, %.1f MB\n", lineCount, bytes / (1024.0 * 1024.0));
+
+    double legacy = measure([&] {
+        std::ofstream file(path);
+        document.forEachLine(0, document.lineCount(), [&](size_t, std::string_view line) {
+            file << line << "\n";
+        });
+    });
+    report("ofstream << line << \"\\n\"", legacy, bytes);
+
+    double buffered = measure([&] {
+        FileWriter file;
+        file.open(path);
+        document.forEachLine(0, document.lineCount(), [&](size_t, std::string_view line) {
+            file.write(line);
+            file.write("\n");
+        });
+        file.close();
+    });
+    report("FileWriter (1 MB buffer)", buffered, bytes);
+
+    std::filesystem::remove(path);
+}
+
+/**
+ * @brief Сравнивает поиск подстроки std::string_view::find и SubstringSearcher
+ * @param lineCount Количество строк документа
+ */
+void benchmarkSearch(size_t lineCount) {
+    // Lines of 40..120 lowercase "words" so that first-byte candidates are frequent
+    PieceTable document;
+    std::string text;
+    std::vector<LineSpan> spans;
+    spans.reserve(lineCount);
+    std::mt19937 rng(1);
+    for (size_t i = 0; i < lineCount; ++i) {
+        size_t length = 40 + rng() % 81;
+        size_t start = text.size();
+        for (size_t j = 0; j < length; ++j) {
+            text += (rng() % 6 == 0) ? ' ' : static_cast<char>('a' + rng() % 26);
+        }
+        spans.push_back({start, length});
+    }
+    document.assign(std::move(text), std::move(spans));
+    const size_t bytes = document.byteCount();
+
+    std::printf("search: %zu lines, %.1f MB, kernel %s\n", lineCount,
+                bytes / (1024.0 * 1024.0), kernelInstructionSet());
+
+    for (const std::string needle : {"ed", "ing", "editor", "substring search"}) {
+        size_t legacyHits = 0;
+        double legacy = measure([&] {
+            document.forEachLine(0, document.lineCount(), [&](size_t, std::string_view line) {
+                if (line.find(needle) != std::string_view::npos) ++legacyHits;
+            });
+        });
+        report("string_view::find '" + needle + "'", legacy, bytes);
+
+        size_t kernelHits = 0;
+        SubstringSearcher searcher(needle);
+        double kernel = measure([&] {
+            document.forEachLine(0, document.lineCount(), [&](size_t, std::string_view line) {
+                if (searcher.containedIn(line)) ++kernelHits;
+            });
+        });
+        report("SubstringSearcher '" + needle + "'", kernel, bytes);
+
+        if (legacyHits != kernelHits) {
+            std::printf("  mismatch: %zu vs %zu matches\n", legacyHits, kernelHits);
+        }
+    }
+}
+
+/**
+ * @brief Сравнивает подсчет слов через istringstream и векторное ядро countWords
+ * @param lineCount Количество строк документа
+ */
+void benchmarkWords(size_t lineCount) {
+    PieceTable document;
+    std::string text;
+    std::vector<LineSpan> spans;
+    spans.reserve(lineCount);
+    std::mt19937 rng(2);
+    for (size_t i = 0; i < lineCount; ++i) {
+        size_t length = 40 + rng() % 81;
+        size_t start = text.size();
+        for (size_t j = 0; j < length; ++j) {
+            text += (rng() % 6 == 0) ? ' ' : static_cast<char>('a' + rng() % 26);
+        }
+        spans.push_back({start, length});
+        text += '\n';
+    }
+    const std::string raw = text;
+    document.assign(std::move(text), std::move(spans));
+    const size_t bytes = document.byteCount();
+
+    std::printf("words: %zu lines, %.1f MB, kernel %s\n", lineCount,
+                bytes / (1024.0 * 1024.0), kernelInstructionSet());
+
+    size_t legacyWords = 0;
+    double legacy = measure([&] {
+        document.forEachLine(0, document.lineCount(), [&](size_t, std::string_view line) {
+            std::istringstream iss{std::string(line)};
+            std::string word;
+            while (iss >> word) legacyWords++;
+        });
+    });
+    report("istringstream >> word", legacy, bytes);
+
+    size_t kernelWords = 0;
+    double kernel = measure([&] {
+        document.forEachLine(0, document.lineCount(), [&](size_t, std::string_view line) {
+            kernelWords += countWords(line.data(), line.size());
+        });
+    });
+    report("countWords per line", kernel, bytes);
+
+    size_t streamWords = 0;
+    double stream = measure([&] {
+        bool inWord = false;
+        for (size_t offset = 0; offset < raw.size(); offset += 1 << 20) {
+            size_t size = std::min(raw.size() - offset, size_t(1) << 20);
+            streamWords += countWords(raw.data() + offset, size, inWord);
+        }
+    });
+    report("countWords 1 MB blocks", stream, raw.size());
+
+    if (legacyWords != kernelWords || legacyWords != streamWords) {
+        std::printf("  mismatch: %zu vs %zu vs %zu words\n", legacyWords, kernelWords, streamWords);
+    }
+}
+
+/**
+ * @brief Замеряет changeAllLinesCase в одном потоке и на всех ядрах
+ * @param lineCount Количество строк документа
+ */
+void benchmarkCase(size_t lineCount) {
+    const std::string path = "bench_case.txt";
+    {
+        FileWriter file;
+        file.open(path);
+        std::mt19937 rng(3);
+        std::string line;
+        for (size_t i = 0; i < lineCount; ++i) {
+            line.clear();
+            size_t length = 40 + rng() % 81;
+            for (size_t j = 0; j < length; ++j) {
+                line += (rng() % 6 == 0) ? ' ' : static_cast<char>('a' + rng() % 26);
+            }
+            line += '\n';
+            file.write(line);
+        }
+        file.close();
+    }
+
+    TextEditor editor;
+    editor.loadFile(path);
+    const size_t bytes = editor.getCharCount();
+    std::printf("case: %zu lines, %.1f MB\n", lineCount, bytes / (1024.0 * 1024.0));
+
+    for (size_t threads : {size_t(1), size_t(0)}) {
+        editor.setThreadCount(threads);
+        double upper = measure([&] { editor.changeAllLinesCase(1); });
+        report("allupper, " + std::to_string(editor.getThreadCount()) + " thread(s)", upper, bytes);
+        double title = measure([&] { editor.changeAllLinesCase(3); });
+        report("alltitle, " + std::to_string(editor.getThreadCount()) + " thread(s)", title, bytes);
+    }
+    std::filesystem::remove(path);
+}
+
+/**
+ * @brief Сравнивает прежнее построчное XOR-шифрование с ChaCha20
+ * @param lineCount Количество строк документа
+ */
+void benchmarkCrypto(size_t lineCount) {
+    TextEditor editor;
+    std::vector<std::string> lines;
+    lines.reserve(lineCount);
+    std::mt19937 rng(4);
+    for (size_t i = 0; i < lineCount; ++i) {
+        std::string line(40 + rng() % 81, ' ');
+        for (char& c : line) {
+            if (rng() % 6 != 0) c = static_cast<char>('a' + rng() % 26);
+        }
+        lines.push_back(std::move(line));
+    }
+    size_t bytes = 0;
+    for (const auto& line : lines) bytes += line.size() + 1;
+    std::printf("crypto: %zu lines, %.1f MB, kernel %s\n", lineCount,
+                bytes / (1024.0 * 1024.0), kernelInstructionSet());
+
+    const std::string password = "benchmark password";
+    volatile char sink = 0;
+    double legacy = measure([&] {
+        for (const auto& line : lines) {
+            // deriveKey + xorCrypt as they were before ChaCha20
+            std::string key;
+            for (size_t i = 0; key.size() < line.size(); ++i) {
+                key += std::to_string(password.size() * (i + 1)) + password;
+            }
+            key.resize(line.size());
+            std::string result = line;
+            for (size_t i = 0; i < line.size(); ++i) {
+                result[i] = line[i] ^ key[i % key.size()];
+            }
+            sink = result.back();
+        }
+    });
+    report("deriveKey + xorCrypt per line", legacy, bytes);
+
+    std::string raw;
+    raw.reserve(bytes);
+    for (const auto& line : lines) {
+        raw += line;
+        raw += '\n';
+    }
+    const uint8_t key[ChaCha20::kKeySize] = {1};
+    const uint8_t nonce[ChaCha20::kNonceSize] = {};
+    double stream = measure([&] {
+        ChaCha20 cipher(key, nonce);
+        cipher.apply(&raw[0], raw.size());
+    });
+    report("ChaCha20 keystream", stream, bytes);
+
+    const std::string path = "bench_crypto.bin";
+    double sealed = measure([&] {
+        EncryptedFileWriter writer;
+        writer.open(path, password);
+        writer.write(raw);
+        writer.close();
+    });
+    report("EncryptedFileWriter (with PBKDF2)", sealed, bytes);
+    std::string opened(raw.size(), '\0');
+    double read = measure([&] {
+        EncryptedFileReader reader;
+        if (reader.open(path, password) == EncryptedFileStatus::Ok) {
+            reader.read(0, &opened[0], opened.size());
+        }
+    });
+    report("EncryptedFileReader (with PBKDF2)", read, bytes);
+    if (opened != raw) {
+        std::printf("  container round trip failed\n");
+    }
+
+    for (const auto& line : lines) editor.addLine(line);
+    editor.encryptFile(password);
+    for (size_t threads : {size_t(1), size_t(0)}) {
+        editor.setThreadCount(threads);
+        const std::string suffix = ", " + std::to_string(editor.getThreadCount()) + " thread(s)";
+        double save = measure([&] { editor.saveToFile(path); });
+        report("encrypted save" + suffix, save, bytes);
+
+        TextEditor loaded;
+        loaded.setThreadCount(threads);
+        double load = measure([&] {
+            loaded.loadFile(path);
+            loaded.decryptFile(password);
+        });
+        report("encrypted load" + suffix, load, bytes);
+        if (loaded.getLines() != lines) {
+            std::printf("  round trip failed\n");
+        }
+    }
+    std::filesystem::remove(path);
+}
+
+/**
+ * @brief Сравнивает построчный вывод через operator<< с выводом одним буфером
+ * @param lineCount Количество строк документа
+ */
+void benchmarkRender(size_t lineCount) {
+    // Output goes to a stream buffer that discards everything
+    struct NullBuffer : std::streambuf {
+        std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+        int_type overflow(int_type c) override { return traits_type::not_eof(c); }
+    } null;
+
+    TextEditor editor;
+    std::vector<std::string> lines;
+    lines.reserve(lineCount);
+    for (size_t i = 0; i < lineCount; ++i) {
+        lines.push_back("for (size_t i = " + std::to_string(i) + "; i < n; ++i) { /* line */ }");
+    }
+    const std::string path = "bench_render.cpp";
+    {
+        FileWriter file;
+        file.open(path);
+        for (const auto& line : lines) {
+            file.write(line);
+            file.write("\n");
+        }
+        file.close();
+    }
+    editor.loadFile(path);
+    std::printf("render: %zu lines\n", lineCount);
+
+    const size_t screen = 50;
+    std::streambuf* previous = std::cout.rdbuf(&null);
+    double legacy = measure([&] {
+        for (size_t i = 0; i < lineCount; ++i) {
+            std::cout << i + 1 << ": " << lines[i] << "\n";
+        }
+    });
+    double whole = measure([&] { editor.displayText(); });
+    double top = measure([&] { editor.displayText(1, screen); });
+    double middle = measure([&] { editor.displayText(lineCount / 2, lineCount / 2 + screen - 1); });
+    editor.setSyntaxHighlightEnabled(true);
+    double coldHighlighted = measure([&] { editor.displayText(lineCount / 2, lineCount / 2 + screen - 1); });
+    double warmHighlighted = measure([&] { editor.displayText(lineCount / 2, lineCount / 2 + screen - 1); });
+    std::cout.rdbuf(previous);
+
+    const size_t bytes = editor.getCharCount();
+    report("operator<< per line, whole document", legacy, bytes);
+    report("displayText, whole document", whole, bytes);
+    std::printf("  %-36s %9.3f ms\n", "screen at the top", top * 1000);
+    std::printf("  %-36s %9.3f ms\n", "screen in the middle", middle * 1000);
+    std::printf("  %-36s %9.3f ms\n", "highlighted screen, first time", coldHighlighted * 1000);
+    std::printf("  %-36s %9.3f ms\n", "highlighted screen, cached", warmHighlighted * 1000);
+    std::filesystem::remove(path);
+}
+
+/**
+ * @brief Замер задержки нажатия клавиши в полноэкранном режиме
+ * @param lineCount Количество строк документа
+ */
+void benchmarkKeystroke(size_t lineCount) {
+    const std::string path = "bench_keystroke.cpp";
+    {
+        FileWriter file;
+        file.open(path);
+        for (size_t i = 0; i < lineCount; ++i) {
+            file.write("for (size_t i = " + std::to_string(i) + "; i < n; ++i) { /* line */ }\n");
+        }
+        file.close();
+    }
+    TextEditor editor;
+    editor.loadFile(path);
+    editor.setSyntaxHighlightEnabled(true);
+    std::printf("keystroke: %zu lines, 50x120 screen\n", lineCount);
+
+    FullScreenEditor screen(editor, 50, 120);
+    screen.goToLine(lineCount / 2);
+    std::string out;
+    double first = measure([&] { screen.render(out); });
+    const size_t fullFrame = out.size();
+
+    auto perKey = [&](KeyType type, const std::string& text, size_t count, size_t& bytes) {
+        Key key;
+        key.type = type;
+        key.text = text;
+        bytes = 0;
+        return measure([&] {
+            for (size_t i = 0; i < count; ++i) {
+                screen.handleKey(key);
+                out.clear();
+                screen.render(out);
+                bytes += out.size();
+            }
+        }) / static_cast<double>(count);
+    };
+    const size_t keys = 200;
+    size_t typedBytes, scrolledBytes, pagedBytes;
+    double typed = perKey(KeyType::Char, "x", keys, typedBytes);
+    double scrolled = perKey(KeyType::Down, "", keys, scrolledBytes);
+    double paged = perKey(KeyType::PageDown, "", keys, pagedBytes);
+
+    std::printf("  %-36s %9.3f ms %8zu bytes\n", "first frame", first * 1000, fullFrame);
+    std::printf("  %-36s %9.3f ms %8zu bytes\n", "typing, per key", typed * 1000, typedBytes / keys);
+    std::printf("  %-36s %9.3f ms %8zu bytes\n", "cursor down, per key", scrolled * 1000, scrolledBytes / keys);
+    std::printf("  %-36s %9.3f ms %8zu bytes\n", "page down, per key", paged * 1000, pagedBytes / keys);
+    std::filesystem::remove(path);
+}
+
+} // namespace
+
+/**
+ * @brief Точка входа замеров
+ * @param argc Количество аргументов
+ * @param argv Аргументы: имя замера и его параметр
+ * @return Код завершения
+ */
+int main(int argc, char** argv) {
+    std::string name = argc > 1 ? argv[1] : "all";
+    size_t param = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 0;
+
+    if (name == "save" || name == "all") {
+        benchmarkSave(param ? param : 10000000);
+    }
+    if (name == "search" || name == "all") {
+        benchmarkSearch(param ? param : 2000000);
+    }
+    if (name == "case" || name == "all") {
+        benchmarkCase(param ? param : 5000000);
+    }
+    if (name == "words" || name == "all") {
+        benchmarkWords(param ? param : 2000000);
+    }
+    if (name == "crypto" || name == "all") {
+        benchmarkCrypto(param ? param : 2000000);
+    }
+    if (name == "render" || name == "all") {
+        benchmarkRender(param ? param : 2000000);
+    }
+    if (name == "keystroke" || name == "all") {
+        benchmarkKeystroke(param ? param : 2000000);
+    }
+    return 0;
+}
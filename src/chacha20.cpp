@@ -0,0 +1,353 @@
+#include "chacha20.h"
+#include "cpu_features.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+/**
+ * @brief Читает слово в порядке байтов little-endian
+ * @param p Адрес слова
+ * @return Значение слова
+ */
+inline uint32_t loadLittleEndian(const uint8_t* p) {
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+/**
+ * @brief Записывает слово в порядке байтов little-endian
+ * @param p Адрес слова
+ * @param value Значение слова
+ */
+inline void storeLittleEndian(uint8_t* p, uint32_t value) {
+    p[0] = uint8_t(value);
+    p[1] = uint8_t(value >> 8);
+    p[2] = uint8_t(value >> 16);
+    p[3] = uint8_t(value >> 24);
+}
+
+/**
+ * @brief Циклически сдвигает слово влево
+ * @param value Слово
+ * @param bits Величина сдвига (от 1 до 31)
+ * @return Результат сдвига
+ */
+inline uint32_t rotl(uint32_t value, unsigned bits) {
+    return (value << bits) | (value >> (32 - bits));
+}
+
+/**
+ * @brief Четверть-раунд ChaCha над четырьмя словами состояния
+ */
+inline void quarterRound(uint32_t& a, uint32_t& b, uint32_t& c, uint32_t& d) {
+    a += b; d ^= a; d = rotl(d, 16);
+    c += d; b ^= c; b = rotl(b, 12);
+    a += b; d ^= a; d = rotl(d, 8);
+    c += d; b ^= c; b = rotl(b, 7);
+}
+
+/**
+ * @brief Вычисляет блоки ключевого потока по одному (скалярная реализация)
+ * @param input Начальное состояние (слово 12 заменяется счетчиком)
+ * @param counter Номер первого блока
+ * @param out Буфер для blocks блоков
+ * @param blocks Количество блоков
+ */
+void chachaBlocksScalar(const uint32_t* input, uint32_t counter, uint8_t* out, size_t blocks) {
+    for (size_t block = 0; block < blocks; ++block, out += ChaCha20::kBlockSize) {
+        uint32_t start[16];
+        std::memcpy(start, input, sizeof(start));
+        start[12] = counter + static_cast<uint32_t>(block);
+
+        uint32_t x[16];
+        std::memcpy(x, start, sizeof(x));
+        for (int round = 0; round < 10; ++round) {
+            quarterRound(x[0], x[4], x[8], x[12]);
+            quarterRound(x[1], x[5], x[9], x[13]);
+            quarterRound(x[2], x[6], x[10], x[14]);
+            quarterRound(x[3], x[7], x[11], x[15]);
+            quarterRound(x[0], x[5], x[10], x[15]);
+            quarterRound(x[1], x[6], x[11], x[12]);
+            quarterRound(x[2], x[7], x[8], x[13]);
+            quarterRound(x[3], x[4], x[9], x[14]);
+        }
+        for (int i = 0; i < 16; ++i) {
+            storeLittleEndian(out + 4 * i, x[i] + start[i]);
+        }
+    }
+}
+
+#if defined(CPU_FEATURES_X86)
+
+/**
+ * @brief Циклически сдвигает влево каждое слово вектора SSE2
+ * @tparam Bits Величина сдвига
+ */
+template <int Bits>
+inline __m128i rotlSse2(__m128i v) {
+    return _mm_or_si128(_mm_slli_epi32(v, Bits), _mm_srli_epi32(v, 32 - Bits));
+}
+
+/**
+ * @brief Четверть-раунд над векторами SSE2 (по блоку на элемент)
+ */
+inline void quarterRoundSse2(__m128i& a, __m128i& b, __m128i& c, __m128i& d) {
+    a = _mm_add_epi32(a, b); d = rotlSse2<16>(_mm_xor_si128(d, a));
+    c = _mm_add_epi32(c, d); b = rotlSse2<12>(_mm_xor_si128(b, c));
+    a = _mm_add_epi32(a, b); d = rotlSse2<8>(_mm_xor_si128(d, a));
+    c = _mm_add_epi32(c, d); b = rotlSse2<7>(_mm_xor_si128(b, c));
+}
+
+/**
+ * @brief Вычисляет 4 блока ключевого потока одновременно (SSE2)
+ * @param input Начальное состояние (слово 12 заменяется счетчиком)
+ * @param counter Номер первого блока
+ * @param out Буфер для 4 блоков
+ */
+void chachaBlocksSse2(const uint32_t* input, uint32_t counter, uint8_t* out) {
+    __m128i start[16];
+    for (int i = 0; i < 16; ++i) {
+        start[i] = _mm_set1_epi32(static_cast<int>(input[i]));
+    }
+    start[12] = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(counter)), _mm_setr_epi32(0, 1, 2, 3));
+
+    __m128i x[16];
+    for (int i = 0; i < 16; ++i) x[i] = start[i];
+    for (int round = 0; round < 10; ++round) {
+        quarterRoundSse2(x[0], x[4], x[8], x[12]);
+        quarterRoundSse2(x[1], x[5], x[9], x[13]);
+        quarterRoundSse2(x[2], x[6], x[10], x[14]);
+        quarterRoundSse2(x[3], x[7], x[11], x[15]);
+        quarterRoundSse2(x[0], x[5], x[10], x[15]);
+        quarterRoundSse2(x[1], x[6], x[11], x[12]);
+        quarterRoundSse2(x[2], x[7], x[8], x[13]);
+        quarterRoundSse2(x[3], x[4], x[9], x[14]);
+    }
+    for (int i = 0; i < 16; ++i) x[i] = _mm_add_epi32(x[i], start[i]);
+
+    // Элемент b вектора x[w] — слово w блока b: транспонирование 4x4
+    // превращает четверку векторов в 16 байт каждого из четырех блоков
+    for (int w = 0; w < 16; w += 4) {
+        __m128i t0 = _mm_unpacklo_epi32(x[w], x[w + 1]);
+        __m128i t1 = _mm_unpackhi_epi32(x[w], x[w + 1]);
+        __m128i t2 = _mm_unpacklo_epi32(x[w + 2], x[w + 3]);
+        __m128i t3 = _mm_unpackhi_epi32(x[w + 2], x[w + 3]);
+        uint8_t* p = out + 4 * w;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm_unpacklo_epi64(t0, t2));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p + 64), _mm_unpackhi_epi64(t0, t2));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p + 128), _mm_unpacklo_epi64(t1, t3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p + 192), _mm_unpackhi_epi64(t1, t3));
+    }
+}
+
+/**
+ * @brief Циклически сдвигает влево каждое слово вектора AVX2
+ * @tparam Bits Величина сдвига
+ */
+template <int Bits>
+CPU_TARGET_AVX2 inline __m256i rotlAvx2(__m256i v) {
+    return _mm256_or_si256(_mm256_slli_epi32(v, Bits), _mm256_srli_epi32(v, 32 - Bits));
+}
+
+/**
+ * @brief Сдвигает каждое слово вектора AVX2 на 16 бит перестановкой байтов
+ */
+CPU_TARGET_AVX2 inline __m256i rotl16Avx2(__m256i v) {
+    const __m256i order = _mm256_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+                                           2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+    return _mm256_shuffle_epi8(v, order);
+}
+
+/**
+ * @brief Сдвигает каждое слово вектора AVX2 на 8 бит перестановкой байтов
+ */
+CPU_TARGET_AVX2 inline __m256i rotl8Avx2(__m256i v) {
+    const __m256i order = _mm256_setr_epi8(3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14,
+                                           3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14);
+    return _mm256_shuffle_epi8(v, order);
+}
+
+/**
+ * @brief Четверть-раунд над векторами AVX2 (по блоку на элемент)
+ */
+CPU_TARGET_AVX2 inline void quarterRoundAvx2(__m256i& a, __m256i& b, __m256i& c, __m256i& d) {
+    a = _mm256_add_epi32(a, b); d = rotl16Avx2(_mm256_xor_si256(d, a));
+    c = _mm256_add_epi32(c, d); b = rotlAvx2<12>(_mm256_xor_si256(b, c));
+    a = _mm256_add_epi32(a, b); d = rotl8Avx2(_mm256_xor_si256(d, a));
+    c = _mm256_add_epi32(c, d); b = rotlAvx2<7>(_mm256_xor_si256(b, c));
+}
+
+/**
+ * @brief Вычисляет 8 блоков ключевого потока одновременно (AVX2)
+ * @param input Начальное состояние (слово 12 заменяется счетчиком)
+ * @param counter Номер первого блока
+ * @param out Буфер для 8 блоков
+ */
+CPU_TARGET_AVX2 void chachaBlocksAvx2(const uint32_t* input, uint32_t counter, uint8_t* out) {
+    __m256i start[16];
+    for (int i = 0; i < 16; ++i) {
+        start[i] = _mm256_set1_epi32(static_cast<int>(input[i]));
+    }
+    start[12] = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(counter)),
+                                 _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+    __m256i x[16];
+    for (int i = 0; i < 16; ++i) x[i] = start[i];
+    for (int round = 0; round < 10; ++round) {
+        quarterRoundAvx2(x[0], x[4], x[8], x[12]);
+        quarterRoundAvx2(x[1], x[5], x[9], x[13]);
+        quarterRoundAvx2(x[2], x[6], x[10], x[14]);
+        quarterRoundAvx2(x[3], x[7], x[11], x[15]);
+        quarterRoundAvx2(x[0], x[5], x[10], x[15]);
+        quarterRoundAvx2(x[1], x[6], x[11], x[12]);
+        quarterRoundAvx2(x[2], x[7], x[8], x[13]);
+        quarterRoundAvx2(x[3], x[4], x[9], x[14]);
+    }
+    for (int i = 0; i < 16; ++i) x[i] = _mm256_add_epi32(x[i], start[i]);
+
+    // Транспонирование 8x8 для каждой половины блока: после него в каждой
+    // 128-битной половине вектора лежат четыре соседних слова одного блока
+    for (int half = 0; half < 16; half += 8) {
+        const __m256i* a = x + half;
+        __m256i t0 = _mm256_unpacklo_epi32(a[0], a[1]);
+        __m256i t1 = _mm256_unpackhi_epi32(a[0], a[1]);
+        __m256i t2 = _mm256_unpacklo_epi32(a[2], a[3]);
+        __m256i t3 = _mm256_unpackhi_epi32(a[2], a[3]);
+        __m256i t4 = _mm256_unpacklo_epi32(a[4], a[5]);
+        __m256i t5 = _mm256_unpackhi_epi32(a[4], a[5]);
+        __m256i t6 = _mm256_unpacklo_epi32(a[6], a[7]);
+        __m256i t7 = _mm256_unpackhi_epi32(a[6], a[7]);
+
+        __m256i low[4] = {_mm256_unpacklo_epi64(t0, t2), _mm256_unpackhi_epi64(t0, t2),
+                          _mm256_unpacklo_epi64(t1, t3), _mm256_unpackhi_epi64(t1, t3)};
+        __m256i high[4] = {_mm256_unpacklo_epi64(t4, t6), _mm256_unpackhi_epi64(t4, t6),
+                           _mm256_unpacklo_epi64(t5, t7), _mm256_unpackhi_epi64(t5, t7)};
+
+        uint8_t* p = out + 4 * half;
+        for (int b = 0; b < 4; ++b) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(p + 64 * b),
+                                _mm256_permute2x128_si256(low[b], high[b], 0x20));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(p + 64 * (b + 4)),
+                                _mm256_permute2x128_si256(low[b], high[b], 0x31));
+        }
+    }
+}
+
+#endif
+
+/**
+ * @brief Накладывает ключевой поток на данные
+ * @param data Данные
+ * @param keystream Ключевой поток той же длины
+ * @param size Размер в байтах
+ */
+inline void xorBytes(uint8_t* data, const uint8_t* keystream, size_t size) {
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t a, b;
+        std::memcpy(&a, data + i, 8);
+        std::memcpy(&b, keystream + i, 8);
+        a ^= b;
+        std::memcpy(data + i, &a, 8);
+    }
+    for (; i < size; ++i) {
+        data[i] ^= keystream[i];
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Создает шифр, установленный на начало ключевого потока
+ * @param key Ключ размером kKeySize байт
+ * @param nonce Одноразовое число размером kNonceSize байт
+ * @param counter Номер блока, с которого начинается поток
+ */
+ChaCha20::ChaCha20(const uint8_t* key, const uint8_t* nonce, uint32_t counter)
+    : input{0x61707865, 0x3320646e, 0x79622d32, 0x6b206574}, batchStart(0),
+      batchValid(false), position(0) {
+    for (int i = 0; i < 8; ++i) {
+        input[4 + i] = loadLittleEndian(key + 4 * i);
+    }
+    input[12] = counter;
+    for (int i = 0; i < 3; ++i) {
+        input[13 + i] = loadLittleEndian(nonce + 4 * i);
+    }
+}
+
+/**
+ * @brief Затирает ключ и ключевой поток
+ */
+ChaCha20::~ChaCha20() {
+    std::fill(input.begin(), input.end(), 0);
+    std::fill(keystream.begin(), keystream.end(), 0);
+}
+
+/**
+ * @brief Переходит к указанной позиции ключевого потока
+ * @param offset Смещение в байтах от начала потока
+ */
+void ChaCha20::seek(uint64_t offset) {
+    position = offset;
+}
+
+/**
+ * @brief Возвращает текущую позицию ключевого потока
+ * @return Смещение в байтах от начала потока
+ */
+uint64_t ChaCha20::tell() const {
+    return position;
+}
+
+/**
+ * @brief Вычисляет пачку ключевого потока, содержащую текущую позицию
+ */
+void ChaCha20::refill() {
+    const uint64_t firstBlock = input[12] + position / kBlockSize;
+    if (firstBlock + kBatchBlocks > (uint64_t(1) << 32)) {
+        throw std::length_error("ChaCha20 keystream exhausted");
+    }
+    const uint32_t counter = static_cast<uint32_t>(firstBlock);
+
+    switch (instructionSet()) {
+#if defined(CPU_FEATURES_X86)
+        case InstructionSet::Avx2:
+            chachaBlocksAvx2(input.data(), counter, keystream.data());
+            break;
+        case InstructionSet::Sse2:
+            chachaBlocksSse2(input.data(), counter, keystream.data());
+            chachaBlocksSse2(input.data(), counter + 4, keystream.data() + 4 * kBlockSize);
+            break;
+#endif
+        default:
+            chachaBlocksScalar(input.data(), counter, keystream.data(), kBatchBlocks);
+            break;
+    }
+    batchStart = position - position % kBlockSize;
+    batchValid = true;
+}
+
+/**
+ * @brief Накладывает ключевой поток на данные на месте и продвигает позицию
+ *
+ * Одна и та же операция шифрует и расшифровывает.
+ *
+ * @param data Данные
+ * @param size Размер данных в байтах
+ * @throws std::length_error при выходе за 2^32 блока ключевого потока
+ */
+void ChaCha20::apply(void* data, size_t size) {
+    uint8_t* p = static_cast<uint8_t*>(data);
+    while (size > 0) {
+        if (!batchValid || position < batchStart || position - batchStart >= keystream.size()) {
+            refill();
+        }
+        const size_t from = static_cast<size_t>(position - batchStart);
+        const size_t take = std::min(size, keystream.size() - from);
+        xorBytes(p, keystream.data() + from, take);
+        p += take;
+        size -= take;
+        position += take;
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef CHACHA20_H
+#define CHACHA20_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @file chacha20.h
+ * @brief Потоковый шифр ChaCha20 (RFC 8439)
+ *
+ * Ключевой поток вычисляется пачками по 8 блоков: векторная реализация
+ * (AVX2 или SSE2) считает несколько блоков одновременно, по блоку на элемент
+ * вектора. Реализация выбирается один раз при первом вызове.
+ */
+
+/**
+ * @brief Шифрование и расшифровка наложением ключевого потока ChaCha20
+ *
+ * Поток адресуется смещением в байтах, поэтому к любой его позиции можно
+ * перейти за O(1): данные, разбитые на строки или части, обрабатываются
+ * независимо, если каждой части сопоставлено ее смещение в потоке.
+ */
+class ChaCha20 {
+public:
+    static constexpr size_t kKeySize = 32;   ///< Размер ключа в байтах
+    static constexpr size_t kNonceSize = 12; ///< Размер одноразового числа в байтах
+    static constexpr size_t kBlockSize = 64; ///< Размер блока ключевого потока в байтах
+
+    /**
+     * @brief Создает шифр, установленный на начало ключевого потока
+     * @param key Ключ размером kKeySize байт
+     * @param nonce Одноразовое число размером kNonceSize байт
+     * @param counter Номер блока, с которого начинается поток
+     */
+    ChaCha20(const uint8_t* key, const uint8_t* nonce, uint32_t counter = 0);
+
+    /**
+     * @brief Затирает ключ и ключевой поток
+     */
+    ~ChaCha20();
+
+    ChaCha20(const ChaCha20&) = default;
+    ChaCha20& operator=(const ChaCha20&) = default;
+
+    /**
+     * @brief Переходит к указанной позиции ключевого потока
+     * @param offset Смещение в байтах от начала потока
+     */
+    void seek(uint64_t offset);
+
+    /**
+     * @brief Возвращает текущую позицию ключевого потока
+     * @return Смещение в байтах от начала потока
+     */
+    uint64_t tell() const;
+
+    /**
+     * @brief Накладывает ключевой поток на данные на месте и продвигает позицию
+     *
+     * Одна и та же операция шифрует и расшифровывает.
+     *
+     * @param data Данные
+     * @param size Размер данных в байтах
+     * @throws std::length_error при выходе за 2^32 блока ключевого потока
+     */
+    void apply(void* data, size_t size);
+
+private:
+    static constexpr size_t kBatchBlocks = 8; ///< Блоков в одной пачке ключевого потока
+
+    /**
+     * @brief Вычисляет пачку ключевого потока, содержащую текущую позицию
+     */
+    void refill();
+
+    std::array<uint32_t, 16> input;                              ///< Начальное состояние блока
+    alignas(32) std::array<uint8_t, kBatchBlocks * kBlockSize> keystream; ///< Текущая пачка потока
+    uint64_t batchStart; ///< Смещение пачки в потоке
+    bool batchValid;     ///< Вычислена ли пачка
+    uint64_t position;   ///< Текущая позиция в потоке
+};
+
+#endif // CHACHA20_H
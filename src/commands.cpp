@@ -0,0 +1,877 @@
+#include "commands.h"
+#include "full_screen_editor.h"
+#include "keyword_tables.h"
+#include "spsc_queue.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+/// Количество строк на странице команды page
+constexpr size_t kPageLines = 40;
+
+/// Количество строк, которые поток чтения может разобрать заранее
+constexpr size_t kReadAheadLines = 1024;
+
+/**
+ * @brief Строка ввода, прочитанная и разобранная потоком чтения
+ */
+struct QueuedLine {
+    std::string text;        ///< Строка без перевода строки
+    int command = -1;        ///< Номер команды в реестре (kBlankLine, -1 - неизвестная)
+    size_t argumentsAt = 0;  ///< Смещение аргументов после имени команды
+    bool end = false;        ///< Ввод закончился (text пуст)
+};
+
+/**
+ * @class CommandPipeline
+ * @brief Опережающее чтение команд в отдельном потоке
+ *
+ * Поток чтения читает строки, находит команду в реестре и передает их
+ * исполняющему потоку через очередь SpscQueue, пока тот выполняет
+ * предыдущие команды. Ожидание пустой или заполненной очереди начинается
+ * с опроса и переходит к уступанию процессора и коротким паузам.
+ *
+ * Поток чтения не должен пережить поток ввода и не должен зависнуть в чтении
+ * после exit: канал, конец записи которого остается открытым, не дает конца
+ * ввода. Поэтому после строки exit чтение приостанавливается, пока
+ * исполнитель не запросит следующую строку (exit оказался ответом на запрос
+ * команды), и деструктор дожидается потока, который ничего не читает.
+ */
+class CommandPipeline {
+public:
+    /**
+     * @brief Запускает поток чтения
+     * @param input Источник строк
+     */
+    explicit CommandPipeline(std::istream& input);
+
+    /**
+     * @brief Останавливает поток чтения после текущей строки и дожидается его
+     *
+     * Если последней извлеченной строкой была exit, поток чтения уже стоит
+     * и не ждет ввода.
+     */
+    ~CommandPipeline();
+
+    CommandPipeline(const CommandPipeline&) = delete;
+    CommandPipeline& operator=(const CommandPipeline&) = delete;
+
+    /**
+     * @brief Извлекает следующую строку, дожидаясь ее
+     * @param line Строка
+     * @return false если ввод закончился
+     */
+    bool next(QueuedLine& line);
+
+private:
+    std::istream& input;                         ///< Источник строк
+    SpscQueue<QueuedLine, kReadAheadLines> queue; ///< Разобранные строки
+    std::atomic<bool> stopping;                  ///< Исполнитель больше не читает строки
+    std::atomic<size_t> requested;               ///< Сколько строк запросил исполнитель
+    size_t taken;                                ///< Сколько строк извлечено (исполнитель)
+    bool finished;                               ///< Конец ввода уже извлечен
+    std::thread reader;                          ///< Поток чтения
+
+    /**
+     * @brief Цикл потока чтения
+     */
+    void readLoop();
+};
+
+namespace {
+
+/// Номер «команды» пустой строки или комментария
+constexpr int kBlankLine = -2;
+
+/**
+ * @brief Ждет, постепенно переходя от опроса к паузам
+ * @param spins Количество неудачных попыток подряд
+ */
+void backoff(unsigned& spins) {
+    if (++spins < 64) return;
+    if (spins < 1024) {
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+}
+
+/**
+ * @brief Проверяет, является ли символ пробельным
+ * @param c Символ
+ * @return true для пробела, табуляции и переводов строки
+ */
+bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+/**
+ * @class CommandArguments
+ * @brief Разбор аргументов команды без копирования строки
+ */
+class CommandArguments {
+public:
+    /**
+     * @brief Создает разбор текста аргументов
+     * @param text Текст после имени команды
+     */
+    explicit CommandArguments(std::string_view text) : text(text) {}
+
+    /**
+     * @brief Извлекает следующее слово
+     * @param word Слово (указывает в строку команды)
+     * @return false если слов больше нет
+     */
+    bool word(std::string_view& word) {
+        skipBlanks();
+        size_t length = 0;
+        while (length < text.size() && !isBlank(text[length])) ++length;
+        if (length == 0) return false;
+        word = text.substr(0, length);
+        text.remove_prefix(length);
+        return true;
+    }
+
+    /**
+     * @brief Извлекает десятичное число без знака
+     * @param value Число
+     * @return false если следующий аргумент не начинается с числа
+     */
+    bool number(size_t& value) {
+        skipBlanks();
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (error != std::errc()) return false;
+        text.remove_prefix(static_cast<size_t>(end - text.data()));
+        return true;
+    }
+
+    /**
+     * @brief Извлекает остаток строки после пробелов
+     * @param rest Остаток (указывает в строку команды)
+     * @return false если остаток пуст
+     */
+    bool rest(std::string_view& rest) {
+        skipBlanks();
+        rest = text;
+        text = std::string_view();
+        return !rest.empty();
+    }
+
+private:
+    std::string_view text; ///< Неразобранная часть аргументов
+
+    /**
+     * @brief Пропускает пробелы в начале
+     */
+    void skipBlanks() {
+        while (!text.empty() && isBlank(text.front())) text.remove_prefix(1);
+    }
+};
+
+/**
+ * @brief Функция выполнения команды
+ * @return false если команда завершает сеанс
+ */
+using CommandHandler = bool (*)(CommandSession& session, CommandArguments& arguments);
+
+/**
+ * @brief Запись реестра команд
+ */
+struct CommandSpec {
+    std::string_view name;  ///< Имя команды
+    CommandHandler handler; ///< Обработчик
+};
+
+/**
+ * @brief Читает строку ответа на запрос команды
+ * @param session Сеанс команд
+ * @param prompt Приглашение (выводится только в интерактивном режиме)
+ * @param reply Прочитанная строка
+ * @return false если ввод закончился
+ */
+bool readReply(CommandSession& session, const char* prompt, std::string& reply) {
+    if (session.interactive) {
+        std::cout << prompt;
+    }
+    if (session.pipeline) {
+        // Replies are the lines the reader has already queued after the command
+        QueuedLine line;
+        if (!session.pipeline->next(line)) return false;
+        reply = std::move(line.text);
+        return true;
+    }
+    return static_cast<bool>(std::getline(session.input, reply));
+}
+
+/**
+ * @brief Выполняет команду над одной строкой (upper, lower, title, delete)
+ * @param arguments Аргументы: номер строки
+ * @param action Действие редактора
+ * @return true
+ */
+template <typename Action>
+bool lineCommand(CommandArguments& arguments, Action action) {
+    size_t lineNum;
+    if (!arguments.number(lineNum)) {
+        std::cout << "Error: Specify line number.\n";
+    }
+    else if (!action(lineNum)) {
+        std::cout << "Error: Invalid line number.\n";
+    }
+    return true;
+}
+
+/**
+ * @brief Разбирает значение on или off
+ * @param arguments Аргументы
+ * @param enabled Значение
+ * @return false если аргумент не on и не off (сообщение уже выведено)
+ */
+bool switchArgument(CommandArguments& arguments, bool& enabled) {
+    std::string_view mode;
+    arguments.word(mode);
+    if (mode != "on" && mode != "off") {
+        std::cout << "Error: Specify on or off.\n";
+        return false;
+    }
+    enabled = mode == "on";
+    return true;
+}
+
+/**
+ * @brief Команда new: создает новый файл
+ */
+bool commandNew(CommandSession& session, CommandArguments&) {
+    session.editor.createNewFile();
+    return true;
+}
+
+/**
+ * @brief Команда add: добавляет строку, прочитанную следующей
+ */
+bool commandAdd(CommandSession& session, CommandArguments&) {
+    std::string newLine;
+    readReply(session, "Enter line to add: ", newLine);
+    if (!newLine.empty()) {
+        session.editor.addLine(newLine);
+    }
+    return true;
+}
+
+/**
+ * @brief Команда load <path>: загружает файл
+ */
+bool commandLoad(CommandSession& session, CommandArguments& arguments) {
+    std::string_view path;
+    if (!arguments.rest(path)) {
+        std::cout << "Error: Specify file path.\n";
+    }
+    else if (!session.editor.loadFile(std::string(path))) {
+        std::cout << "Failed to load file.\n";
+    }
+    return true;
+}
+
+/**
+ * @brief Команда save: сохраняет текущий файл
+ */
+bool commandSave(CommandSession& session, CommandArguments&) {
+    if (!session.editor.saveToFile()) {
+        std::cout << "Failed to save file.\n";
+    }
+    return true;
+}
+
+/**
+ * @brief Команда saveas <path>: сохраняет документ в файл
+ */
+bool commandSaveAs(CommandSession& session, CommandArguments& arguments) {
+    std::string_view path;
+    if (!arguments.rest(path)) {
+        std::cout << "Error: Specify file path.\n";
+    }
+    else if (!session.editor.saveToFile(std::string(path))) {
+        std::cout << "Failed to save file.\n";
+    }
+    return true;
+}
+
+/**
+ * @brief Команда clear: очищает текст
+ */
+bool commandClear(CommandSession& session, CommandArguments&) {
+    session.editor.clearText();
+    return true;
+}
+
+/**
+ * @brief Команда show [from to]: выводит текст или диапазон строк
+ */
+bool commandShow(CommandSession& session, CommandArguments& arguments) {
+    size_t from, to;
+    if (!arguments.number(from)) {
+        session.editor.displayText();
+    }
+    else if (!arguments.number(to) || !session.editor.displayText(from, to)) {
+        std::cout << "Error: Specify a valid line range.\n";
+    }
+    return true;
+}
+
+/**
+ * @brief Команда page [n]: выводит следующую страницу или страницу n
+ */
+bool commandPage(CommandSession& session, CommandArguments& arguments) {
+    TextEditor& editor = session.editor;
+    size_t page;
+    if (!arguments.number(page)) page = session.nextPage;
+    size_t pages = std::max<size_t>(1, (editor.getLineCount() + kPageLines - 1) / kPageLines);
+    if (page < 1 || page > pages) {
+        std::cout << "Error: No such page (1-" << pages << ").\n";
+    }
+    else {
+        editor.displayText((page - 1) * kPageLines + 1, page * kPageLines);
+        std::cout << "-- Page " << page << " of " << pages << " --\n";
+        session.nextPage = page < pages ? page + 1 : 1;
+    }
+    return true;
+}
+
+/**
+ * @brief Команда tui [line]: полноэкранное редактирование
+ */
+bool commandTui(CommandSession& session, CommandArguments& arguments) {
+    size_t lineNumber;
+    if (!arguments.number(lineNumber)) lineNumber = 1;
+    if (!session.interactive) {
+        std::cout << "Error: Full-screen mode is not available in batch mode.\n";
+        return true;
+    }
+    RawTerminal terminal;
+    if (!terminal.isActive()) {
+        std::cout << "Error: Full-screen mode needs an interactive terminal.\n";
+    }
+    else {
+        FullScreenEditor screen(session.editor, 24, 80);
+        screen.goToLine(lineNumber);
+        screen.run(terminal);
+    }
+    return true;
+}
+
+/**
+ * @brief Команда insert <num> <text>: вставляет строку
+ */
+bool commandInsert(CommandSession& session, CommandArguments& arguments) {
+    size_t lineNum;
+    std::string_view newText;
+    if (!arguments.number(lineNum) || !arguments.rest(newText)) {
+        std::cout << "Error: Specify line number and text.\n";
+    }
+    else if (!session.editor.insertLine(lineNum, std::string(newText))) {
+        std::cout << "Error: Invalid line number.\n";
+    }
+    return true;
+}
+
+/**
+ * @brief Команда delete <num>: удаляет строку
+ */
+bool commandDelete(CommandSession& session, CommandArguments& arguments) {
+    return lineCommand(arguments, [&](size_t lineNum) { return session.editor.deleteLine(lineNum); });
+}
+
+/**
+ * @brief Команда edit <num>: заменяет строку текстом, прочитанным следующим
+ */
+bool commandEdit(CommandSession& session, CommandArguments& arguments) {
+    TextEditor& editor = session.editor;
+    size_t lineNum;
+    if (!arguments.number(lineNum)) {
+        std::cout << "Error: Specify line number.\n";
+    }
+    else if (lineNum < 1 || lineNum > editor.getLineCount()) {
+        std::cout << "Error: Invalid line number.\n";
+    }
+    else {
+        if (session.interactive) {
+            std::cout << "Current text of line " << lineNum << ": " << editor.getLine(lineNum) << "\n";
+        }
+        std::string newText;
+        readReply(session, "Enter new text: ", newText);
+        if (!newText.empty()) {
+            editor.replaceLine(lineNum, newText);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Команда replace <num> <text>: заменяет строку
+ */
+bool commandReplace(CommandSession& session, CommandArguments& arguments) {
+    size_t lineNum;
+    std::string_view newText;
+    if (!arguments.number(lineNum) || !arguments.rest(newText)) {
+        std::cout << "Error: Specify line number and new text.\n";
+    }
+    else if (!session.editor.replaceLine(lineNum, std::string(newText))) {
+        std::cout << "Error: Invalid line number.\n";
+    }
+    return true;
+}
+
+/**
+ * @brief Команда search <text>: ищет текст
+ */
+bool commandSearch(CommandSession& session, CommandArguments& arguments) {
+    std::string_view keyword;
+    if (!arguments.rest(keyword)) {
+        std::cout << "Error: Specify search text.\n";
+        return true;
+    }
+    auto results = session.editor.searchText(std::string(keyword));
+    if (results.empty()) {
+        std::cout << "Text not found.\n";
+    }
+    else {
+        std::cout << "Found in lines: ";
+        for (auto line : results) {
+            std::cout << line << " ";
+        }
+        std::cout << "\n";
+    }
+    return true;
+}
+
+/**
+ * @brief Команда filter <text>: оставляет строки с текстом
+ */
+bool commandFilter(CommandSession& session, CommandArguments& arguments) {
+    std::string_view keyword;
+    if (!arguments.rest(keyword)) {
+        std::cout << "Error: Specify filter keyword.\n";
+    }
+    else {
+        session.editor.filterLines(std::string(keyword));
+    }
+    return true;
+}
+
+/**
+ * @brief Команда encrypt: включает шифрование паролем, прочитанным следующим
+ */
+bool commandEncrypt(CommandSession& session, CommandArguments&) {
+    std::string password;
+    readReply(session, "Enter password: ", password);
+    if (session.editor.encryptFile(password)) {
+        std::cout << "File will be encrypted on save. Remember to save changes!\n";
+    }
+    return true;
+}
+
+/**
+ * @brief Команда decrypt: расшифровывает паролем, прочитанным следующим
+ */
+bool commandDecrypt(CommandSession& session, CommandArguments&) {
+    std::string password;
+    readReply(session, "Enter password: ", password);
+    if (session.editor.decryptFile(password)) {
+        std::cout << "File decrypted.\n";
+    } else {
+        std::cout << "Failed to decrypt (wrong password?)\n";
+    }
+    return true;
+}
+
+/**
+ * @brief Команда upper <num>: переводит строку в верхний регистр
+ */
+bool commandUpper(CommandSession& session, CommandArguments& arguments) {
+    return lineCommand(arguments, [&](size_t lineNum) { return session.editor.toUpperCase(lineNum); });
+}
+
+/**
+ * @brief Команда lower <num>: переводит строку в нижний регистр
+ */
+bool commandLower(CommandSession& session, CommandArguments& arguments) {
+    return lineCommand(arguments, [&](size_t lineNum) { return session.editor.toLowerCase(lineNum); });
+}
+
+/**
+ * @brief Команда title <num>: переводит строку в регистр заголовка
+ */
+bool commandTitle(CommandSession& session, CommandArguments& arguments) {
+    return lineCommand(arguments, [&](size_t lineNum) { return session.editor.toTitleCase(lineNum); });
+}
+
+/**
+ * @brief Команда allupper: переводит весь текст в верхний регистр
+ */
+bool commandAllUpper(CommandSession& session, CommandArguments&) {
+    session.editor.changeAllLinesCase(1);
+    std::cout << "All lines converted to uppercase.\n";
+    return true;
+}
+
+/**
+ * @brief Команда alllower: переводит весь текст в нижний регистр
+ */
+bool commandAllLower(CommandSession& session, CommandArguments&) {
+    session.editor.changeAllLinesCase(2);
+    std::cout << "All lines converted to lowercase.\n";
+    return true;
+}
+
+/**
+ * @brief Команда alltitle: переводит весь текст в регистр заголовка
+ */
+bool commandAllTitle(CommandSession& session, CommandArguments&) {
+    session.editor.changeAllLinesCase(3);
+    std::cout << "All lines converted to title case.\n";
+    return true;
+}
+
+/**
+ * @brief Команда undo: отменяет последнее действие
+ */
+bool commandUndo(CommandSession& session, CommandArguments&) {
+    session.editor.undo();
+    return true;
+}
+
+/**
+ * @brief Команда redo: повторяет отмененное действие
+ */
+bool commandRedo(CommandSession& session, CommandArguments&) {
+    session.editor.redo();
+    return true;
+}
+
+/**
+ * @brief Команда stats: выводит статистику
+ */
+bool commandStats(CommandSession& session, CommandArguments&) {
+    session.editor.showStats();
+    return true;
+}
+
+/**
+ * @brief Команда engine <piece|rope>: выбирает хранилище строк
+ */
+bool commandEngine(CommandSession& session, CommandArguments& arguments) {
+    std::string_view name;
+    arguments.word(name);
+    if (name == "piece") {
+        session.editor.setStorageEngine(StorageEngine::PieceTable);
+        std::cout << "Using piece table storage.\n";
+    }
+    else if (name == "rope") {
+        session.editor.setStorageEngine(StorageEngine::Rope);
+        std::cout << "Using rope storage.\n";
+    }
+    else {
+        std::cout << "Error: Specify engine (piece or rope).\n";
+    }
+    return true;
+}
+
+/**
+ * @brief Команда threads <n> [op]: задает число потоков
+ */
+bool commandThreads(CommandSession& session, CommandArguments& arguments) {
+    static const std::pair<std::string_view, BulkOperation> operations[] = {
+        {"search", BulkOperation::Search}, {"filter", BulkOperation::Filter},
+        {"case", BulkOperation::ChangeCase}, {"words", BulkOperation::WordCount},
+        {"crypto", BulkOperation::Encryption}, {"highlight", BulkOperation::Highlight}};
+    TextEditor& editor = session.editor;
+    size_t count;
+    std::string_view name;
+    if (!arguments.number(count)) {
+        std::cout << "Error: Specify thread count.\n";
+    }
+    else if (!arguments.word(name)) {
+        editor.setThreadCount(count);
+        std::cout << "Using " << editor.getThreadCount() << " thread(s).\n";
+    }
+    else {
+        auto found = std::find_if(std::begin(operations), std::end(operations),
+                                  [&](const auto& entry) { return name == entry.first; });
+        if (found == std::end(operations)) {
+            std::cout << "Error: Unknown operation (search, filter, case, words, crypto or highlight).\n";
+        }
+        else {
+            editor.setThreadCount(found->second, count);
+            std::cout << "Using " << editor.getThreadCount(found->second) << " thread(s) for " << name << ".\n";
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Команда index <on|off>: переключает индекс слов
+ */
+bool commandIndex(CommandSession& session, CommandArguments& arguments) {
+    bool enabled;
+    if (switchArgument(arguments, enabled)) {
+        session.editor.setWordIndexEnabled(enabled);
+        std::cout << "Word index " << (enabled ? "enabled" : "disabled") << ".\n";
+    }
+    return true;
+}
+
+/**
+ * @brief Команда trigrams <on|off>: переключает индекс триграмм
+ */
+bool commandTrigrams(CommandSession& session, CommandArguments& arguments) {
+    bool enabled;
+    if (switchArgument(arguments, enabled)) {
+        session.editor.setTrigramIndexEnabled(enabled);
+        std::cout << "Trigram index " << (session.editor.isTrigramIndexEnabled() ? "enabled" : "disabled") << ".\n";
+    }
+    return true;
+}
+
+/**
+ * @brief Команда highlight <on|off>: переключает подсветку синтаксиса
+ */
+bool commandHighlight(CommandSession& session, CommandArguments& arguments) {
+    bool enabled;
+    if (switchArgument(arguments, enabled)) {
+        session.editor.setSyntaxHighlightEnabled(enabled);
+        std::cout << "Syntax highlighting " << (enabled ? "enabled" : "disabled") << ".\n";
+    }
+    return true;
+}
+
+/**
+ * @brief Команда exit: завершает сеанс (интерактивный - с подтверждением)
+ */
+bool commandExit(CommandSession& session, CommandArguments&) {
+    if (session.interactive && session.editor.hasUnsavedChanges()) {
+        std::string choice;
+        readReply(session, "You have unsaved changes. Exit without saving? (y/n): ", choice);
+        if (choice != "y" && choice != "Y") return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Команда help: выводит справку
+ */
+bool commandHelp(CommandSession&, CommandArguments&) {
+    showHelp();
+    return true;
+}
+
+/// Реестр команд
+constexpr std::array<CommandSpec, 33> kCommands = {{
+    {"new", commandNew}, {"add", commandAdd}, {"load", commandLoad}, {"save", commandSave},
+    {"saveas", commandSaveAs}, {"clear", commandClear}, {"show", commandShow}, {"page", commandPage},
+    {"tui", commandTui}, {"insert", commandInsert}, {"delete", commandDelete}, {"edit", commandEdit},
+    {"replace", commandReplace}, {"search", commandSearch}, {"filter", commandFilter},
+    {"encrypt", commandEncrypt}, {"decrypt", commandDecrypt}, {"upper", commandUpper},
+    {"lower", commandLower}, {"title", commandTitle}, {"allupper", commandAllUpper},
+    {"alllower", commandAllLower}, {"alltitle", commandAllTitle}, {"undo", commandUndo},
+    {"redo", commandRedo}, {"stats", commandStats}, {"engine", commandEngine},
+    {"threads", commandThreads}, {"index", commandIndex}, {"trigrams", commandTrigrams},
+    {"highlight", commandHighlight}, {"exit", commandExit}, {"help", commandHelp}}};
+
+/**
+ * @brief Выбирает имена команд реестра
+ * @param commands Реестр
+ * @return Имена в порядке реестра
+ */
+template <size_t N>
+constexpr std::array<std::string_view, N> commandNames(const std::array<CommandSpec, N>& commands) {
+    std::array<std::string_view, N> names{};
+    for (size_t i = 0; i < N; ++i) names[i] = commands[i].name;
+    return names;
+}
+
+/// Совершенная хеш-таблица имен команд; номер слова - индекс в kCommands
+constexpr auto kCommandTable = makeKeywordTable<8>(commandNames(kCommands));
+
+/**
+ * @brief Находит команду строки
+ * @param line Строка команды
+ * @param argumentsAt Смещение текста после имени команды
+ * @return Номер команды в kCommands, kBlankLine или -1 для неизвестной команды
+ */
+int parseCommand(std::string_view line, size_t& argumentsAt) {
+    size_t start = 0;
+    while (start < line.size() && isBlank(line[start])) ++start;
+    size_t end = start;
+    while (end < line.size() && !isBlank(line[end])) ++end;
+    argumentsAt = end;
+    // Blank lines and '#' comments let scripts be annotated
+    if (start == end || line[start] == '#') return kBlankLine;
+    return kCommandTable.find(line.substr(start, end - start));
+}
+
+/// Номер команды exit, после которой поток чтения ждет, а не читает дальше
+constexpr int kExitCommand = kCommandTable.find("exit");
+static_assert(kExitCommand >= 0, "exit must be registered");
+
+/**
+ * @brief Выполняет разобранную команду
+ * @param session Сеанс команд
+ * @param line Строка команды
+ * @param command Номер команды (см. parseCommand)
+ * @param argumentsAt Смещение аргументов
+ * @return false если команда завершает сеанс
+ */
+bool dispatch(CommandSession& session, std::string_view line, int command, size_t argumentsAt) {
+    if (command == kBlankLine) return true;
+    if (command < 0) {
+        std::cout << "Unknown command. Type 'help' for command list.\n";
+        return true;
+    }
+    CommandArguments arguments(line.substr(argumentsAt));
+    return kCommands[static_cast<size_t>(command)].handler(session, arguments);
+}
+
+} // namespace
+
+/**
+ * @brief Запускает поток чтения
+ * @param input Источник строк
+ */
+CommandPipeline::CommandPipeline(std::istream& input)
+    : input(input), stopping(false), requested(0), taken(0), finished(false),
+      reader(&CommandPipeline::readLoop, this) {}
+
+/**
+ * @brief Останавливает поток чтения после текущей строки и дожидается его
+ */
+CommandPipeline::~CommandPipeline() {
+    stopping.store(true, std::memory_order_relaxed);
+    reader.join();
+}
+
+/**
+ * @brief Извлекает следующую строку, дожидаясь ее
+ * @param line Строка
+ * @return false если ввод закончился
+ */
+bool CommandPipeline::next(QueuedLine& line) {
+    if (finished) return false;
+    requested.store(++taken, std::memory_order_relaxed);
+    for (unsigned spins = 0; !queue.tryPop(line);) {
+        backoff(spins);
+    }
+    finished = line.end;
+    return !finished;
+}
+
+/**
+ * @brief Цикл потока чтения
+ */
+void CommandPipeline::readLoop() {
+    QueuedLine line;
+    size_t pushed = 0;
+    while (!stopping.load(std::memory_order_relaxed)) {
+        line.end = !std::getline(input, line.text);
+        if (line.end) {
+            line.text.clear();
+        } else {
+            line.command = parseCommand(line.text, line.argumentsAt);
+        }
+        const bool end = line.end;
+        const bool exit = !end && line.command == kExitCommand;
+        for (unsigned spins = 0; !queue.tryPush(line);) {
+            if (stopping.load(std::memory_order_relaxed)) return;
+            backoff(spins);
+        }
+        ++pushed;
+        if (end) return;
+
+        // Past exit the input may stay open without more lines; read on only if
+        // the executor took exit as a reply and asks for the line after it
+        for (unsigned spins = 0; exit && requested.load(std::memory_order_relaxed) <= pushed;) {
+            if (stopping.load(std::memory_order_relaxed)) return;
+            backoff(spins);
+        }
+    }
+}
+
+/**
+ * @brief Отображает справочную информацию по командам
+ */
+void showHelp() {
+    std::cout << "Commands:\n"
+              << "  new             - Create new file\n"
+              << "  load <path>     - Load file\n"
+              << "  save            - Save to current file\n"
+              << "  saveas <path>   - Save as...\n"
+              << "  encrypt         - Encrypt file when saving\n"
+              << "  decrypt         - Open encrypted file or stop encrypting\n"
+              << "  clear           - Clear text\n"
+              << "  show [from to]  - Show text or a range of lines\n"
+              << "  page [n]        - Show next page or page n\n"
+              << "  tui [line]      - Full-screen editing (^S save, ^Z undo, ^Y redo, ^Q quit)\n"
+              << "  add             - Add line\n"
+              << "  insert <num> <text> - Insert line before line number\n"
+              << "  delete <num>    - Delete line by number\n"
+              << "  edit <num>      - Edit specific line\n"
+              << "  replace <num> <text> - Replace line\n"
+              << "  search <text>   - Search text\n"
+              << "  filter <text>   - Keep lines containing text\n"
+              << "  upper <num>     - Convert line to uppercase\n"
+              << "  lower <num>     - Convert line to lowercase\n"
+              << "  title <num>     - Convert line to title case\n"
+              << "  allupper        - Convert all lines to uppercase\n"
+              << "  alllower        - Convert all lines to lowercase\n"
+              << "  alltitle        - Convert all lines to title case\n"
+              << "  undo            - Undo last action\n"
+              << "  redo            - Redo undone action\n"
+              << "  stats           - Show text statistics\n"
+              << "  engine <piece|rope> - Select line storage engine\n"
+              << "  threads <n> [op] - Set worker thread count (0 = all cores / default),\n"
+              << "                    op: search, filter, case, words, crypto, highlight\n"
+              << "  index <on|off>  - Toggle word index for search\n"
+              << "  trigrams <on|off> - Toggle trigram index for filter\n"
+              << "  highlight <on|off> - Toggle syntax highlighting in show\n"
+              << "  exit            - Exit\n"
+              << "  help            - Show this help\n";
+}
+
+/**
+ * @brief Выполняет одну команду
+ * @param session Сеанс команд
+ * @param command Строка команды
+ * @return false если команда завершает сеанс (exit)
+ */
+bool executeCommand(CommandSession& session, const std::string& command) {
+    size_t argumentsAt;
+    int index = parseCommand(command, argumentsAt);
+    return dispatch(session, command, index, argumentsAt);
+}
+
+/**
+ * @brief Выполняет команды из потока ввода сеанса до команды exit или конца ввода
+ * @param session Сеанс команд
+ */
+void runCommands(CommandSession& session) {
+    if (session.interactive) {
+        std::string command;
+        while (true) {
+            std::cout << "> ";
+            if (!std::getline(session.input, command)) break;
+            if (!executeCommand(session, command)) break;
+        }
+        return;
+    }
+
+    // Without prompts the next lines are read and parsed while this one runs
+    CommandPipeline pipeline(session.input);
+    session.pipeline = &pipeline;
+    QueuedLine line;
+    while (pipeline.next(line) && dispatch(session, line.text, line.command, line.argumentsAt)) {
+    }
+    session.pipeline = nullptr;
+}
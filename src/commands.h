@@ -0,0 +1,56 @@
+#ifndef COMMANDS_H
+#define COMMANDS_H
+
+#include <cstddef>
+#include <istream>
+#include <string>
+#include "editor.h"
+
+class CommandPipeline;
+
+/**
+ * @brief Сеанс выполнения команд редактора
+ *
+ * Интерактивный сеанс выводит приглашения и подтверждает выход с
+ * несохраненными изменениями. Пакетный сеанс (text_editor --script) читает
+ * команды и ответы на их запросы (add, edit, пароли) из сценария и ничего
+ * не спрашивает.
+ *
+ * Имя команды находится в реестре совершенной хеш-таблицей (KeywordTable),
+ * аргументы разбираются на месте в строке без копирования. В пакетном
+ * сеансе строки читает и разбирает отдельный поток, передавая их через
+ * очередь без блокировок, пока редактор выполняет предыдущие команды.
+ */
+struct CommandSession {
+    TextEditor& editor;     ///< Редактор, к которому применяются команды
+    std::istream& input;    ///< Источник команд и ответов на запросы
+    bool interactive;       ///< Выводить приглашения и запросы
+    size_t nextPage = 1;    ///< Страница, которую покажет команда page без номера
+    CommandPipeline* pipeline = nullptr; ///< Опережающее чтение во время пакетного runCommands
+};
+
+/**
+ * @brief Отображает справочную информацию по командам
+ */
+void showHelp();
+
+/**
+ * @brief Выполняет одну команду
+ * @param session Сеанс команд
+ * @param command Строка команды (пустые строки и строки с '#' пропускаются)
+ * @return false если команда завершает сеанс (exit)
+ */
+bool executeCommand(CommandSession& session, const std::string& command);
+
+/**
+ * @brief Выполняет команды из потока ввода сеанса до команды exit или конца ввода
+ *
+ * Пакетный сеанс читает ввод с опережением, но не дальше строки exit:
+ * функция возвращается и тогда, когда ввод (канал) после exit остается
+ * открытым. Поток чтения завершается до возврата и не переживает поток ввода.
+ *
+ * @param session Сеанс команд
+ */
+void runCommands(CommandSession& session);
+
+#endif // COMMANDS_H
@@ -0,0 +1,44 @@
+#include "cpu_features.h"
+
+namespace {
+
+/**
+ * @brief Определяет лучший доступный набор инструкций
+ * @return Набор инструкций
+ */
+InstructionSet detectInstructionSet() {
+#if defined(CPU_FEATURES_X86)
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return InstructionSet::Avx2;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] >= 7) {
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        __cpuidex(info, 7, 0);
+        bool avx2 = (info[1] & (1 << 5)) != 0;
+        if (osxsave && avx && avx2 && (_xgetbv(0) & 0x6) == 0x6) return InstructionSet::Avx2;
+    }
+#endif
+    return InstructionSet::Sse2;
+#else
+    return InstructionSet::Scalar;
+#endif
+}
+
+} // namespace
+
+/**
+ * @brief Возвращает лучший доступный набор инструкций
+ *
+ * Процессор опрашивается один раз при первом вызове.
+ *
+ * @return Набор инструкций
+ */
+InstructionSet instructionSet() {
+    static const InstructionSet detected = detectInstructionSet();
+    return detected;
+}
@@ -0,0 +1,37 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+/**
+ * @file cpu_features.h
+ * @brief Определение набора векторных инструкций для выбора реализации ядер
+ */
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define CPU_FEATURES_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define CPU_TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#else
+#define CPU_TARGET_AVX2
+#endif
+
+/**
+ * @brief Набор инструкций, используемый ядрами
+ */
+enum class InstructionSet { Scalar, Sse2, Avx2 };
+
+/**
+ * @brief Возвращает лучший доступный набор инструкций
+ *
+ * Процессор опрашивается один раз при первом вызове.
+ *
+ * @return Набор инструкций
+ */
+InstructionSet instructionSet();
+
+#endif // CPU_FEATURES_H
@@ -1,18 +1,99 @@
 
 #include "editor.h"
+#include "poly1305.h"
+#include "text_kernels.h"
 #include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
 #include <cstring>
 #include <locale>
+#include <thread>
+
+namespace {
+
+/// Документы меньшего размера (в байтах) обрабатываются в одном потоке
+constexpr size_t kParallelThreshold = 1 << 20;
+
+/// Минимальное количество строк в части при параллельной обработке
+constexpr size_t kMinLinesPerShard = 4096;
+
+/**
+ * @brief Подсчитывает слова в наборе строк
+ * @param lines Строки
+ * @return Количество слов
+ */
+size_t countWords(const std::vector<std::string>& lines) {
+    size_t count = 0;
+    for (const auto& line : lines) {
+        count += ::countWords(line.data(), line.size());
+    }
+    return count;
+}
+
+/**
+ * @brief Проверяет, содержит ли строка ключевое слово целым словом
+ * @param line Строка
+ * @param keyword Подготовленный поиск слова
+ * @return true если найдено вхождение с границами слова с обеих сторон
+ */
+bool containsWord(std::string_view line, const SubstringSearcher& keyword) {
+    size_t pos = 0;
+    while ((pos = keyword.find(line, pos)) != SubstringSearcher::npos) {
+        // Check word boundaries
+        bool startBoundary = (pos == 0) || !std::isalnum(static_cast<unsigned char>(line[pos-1]));
+        bool endBoundary = (pos + keyword.size() == line.length()) ||
+                          !std::isalnum(static_cast<unsigned char>(line[pos + keyword.size()]));
+
+        if (startBoundary && endBoundary) {
+            return true;
+        }
+        pos += keyword.size();
+    }
+    return false;
+}
+
+/**
+ * @brief Копирует документ в хранилище другого механизма
+ * @param source Документ
+ * @param engine Механизм хранения копии
+ * @return Копия документа одним блоком
+ */
+std::unique_ptr<TextStorage> copyStorage(const TextStorage& source, StorageEngine engine) {
+    std::string text;
+    std::vector<LineSpan> spans;
+    text.reserve(source.byteCount());
+    spans.reserve(source.lineCount());
+    source.forEachLine(0, source.lineCount(), [&](size_t, std::string_view line) {
+        spans.push_back({text.size(), line.size()});
+        text.append(line.data(), line.size());
+    });
+
+    std::unique_ptr<TextStorage> storage = makeTextStorage(engine);
+    storage->assign(std::move(text), std::move(spans));
+    return storage;
+}
+
+} // namespace
+
 /**
  * @brief Конструктор по умолчанию
  *
  * Инициализирует редактор без несохраненных изменений.
  */
-TextEditor::TextEditor() : unsavedChanges(false) {}
+TextEditor::TextEditor()
+    : buffer(makeTextStorage(StorageEngine::PieceTable)),
+      storageEngine(StorageEngine::PieceTable),
+      unsavedChanges(false),
+      wordCount(0),
+      threadCount(0),
+      operationThreads{},
+      wordIndexEnabled(false),
+      trigramIndexEnabled(false),
+      highlightEnabled(false),
+      renderTime(0) {}
 
 /**
  * @brief Деструктор
@@ -42,49 +123,225 @@ void TextEditor::clearPassword() {
 }
 
 /**
- * @brief Генерирует ключ шифрования на основе пароля
- * @param password Пароль для шифрования
- * @param length Требуемая длина ключа
- * @return Сгенерированный ключ
+ * @brief Заменяет диапазон строк, записывая в журнал только затронутые строки
+ * @param first Индекс первой заменяемой строки
+ * @param count Количество заменяемых строк
+ * @param newLines Новые строки
+ */
+void TextEditor::editLines(size_t first, size_t count, std::vector<std::string> newLines) {
+    EditHunk hunk;
+    hunk.first = first;
+    hunk.before.reserve(count);
+    buffer->forEachLine(first, first + count, [&](size_t, std::string_view line) {
+        hunk.before.emplace_back(line);
+    });
+    buffer->replaceLines(first, count, newLines);
+    hunk.after = std::move(newLines);
+    noteLinesReplaced(first, hunk.before, hunk.after);
+
+    EditRecord record;
+    record.hunks.push_back(std::move(hunk));
+    commitEdit(std::move(record));
+}
+
+/**
+ * @brief Заменяет документ целиком; прежний документ перемещается в журнал без копирования
+ * @param document Новый документ
+ * @param words Количество слов нового документа, если уже известно
  */
-std::string TextEditor::deriveKey(const std::string& password, size_t length) const {
-    std::string key;
-    size_t pwdLen = password.length();
-    if (pwdLen == 0) return key;
+void TextEditor::replaceDocument(std::unique_ptr<TextStorage> document, std::optional<size_t> words) {
+    EditRecord record;
+    record.document = std::move(buffer);
+    record.documentWords = wordCount;
+    buffer = std::move(document);
+    wordCount = words ? *words : countDocumentWords();
+    invalidateIndexes();
+    commitEdit(std::move(record));
+}
+
+/**
+ * @brief Заменяет документ целиком новым набором строк
+ * @param lines Строки нового документа
+ */
+void TextEditor::replaceDocumentLines(const std::vector<std::string>& lines) {
+    std::unique_ptr<TextStorage> document = makeTextStorage(storageEngine);
+    document->assignLines(lines);
+    replaceDocument(std::move(document));
+}
 
-    for (size_t i = 0; key.size() < length; ++i) {
-        key += std::to_string(pwdLen * (i + 1)) + password;
+/**
+ * @brief Копирует документ в один новый блок, преобразуя строки на месте
+ *
+ * Первый проход определяет размер частей, второй копирует их и вызывает
+ * преобразование; большие документы обрабатываются частями на пуле потоков.
+ *
+ * @param transform Преобразование диапазона строк внутри нового блока
+ * @param operation Операция, задающая число потоков
+ * @return Новый документ с той же разбивкой на строки
+ */
+std::unique_ptr<TextStorage> TextEditor::rewriteDocument(const LineRangeTransform& transform,
+                                                         BulkOperation operation) const {
+    const size_t total = buffer->lineCount();
+    const size_t grain = linesPerShard(operation);
+    auto forEachShard = [&](const ThreadPool::RangeTask& fn) {
+        parallelForLines(operation, 0, total, grain, fn);
+    };
+
+    std::vector<size_t> shardOffsets((total + grain - 1) / grain + 1, 0);
+    forEachShard([&](size_t from, size_t to) {
+        size_t bytes = 0;
+        buffer->forEachLine(from, to, [&](size_t, std::string_view line) {
+            bytes += line.size() + 1;
+        });
+        shardOffsets[from / grain + 1] = bytes;
+    });
+    for (size_t i = 1; i < shardOffsets.size(); ++i) {
+        shardOffsets[i] += shardOffsets[i - 1];
     }
-    key.resize(length);
-    return key;
+
+    const size_t size = shardOffsets.back();
+    std::shared_ptr<char> text(new char[size], std::default_delete<char[]>());
+    std::vector<LineSpan> spans(total);
+    forEachShard([&](size_t from, size_t to) {
+        char* out = text.get() + shardOffsets[from / grain];
+        buffer->forEachLine(from, to, [&](size_t i, std::string_view line) {
+            std::memcpy(out, line.data(), line.size());
+            spans[i] = {static_cast<size_t>(out - text.get()), line.size()};
+            out += line.size();
+            *out++ = '\n';
+        });
+        transform(from, to, text.get(), spans);
+    });
+
+    TextBlock block;
+    block.bytes = std::string_view(text.get(), size);
+    block.owner = std::move(text);
+    std::unique_ptr<TextStorage> document = makeTextStorage(storageEngine);
+    document->assignBlock(std::move(block), std::move(spans));
+    return document;
 }
 
 /**
- * @brief Выполняет операцию XOR-шифрования
- * @param data Данные для шифрования/расшифровки
- * @param key Ключ шифрования
- * @return Результат шифрования
+ * @brief Подсчитывает слова во всем документе (частями на пуле потоков)
+ * @return Количество слов
  */
-std::string TextEditor::xorCrypt(const std::string& data, const std::string& key) const {
-    if (key.empty()) return data;
+size_t TextEditor::countDocumentWords() const {
+    std::atomic<size_t> count{0};
+    parallelForLines(BulkOperation::WordCount, 0, buffer->lineCount(),
+                     linesPerShard(BulkOperation::WordCount), [&](size_t from, size_t to) {
+        size_t words = 0;
+        buffer->forEachLine(from, to, [&](size_t, std::string_view line) {
+            words += ::countWords(line.data(), line.size());
+        });
+        count += words;
+    });
+    return count.load();
+}
+
+/**
+ * @brief Добавляет запись в журнал отмены и очищает журнал повтора
+ * @param record Запись журнала
+ */
+void TextEditor::commitEdit(EditRecord record) {
+    // decrypt after an edit refers to the edited document, not to an earlier failed load
+    pendingEncryptedPath.clear();
+    undoStack.push(std::move(record));
+    redoStack = std::stack<EditRecord>();
+}
 
-    std::string result = data;
-    for (size_t i = 0; i < data.size(); ++i) {
-        result[i] = data[i] ^ key[i % key.size()];
+/**
+ * @brief Применяет запись журнала в прямом или обратном направлении
+ * @param record Запись журнала (при замене документа обменивается с текущим)
+ * @param forward true для повтора, false для отмены
+ */
+void TextEditor::applyRecord(EditRecord& record, bool forward) {
+    pendingEncryptedPath.clear();
+    if (record.document) {
+        std::swap(buffer, record.document);
+        std::swap(wordCount, record.documentWords);
+        invalidateIndexes();
+        return;
     }
-    return result;
+    if (forward) {
+        for (const auto& hunk : record.hunks) {
+            buffer->replaceLines(hunk.first, hunk.before.size(), hunk.after);
+            noteLinesReplaced(hunk.first, hunk.before, hunk.after);
+        }
+    } else {
+        for (auto it = record.hunks.rbegin(); it != record.hunks.rend(); ++it) {
+            buffer->replaceLines(it->first, it->after.size(), it->before);
+            noteLinesReplaced(it->first, it->after, it->before);
+        }
+    }
+}
+
+/**
+ * @brief Учитывает замену диапазона строк в статистике и индексах поиска
+ * @param first Индекс первой замененной строки
+ * @param removed Строки, бывшие в диапазоне до замены
+ * @param added Строки, занявшие диапазон после замены
+ */
+void TextEditor::noteLinesReplaced(size_t first, const std::vector<std::string>& removed,
+                                   const std::vector<std::string>& added) {
+    wordCount = wordCount - countWords(removed) + countWords(added);
+    wordIndex.update(first, removed, added);
+    trigramIndex.update(first, removed, added);
+    highlighter.update(first, removed.size(), added.size());
 }
 
 /**
- * @brief Сохраняет текущее состояние текста в стек отмены
+ * @brief Сбрасывает индексы поиска и разметку подсветки после замены документа целиком
  */
-void TextEditor::saveState() {
-    undoStack.push(lines);
-    redoStack = std::stack<std::vector<std::string>>();
+void TextEditor::invalidateIndexes() {
+    wordIndex.invalidate();
+    trigramIndex.invalidate();
+    highlighter.invalidate();
 }
 
 /**
- * @brief Шифрует текущий текст с использованием пароля
+ * @brief Строит полную разметку подсветки, если она не построена
+ */
+void TextEditor::buildHighlight() const {
+    if (highlighter.isValid()) return;
+    // Shards guess a normal start state; refresh() fixes up the shard boundaries
+    highlighter.reset(buffer->lineCount());
+    parallelForLines(BulkOperation::Highlight, 0, buffer->lineCount(),
+                     linesPerShard(BulkOperation::Highlight), [&](size_t from, size_t to) {
+        highlighter.lexLines(*buffer, from, to);
+    });
+}
+
+/**
+ * @brief Готовит лексемы подсветки строк [first, last)
+ * @param first Первая строка
+ * @param last Строка за последней
+ */
+void TextEditor::ensureHighlight(size_t first, size_t last) const {
+    if (last - first > SyntaxHighlighter::kCacheLines) {
+        buildHighlight();
+    }
+    highlighter.prepare(*buffer, first, last);
+}
+
+/**
+ * @brief Строит индекс триграмм, если он включен и еще не построен
+ * @return true если индекс готов к использованию
+ */
+bool TextEditor::ensureTrigramIndex() {
+    if (!trigramIndexEnabled) return false;
+    if (trigramIndex.isValid() || trigramIndex.build(*buffer)) return true;
+
+    std::cerr << "Warning: Trigram index exceeds memory limit, using linear scan\n";
+    trigramIndexEnabled = false;
+    return false;
+}
+
+/**
+ * @brief Включает шифрование файла паролем
+ *
+ * Документ в памяти не изменяется: сохранение записывает его в зашифрованный
+ * файл, пока пароль не будет очищен.
+ *
  * @param password Пароль для шифрования
  * @return true при успешном шифровании, false при ошибке
  */
@@ -94,25 +351,19 @@ bool TextEditor::encryptFile(const std::string& password) {
         return false;
     }
 
-    saveState();
     tempPassword = password;
-
-    try {
-        for (auto& line : lines) {
-            std::string key = deriveKey(password, line.size());
-            line = xorCrypt(line, key);
-        }
-        unsavedChanges = true;
-        return true;
-    } catch (const std::exception& e) {
-        std::cerr << "Encryption error: " << e.what() << "\n";
-        undo();
-        return false;
-    }
+    pendingEncryptedPath.clear();
+    unsavedChanges = true;
+    return true;
 }
 
 /**
- * @brief Расшифровывает текущий текст с использованием пароля
+ * @brief Расшифровывает файл с использованием пароля
+ *
+ * Если загружаемый файл оказался зашифрованным, он открывается с этим
+ * паролем. Иначе шифрование текущего документа отключается, если пароль
+ * совпадает с паролем шифрования.
+ *
  * @param password Пароль для расшифровки
  * @return true при успешной расшифровке, false при ошибке
  */
@@ -122,52 +373,45 @@ bool TextEditor::decryptFile(const std::string& password) {
         return false;
     }
 
-    std::vector<std::string> backup = lines;
-    saveState();
-    tempPassword = password;
-
-    try {
-        // First pass - attempt decryption
-        for (auto& line : lines) {
-            std::string key = deriveKey(password, line.size());
-            line = xorCrypt(line, key);
-        }
-
-        // Second pass - verify result
-        bool allPrintable = true;
-        for (const auto& line : lines) {
-            for (char c : line) {
-                if (!std::isprint(static_cast<unsigned char>(c))) {
-                    allPrintable = false;
-                    break;
-                }
-            }
-            if (!allPrintable) break;
-        }
-
-        if (allPrintable) {
-            unsavedChanges = true;
-            return true;
-        }
+    if (!pendingEncryptedPath.empty()) {
+        // openDocument clears the pending path; a wrong password keeps it for another try
+        const std::string path = pendingEncryptedPath;
+        return loadEncryptedFile(path, password);
+    }
 
-        // Restore backup if decryption failed
-        lines = backup;
-        return false;
-    } catch (...) {
-        lines = backup;
+    if (tempPassword.empty() || tempPassword.size() != password.size() ||
+        !constantTimeEqual(reinterpret_cast<const uint8_t*>(tempPassword.data()),
+                           reinterpret_cast<const uint8_t*>(password.data()), password.size())) {
         return false;
     }
+    clearPassword();
+    unsavedChanges = true;
+    return true;
 }
 
-
 /**
  * @brief Добавляет новую строку в конец текста
  * @param line Текст добавляемой строки
  */
 void TextEditor::addLine(const std::string& line) {
-    saveState();
-    lines.push_back(line);
+    editLines(buffer->lineCount(), 0, {line});
+    unsavedChanges = true;
+}
+
+/**
+ * @brief Вставляет строку перед указанной позицией
+ * @param lineNumber Номер, который получит новая строка (от 1 до количества строк + 1)
+ * @param line Текст вставляемой строки
+ * @return true при успешной вставке, false при неверном номере
+ */
+bool TextEditor::insertLine(size_t lineNumber, const std::string& line) {
+    if (lineNumber < 1 || lineNumber > buffer->lineCount() + 1) {
+        std::cerr << "Error: Invalid line number\n";
+        return false;
+    }
+    editLines(lineNumber - 1, 0, {line});
     unsavedChanges = true;
+    return true;
 }
 
 /**
@@ -176,12 +420,11 @@ void TextEditor::addLine(const std::string& line) {
  * @return true при успешном удалении, false при неверном номере
  */
 bool TextEditor::deleteLine(size_t lineNumber) {
-    if (lineNumber < 1 || lineNumber > lines.size()) {
+    if (lineNumber < 1 || lineNumber > buffer->lineCount()) {
         std::cerr << "Error: Invalid line number\n";
         return false;
     }
-    saveState();
-    lines.erase(lines.begin() + lineNumber - 1);
+    editLines(lineNumber - 1, 1, {});
     unsavedChanges = true;
     return true;
 }
@@ -193,12 +436,11 @@ bool TextEditor::deleteLine(size_t lineNumber) {
  * @return true при успешной замене, false при неверном номере
  */
 bool TextEditor::replaceLine(size_t lineNumber, const std::string& newLine) {
-    if (lineNumber < 1 || lineNumber > lines.size()) {
+    if (lineNumber < 1 || lineNumber > buffer->lineCount()) {
         std::cerr << "Error: Invalid line number\n";
         return false;
     }
-    saveState();
-    lines[lineNumber - 1] = newLine;
+    editLines(lineNumber - 1, 1, {newLine});
     unsavedChanges = true;
     return true;
 }
@@ -212,116 +454,133 @@ std::vector<size_t> TextEditor::searchText(const std::string& keyword) const {
     std::vector<size_t> matches;
     if (keyword.empty()) return matches;
 
-    for (size_t i = 0; i < lines.size(); ++i) {
-        size_t pos = 0;
-        while ((pos = lines[i].find(keyword, pos)) != std::string::npos) {
-            // Check word boundaries
-            bool startBoundary = (pos == 0) || !std::isalnum(lines[i][pos-1]);
-            bool endBoundary = (pos + keyword.length() == lines[i].length()) ||
-                              !std::isalnum(lines[i][pos + keyword.length()]);
+    if (wordIndexEnabled && WordIndex::canAnswer(keyword)) {
+        if (wordIndex.isValid() || wordIndex.build(*buffer)) {
+            matches = wordIndex.find(keyword);
+            for (auto& line : matches) {
+                ++line;
+            }
+            return matches;
+        }
+    }
 
-            if (startBoundary && endBoundary) {
+    const SubstringSearcher searcher(keyword);
+    if (trigramIndex.isValid() && TrigramIndex::canNarrow(keyword)) {
+        for (size_t i : trigramIndex.candidates(keyword)) {
+            if (containsWord(buffer->line(i), searcher)) {
                 matches.push_back(i + 1);
-                break; // Only count one match per line
             }
-            pos += keyword.length();
         }
+        return matches;
+    }
+
+    // Each shard collects its own matches; shards are concatenated in order
+    const size_t total = buffer->lineCount();
+    const size_t grain = linesPerShard(BulkOperation::Search);
+    std::vector<std::vector<size_t>> shards((total + grain - 1) / grain);
+    parallelForLines(BulkOperation::Search, 0, total, grain, [&](size_t from, size_t to) {
+        std::vector<size_t>& found = shards[from / grain];
+        buffer->forEachLine(from, to, [&](size_t i, std::string_view line) {
+            if (containsWord(line, searcher)) {
+                found.push_back(i + 1);
+            }
+        });
+    });
+
+    size_t count = 0;
+    for (const auto& shard : shards) {
+        count += shard.size();
+    }
+    matches.reserve(count);
+    for (const auto& shard : shards) {
+        matches.insert(matches.end(), shard.begin(), shard.end());
     }
     return matches;
 }
 
 /**
- * @brief Подсвечивает синтаксис в тексте (экспериментальная функция)
+ * @brief Включает подсветку синтаксиса и размечает весь документ
  */
 void TextEditor::highlightSyntax() {
-    for (auto& line : lines) {
-        size_t pos = line.find("for");
-        if (pos != std::string::npos) {
-            // Check if it's a whole word
-            bool startOk = (pos == 0) || !std::isalnum(line[pos-1]);
-            bool endOk = (pos + 3 == line.length()) || !std::isalnum(line[pos + 3]);
-            if (startOk && endOk) {
-                line.replace(pos, 3, "\033[1;32mfor\033[0m");
-            }
-        }
+    highlightEnabled = true;
+    buildHighlight();
+    highlighter.refresh(*buffer, buffer->lineCount());
+}
+
+/**
+ * @brief Включает или выключает подсветку синтаксиса при выводе текста
+ * @param enabled true чтобы выводить текст с подсветкой
+ */
+void TextEditor::setSyntaxHighlightEnabled(bool enabled) {
+    highlightEnabled = enabled;
+    if (!enabled) {
+        highlighter.invalidate();
     }
 }
 
 /**
- * @brief Преобразует строку в верхний регистр
- * @param str Исходная строка
- * @return Строка в верхнем регистре
+ * @brief Проверяет, включена ли подсветка синтаксиса
+ * @return true если подсветка включена
  */
-std::string TextEditor::toUpper(const std::string& str) const {
-    std::string result = str;
-    std::transform(result.begin(), result.end(), result.begin(),
-        [](unsigned char c){ return std::toupper(c); });
-    return result;
+bool TextEditor::isSyntaxHighlightEnabled() const {
+    return highlightEnabled;
 }
 
 /**
- * @brief Преобразует строку в нижний регистр
- * @param str Исходная строка
- * @return Строка в нижнем регистре
+ * @brief Возвращает язык подсветки, определенный по расширению текущего файла
+ * @return Язык
  */
-std::string TextEditor::toLower(const std::string& str) const {
-    std::string result = str;
-    std::transform(result.begin(), result.end(), result.begin(),
-        [](unsigned char c){ return std::tolower(c); });
-    return result;
+Language TextEditor::getSyntaxLanguage() const {
+    return highlighter.getLanguage();
 }
 
 /**
- * @brief Преобразует строку в регистр заголовка
- * @param str Исходная строка
- * @return Строка в регистре заголовка
+ * @brief Возвращает лексемы подсветки строки
+ * @param lineNumber Номер строки (начиная с 1)
+ * @return Лексемы строки или пустой вектор при неверном номере или выключенной подсветке
  */
-std::string TextEditor::toTitle(const std::string& str) const {
-    std::string result = str;
-    bool newWord = true;
-    for (char& c : result) {
-        if (newWord && std::isalpha(c)) {
-            c = std::toupper(c);
-            newWord = false;
-        } else if (std::isspace(c)) {
-            newWord = true;
-        } else {
-            c = std::tolower(c);
-        }
+std::vector<TokenSpan> TextEditor::getLineTokens(size_t lineNumber) const {
+    if (!highlightEnabled || lineNumber < 1 || lineNumber > buffer->lineCount()) {
+        return {};
     }
-    return result;
+    ensureHighlight(lineNumber - 1, lineNumber);
+    return highlighter.tokens(lineNumber - 1);
 }
 
 /**
- * @brief Конвертирует строку в верхний регистр
+ * @brief Преобразует регистр одной строки с записью в журнал отмены
  * @param lineNumber Номер строки (начиная с 1)
+ * @param mode Вид преобразования
  * @return true при успешном изменении, false при неверном номере
  */
-bool TextEditor::toUpperCase(size_t lineNumber) {
-    if (lineNumber < 1 || lineNumber > lines.size()) {
+bool TextEditor::convertLineCase(size_t lineNumber, LetterCase mode) {
+    if (lineNumber < 1 || lineNumber > buffer->lineCount()) {
         std::cerr << "Error: Invalid line number\n";
         return false;
     }
-    saveState();
-    lines[lineNumber - 1] = toUpper(lines[lineNumber - 1]);
+    std::string converted(buffer->line(lineNumber - 1));
+    convertCase(&converted[0], converted.size(), mode);
+    editLines(lineNumber - 1, 1, {std::move(converted)});
     unsavedChanges = true;
     return true;
 }
 
+/**
+ * @brief Конвертирует строку в верхний регистр
+ * @param lineNumber Номер строки (начиная с 1)
+ * @return true при успешном изменении, false при неверном номере
+ */
+bool TextEditor::toUpperCase(size_t lineNumber) {
+    return convertLineCase(lineNumber, LetterCase::Upper);
+}
+
 /**
  * @brief Конвертирует строку в нижний регистр
  * @param lineNumber Номер строки (начиная с 1)
  * @return true при успешном изменении, false при неверном номере
  */
 bool TextEditor::toLowerCase(size_t lineNumber) {
-    if (lineNumber < 1 || lineNumber > lines.size()) {
-        std::cerr << "Error: Invalid line number\n";
-        return false;
-    }
-    saveState();
-    lines[lineNumber - 1] = toLower(lines[lineNumber - 1]);
-    unsavedChanges = true;
-    return true;
+    return convertLineCase(lineNumber, LetterCase::Lower);
 }
 
 /**
@@ -330,14 +589,7 @@ bool TextEditor::toLowerCase(size_t lineNumber) {
  * @return true при успешном изменении, false при неверном номере
  */
 bool TextEditor::toTitleCase(size_t lineNumber) {
-    if (lineNumber < 1 || lineNumber > lines.size()) {
-        std::cerr << "Error: Invalid line number\n";
-        return false;
-    }
-    saveState();
-    lines[lineNumber - 1] = toTitle(lines[lineNumber - 1]);
-    unsavedChanges = true;
-    return true;
+    return convertLineCase(lineNumber, LetterCase::Title);
 }
 
 /**
@@ -345,14 +597,24 @@ bool TextEditor::toTitleCase(size_t lineNumber) {
  * @param caseType Тип регистра (1 - верхний, 2 - нижний, 3 - заголовочный)
  */
 void TextEditor::changeAllLinesCase(int caseType) {
-    saveState();
-    for (auto& line : lines) {
-        switch (caseType) {
-            case 1: line = toUpper(line); break;
-            case 2: line = toLower(line); break;
-            case 3: line = toTitle(line); break;
-        }
+    LetterCase mode;
+    switch (caseType) {
+        case 1: mode = LetterCase::Upper; break;
+        case 2: mode = LetterCase::Lower; break;
+        case 3: mode = LetterCase::Title; break;
+        default: return;
     }
+
+    std::unique_ptr<TextStorage> document = rewriteDocument(
+        [mode](size_t from, size_t to, char* text, const std::vector<LineSpan>& spans) {
+            // Each shard starts at a line boundary, so title case starts a new word
+            char* begin = text + spans[from].offset;
+            char* end = text + spans[to - 1].offset + spans[to - 1].length + 1;
+            convertCase(begin, static_cast<size_t>(end - begin), mode);
+        },
+        BulkOperation::ChangeCase);
+    // Case mapping never touches whitespace, so the word count is unchanged
+    replaceDocument(std::move(document), wordCount);
     unsavedChanges = true;
 }
 
@@ -365,9 +627,10 @@ bool TextEditor::undo() {
         std::cerr << "Nothing to undo\n";
         return false;
     }
-    redoStack.push(lines);
-    lines = undoStack.top();
+    EditRecord record = std::move(undoStack.top());
     undoStack.pop();
+    applyRecord(record, false);
+    redoStack.push(std::move(record));
     unsavedChanges = true;
     return true;
 }
@@ -381,57 +644,232 @@ bool TextEditor::redo() {
         std::cerr << "Nothing to redo\n";
         return false;
     }
-    undoStack.push(lines);
-    lines = redoStack.top();
+    EditRecord record = std::move(redoStack.top());
     redoStack.pop();
+    applyRecord(record, true);
+    undoStack.push(std::move(record));
     unsavedChanges = true;
     return true;
 }
 
 /**
- * @brief Подсчитывает количество слов в тексте
+ * @brief Возвращает количество слов в тексте
  * @return Общее количество слов
  */
 size_t TextEditor::getWordCount() const {
-    size_t count = 0;
-    for (const auto& line : lines) {
-        std::istringstream iss(line);
-        std::string word;
-        while (iss >> word) {
-            count++;
-        }
-    }
-    return count;
+    return wordCount;
 }
 
 /**
- * @brief Подсчитывает количество символов в тексте
+ * @brief Возвращает количество символов (байт) в тексте без переводов строк
  * @return Общее количество символов
  */
 size_t TextEditor::getCharCount() const {
-    size_t count = 0;
-    for (const auto& line : lines) {
-        count += line.length();
-    }
-    return count;
+    return buffer->byteCount();
 }
 
 /**
- * @brief Подсчитывает количество строк
+ * @brief Возвращает количество строк
  * @return Количество строк
  */
 size_t TextEditor::getLineCount() const {
-    return lines.size();
+    return buffer->lineCount();
 }
 
 /**
- * @brief Выводит статистику по тексту (строки, слова, символы)
+ * @brief Выводит статистику по тексту (строки, слова, символы, время вывода)
  */
 void TextEditor::showStats() const {
     std::cout << "Statistics:\n"
               << "  Lines: " << getLineCount() << "\n"
               << "  Words: " << getWordCount() << "\n"
-              << "  Characters: " << getCharCount() << "\n";
+              << "  Characters: " << getCharCount() << "\n"
+              << "  Last render: " << std::chrono::duration<double, std::milli>(renderTime).count() << " ms\n";
+}
+
+/**
+ * @brief Переключает механизм хранения строк с переносом содержимого
+ *
+ * Версии документа в журналах отмены и повтора переносятся в новый механизм
+ * вместе с текущей.
+ *
+ * @param engine Новый механизм хранения
+ */
+void TextEditor::setStorageEngine(StorageEngine engine) {
+    if (engine == storageEngine) return;
+
+    buffer = copyStorage(*buffer, engine);
+    // Whole-document records would swap a document of the old engine back in on undo
+    for (std::stack<EditRecord>* log : {&undoStack, &redoStack}) {
+        std::vector<EditRecord> records;
+        for (; !log->empty(); log->pop()) {
+            records.push_back(std::move(log->top()));
+        }
+        for (auto it = records.rbegin(); it != records.rend(); ++it) {
+            if (it->document) it->document = copyStorage(*it->document, engine);
+            log->push(std::move(*it));
+        }
+    }
+    storageEngine = engine;
+}
+
+/**
+ * @brief Возвращает текущий механизм хранения строк
+ * @return Механизм хранения
+ */
+StorageEngine TextEditor::getStorageEngine() const {
+    return storageEngine;
+}
+
+/**
+ * @brief Возвращает пул потоков, создавая его при необходимости
+ * @return Пул с наибольшим из заданных чисел потоков
+ */
+ThreadPool& TextEditor::pool() const {
+    size_t size = getThreadCount();
+    for (size_t count : operationThreads) {
+        size = std::max(size, count);
+    }
+    if (!threadPool || threadPool->size() != size) {
+        threadPool.reset();
+        threadPool = std::make_unique<ThreadPool>(size);
+    }
+    return *threadPool;
+}
+
+/**
+ * @brief Определяет число потоков, которым выполняется операция над документом
+ * @param operation Операция
+ * @return Количество потоков (1 для документов меньше порога параллельной обработки)
+ */
+size_t TextEditor::operationParallelism(BulkOperation operation) const {
+    if (buffer->byteCount() < kParallelThreshold) return 1;
+    return getThreadCount(operation);
+}
+
+/**
+ * @brief Выбирает размер части для параллельной обработки всех строк документа
+ * @param operation Операция
+ * @return Количество строк в части (все строки, если операция выполняется в одном потоке)
+ */
+size_t TextEditor::linesPerShard(BulkOperation operation) const {
+    const size_t total = buffer->lineCount();
+    const size_t threads = operationParallelism(operation);
+    if (threads <= 1) return std::max<size_t>(total, 1);
+    return std::max(kMinLinesPerShard, total / (threads * 8) + 1);
+}
+
+/**
+ * @brief Обрабатывает строки [first, last) частями по grain строк
+ *
+ * Части выравнены по grain от first; при нескольких потоках они
+ * распределяются по пулу, иначе обрабатываются по порядку в вызывающем потоке.
+ *
+ * @param operation Операция, задающая число потоков
+ * @param first Первая строка
+ * @param last Строка за последней
+ * @param grain Размер части (не меньше 1)
+ * @param fn Функция обработки части
+ */
+void TextEditor::parallelForLines(BulkOperation operation, size_t first, size_t last, size_t grain,
+                                  const ThreadPool::RangeTask& fn) const {
+    if (first >= last) return;
+    if (grain == 0) grain = 1;
+    const size_t threads = operationParallelism(operation);
+    if (threads <= 1 || grain >= last - first) {
+        for (size_t from = first; from < last; from += grain) {
+            fn(from, std::min(last, from + grain));
+        }
+        return;
+    }
+    pool().parallelFor(first, last, grain, fn, threads);
+}
+
+/**
+ * @brief Задает число потоков для массовых операций
+ * @param count Количество потоков (0 - по числу ядер процессора, 1 - без параллелизма)
+ */
+void TextEditor::setThreadCount(size_t count) {
+    threadCount = count;
+}
+
+/**
+ * @brief Возвращает число потоков, используемое для массовых операций
+ * @return Количество потоков
+ */
+size_t TextEditor::getThreadCount() const {
+    if (threadCount > 0) return threadCount;
+    size_t hardware = std::thread::hardware_concurrency();
+    return hardware > 0 ? hardware : 1;
+}
+
+/**
+ * @brief Задает число потоков для отдельной операции
+ * @param operation Операция
+ * @param count Количество потоков (0 - общее значение getThreadCount())
+ */
+void TextEditor::setThreadCount(BulkOperation operation, size_t count) {
+    operationThreads[static_cast<size_t>(operation)] = count;
+}
+
+/**
+ * @brief Возвращает число потоков, используемое операцией
+ * @param operation Операция
+ * @return Количество потоков
+ */
+size_t TextEditor::getThreadCount(BulkOperation operation) const {
+    size_t count = operationThreads[static_cast<size_t>(operation)];
+    return count > 0 ? count : getThreadCount();
+}
+
+/**
+ * @brief Включает или выключает инвертированный индекс слов для searchText
+ * @param enabled true чтобы построить индекс и поддерживать его при правках
+ */
+void TextEditor::setWordIndexEnabled(bool enabled) {
+    wordIndexEnabled = enabled;
+    if (enabled) {
+        wordIndex.build(*buffer);
+    } else {
+        wordIndex.invalidate();
+    }
+}
+
+/**
+ * @brief Проверяет, включен ли индекс слов
+ * @return true если индекс включен
+ */
+bool TextEditor::isWordIndexEnabled() const {
+    return wordIndexEnabled;
+}
+
+/**
+ * @brief Включает или выключает индекс триграмм для filterLines и searchText
+ * @param enabled true чтобы построить индекс и поддерживать его при правках
+ */
+void TextEditor::setTrigramIndexEnabled(bool enabled) {
+    trigramIndexEnabled = enabled;
+    if (enabled) {
+        ensureTrigramIndex();
+    } else {
+        trigramIndex.invalidate();
+    }
+}
+
+/**
+ * @brief Проверяет, включен ли индекс триграмм
+ * @return true если индекс включен
+ */
+bool TextEditor::isTrigramIndexEnabled() const {
+    return trigramIndexEnabled;
+}
+
+/**
+ * @brief Задает лимит памяти индекса триграмм
+ * @param bytes Наибольший размер индекса в байтах
+ */
+void TextEditor::setTrigramIndexMemoryLimit(size_t bytes) {
+    trigramIndex.setMemoryLimit(bytes);
 }
 
 /**
@@ -439,14 +877,49 @@ void TextEditor::showStats() const {
  * @param keyword Текст для фильтрации
  */
 void TextEditor::filterLines(const std::string& keyword) {
-    saveState();
     std::vector<std::string> filteredLines;
-    for (const auto& line : lines) {
-        if (line.find(keyword) != std::string::npos) {
-            filteredLines.push_back(line);
+    std::vector<size_t> kept;
+    const SubstringSearcher searcher(keyword);
+    if (TrigramIndex::canNarrow(keyword) && ensureTrigramIndex()) {
+        for (size_t i : trigramIndex.candidates(keyword)) {
+            std::string_view line = buffer->line(i);
+            if (searcher.containedIn(line)) {
+                filteredLines.emplace_back(line);
+                kept.push_back(i);
+            }
+        }
+    } else {
+        // Each shard keeps its own lines; shards are concatenated in order
+        const size_t total = buffer->lineCount();
+        const size_t grain = linesPerShard(BulkOperation::Filter);
+        std::vector<std::pair<std::vector<std::string>, std::vector<size_t>>> shards((total + grain - 1) / grain);
+        parallelForLines(BulkOperation::Filter, 0, total, grain, [&](size_t from, size_t to) {
+            auto& shard = shards[from / grain];
+            buffer->forEachLine(from, to, [&](size_t i, std::string_view line) {
+                if (searcher.containedIn(line)) {
+                    shard.first.emplace_back(line);
+                    shard.second.push_back(i);
+                }
+            });
+        });
+        for (auto& shard : shards) {
+            std::move(shard.first.begin(), shard.first.end(), std::back_inserter(filteredLines));
+            kept.insert(kept.end(), shard.second.begin(), shard.second.end());
         }
     }
-    lines = filteredLines;
+
+    // Indexes survive filtering: only line numbers change
+    WordIndex words = std::move(wordIndex);
+    TrigramIndex trigrams = std::move(trigramIndex);
+    replaceDocumentLines(filteredLines);
+    if (words.isValid()) {
+        words.retainLines(kept);
+        wordIndex = std::move(words);
+    }
+    if (trigrams.isValid()) {
+        trigrams.retainLines(kept);
+        trigramIndex = std::move(trigrams);
+    }
     unsavedChanges = true;
 }
 
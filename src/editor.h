@@ -5,8 +5,35 @@
 #include <vector>
 #include <string>
 #include <stack>
+#include <array>
+#include <chrono>
 #include <cstring>
+#include <functional>
 #include <locale>
+#include <memory>
+#include <optional>
+#include "text_kernels.h"
+#include "syntax_highlighter.h"
+#include "text_storage.h"
+#include "thread_pool.h"
+#include "trigram_index.h"
+#include "word_index.h"
+
+/**
+ * @brief Массовые операции над строками, для которых можно задать число потоков
+ */
+enum class BulkOperation {
+    Search,     ///< Поиск слова (searchText)
+    Filter,     ///< Фильтрация строк (filterLines)
+    ChangeCase, ///< Смена регистра всего текста (changeAllLinesCase)
+    WordCount,  ///< Подсчет слов после замены документа
+    Encryption, ///< Шифрование при сохранении и расшифровка при загрузке
+    Highlight   ///< Подсветка синтаксиса
+};
+
+/// Количество видов массовых операций
+constexpr size_t kBulkOperationCount = 6;
+
 /**
  * @class TextEditor
  * @brief Основной класс текстового редактора с поддержкой шифрования и работы с файлами
@@ -16,60 +43,225 @@
  */
 class TextEditor {
 private:
-    std::vector<std::string> lines; ///< Содержимое файла (каждый элемент - строка)
+    std::unique_ptr<TextStorage> buffer; ///< Содержимое файла (хранилище строк)
+    StorageEngine storageEngine;    ///< Текущий механизм хранения строк
     std::string currentFilePath;    ///< Путь к текущему открытому файлу
     bool unsavedChanges;            ///< Флаг наличия несохраненных изменений
-    std::stack<std::vector<std::string>> undoStack; ///< Стек состояний для отмены действий
-    std::stack<std::vector<std::string>> redoStack; ///< Стек состояний для повтора действий
-    std::string tempPassword;       ///< Временное хранение пароля для шифрования
+    size_t wordCount;               ///< Количество слов документа (поддерживается при каждой правке)
+    /**
+     * @brief Фрагмент правки: диапазон строк до и после изменения
+     */
+    struct EditHunk {
+        size_t first;                    ///< Индекс первой измененной строки
+        std::vector<std::string> before; ///< Строки до изменения
+        std::vector<std::string> after;  ///< Строки после изменения
+    };
 
     /**
-     * @brief Сохраняет текущее состояние текста в стек отмены
+     * @brief Запись журнала отмены: построчные фрагменты или смена всего документа
      */
-    void saveState();
+    struct EditRecord {
+        std::vector<EditHunk> hunks;           ///< Построчные изменения в порядке применения
+        std::unique_ptr<TextStorage> document; ///< Другая версия документа (при замене целиком)
+        size_t documentWords = 0;              ///< Количество слов в другой версии документа
+    };
+
+    std::stack<EditRecord> undoStack; ///< Журнал правок для отмены действий
+    std::stack<EditRecord> redoStack; ///< Журнал отмененных правок для повтора
+    std::string tempPassword;       ///< Пароль шифрования (непустой - файл сохраняется зашифрованным)
+    std::string pendingEncryptedPath; ///< Зашифрованный файл, ожидающий пароля для загрузки
+    size_t threadCount;             ///< Число потоков для массовых операций (0 - по числу ядер)
+    std::array<size_t, kBulkOperationCount> operationThreads; ///< Число потоков отдельных операций (0 - общее)
+    mutable std::unique_ptr<ThreadPool> threadPool; ///< Пул потоков (создается при первом использовании)
+    bool wordIndexEnabled;          ///< Поиск слов через инвертированный индекс
+    mutable WordIndex wordIndex;    ///< Индекс слов (перестраивается при первом поиске после замены документа)
+    bool trigramIndexEnabled;       ///< Сужение поиска подстрок через индекс триграмм
+    TrigramIndex trigramIndex;      ///< Индекс триграмм (перестраивается при первой фильтрации после замены документа)
+    bool highlightEnabled;          ///< Вывод текста с подсветкой синтаксиса
+    mutable std::string screen;     ///< Буфер вывода строк (сохраняет емкость между выводами)
+    mutable std::chrono::nanoseconds renderTime; ///< Время подготовки и вывода последнего диапазона строк
+    mutable SyntaxHighlighter highlighter; ///< Разметка подсветки (обновляется при выводе)
 
     /**
-     * @brief Генерирует ключ шифрования на основе пароля
-     * @param password Пароль для шифрования
-     * @param length Требуемая длина ключа
-     * @return Сгенерированный ключ
+     * @brief Заменяет диапазон строк, записывая в журнал только затронутые строки
+     * @param first Индекс первой заменяемой строки
+     * @param count Количество заменяемых строк
+     * @param newLines Новые строки
      */
-    std::string deriveKey(const std::string& password, size_t length) const;
+    void editLines(size_t first, size_t count, std::vector<std::string> newLines);
 
     /**
-     * @brief Выполняет операцию XOR-шифрования
-     * @param data Данные для шифрования/расшифровки
-     * @param key Ключ шифрования
-     * @return Результат шифрования
+     * @brief Заменяет документ целиком; прежний документ перемещается в журнал без копирования
+     * @param document Новый документ
+     * @param words Количество слов нового документа, если уже известно
      */
-    std::string xorCrypt(const std::string& data, const std::string& key) const;
+    void replaceDocument(std::unique_ptr<TextStorage> document,
+                         std::optional<size_t> words = std::nullopt);
 
     /**
-     * @brief Безопасно очищает строку (заполняет нулями)
-     * @param str Ссылка на строку для очистки
+     * @brief Заменяет документ целиком новым набором строк
+     * @param lines Строки нового документа
      */
-    void secureClear(std::string& str);
+    void replaceDocumentLines(const std::vector<std::string>& lines);
+
+    /**
+     * @brief Преобразование диапазона строк [from, to) внутри нового блока документа
+     */
+    using LineRangeTransform =
+        std::function<void(size_t from, size_t to, char* text, const std::vector<LineSpan>& spans)>;
+
+    /**
+     * @brief Копирует документ в один новый блок, преобразуя строки на месте
+     *
+     * Первый проход определяет размер частей, второй копирует их и вызывает
+     * преобразование; большие документы обрабатываются частями на пуле потоков.
+     *
+     * @param transform Преобразование диапазона строк внутри нового блока
+     * @param operation Операция, задающая число потоков
+     * @return Новый документ с той же разбивкой на строки
+     */
+    std::unique_ptr<TextStorage> rewriteDocument(const LineRangeTransform& transform,
+                                                 BulkOperation operation) const;
+
+    /**
+     * @brief Подсчитывает слова во всем документе (частями на пуле потоков)
+     * @return Количество слов
+     */
+    size_t countDocumentWords() const;
+
+    /**
+     * @brief Добавляет запись в журнал отмены и очищает журнал повтора
+     * @param record Запись журнала
+     */
+    void commitEdit(EditRecord record);
+
+    /**
+     * @brief Применяет запись журнала в прямом или обратном направлении
+     * @param record Запись журнала (при замене документа обменивается с текущим)
+     * @param forward true для повтора, false для отмены
+     */
+    void applyRecord(EditRecord& record, bool forward);
+
+    /**
+     * @brief Учитывает замену диапазона строк в статистике и индексах поиска
+     * @param first Индекс первой замененной строки
+     * @param removed Строки, бывшие в диапазоне до замены
+     * @param added Строки, занявшие диапазон после замены
+     */
+    void noteLinesReplaced(size_t first, const std::vector<std::string>& removed,
+                           const std::vector<std::string>& added);
+
+    /**
+     * @brief Сбрасывает индексы поиска и разметку подсветки после замены документа целиком
+     */
+    void invalidateIndexes();
 
     /**
-     * @brief Преобразует строку в верхний регистр
-     * @param str Исходная строка
-     * @return Строка в верхнем регистре
+     * @brief Строит полную разметку подсветки, если она не построена
+     *
+     * Части документа разбираются параллельно, затем границы частей
+     * согласуются последовательно.
      */
-    std::string toUpper(const std::string& str) const;
+    void buildHighlight() const;
 
     /**
-     * @brief Преобразует строку в нижний регистр
-     * @param str Исходная строка
-     * @return Строка в нижнем регистре
+     * @brief Готовит лексемы подсветки строк [first, last)
+     *
+     * Небольшие диапазоны размечаются через кэш видимых строк без разбора
+     * всего документа; для диапазонов больше кэша строится полная разметка.
+     *
+     * @param first Первая строка
+     * @param last Строка за последней
      */
-    std::string toLower(const std::string& str) const;
+    void ensureHighlight(size_t first, size_t last) const;
 
     /**
-     * @brief Преобразует строку в регистр заголовка
-     * @param str Исходная строка
-     * @return Строка в регистре заголовка
+     * @brief Строит индекс триграмм, если он включен и еще не построен
+     *
+     * Если индекс не укладывается в лимит памяти, он отключается и поиск
+     * подстрок выполняется полным просмотром.
+     *
+     * @return true если индекс готов к использованию
+     */
+    bool ensureTrigramIndex();
+
+    /**
+     * @brief Делает блок текста, прочитанный из файла, текущим документом
+     * @param block Содержимое файла
+     * @param filePath Путь к файлу
+     */
+    void openDocument(TextBlock block, const std::string& filePath);
+
+    /**
+     * @brief Загружает зашифрованный файл, расшифровывая куски сразу в документ
+     * @param filePath Путь к файлу
+     * @param password Пароль
+     * @return true при успешной загрузке, false при неверном пароле или ошибке
+     */
+    bool loadEncryptedFile(const std::string& filePath, const std::string& password);
+
+    /**
+     * @brief Возвращает пул потоков, создавая его при необходимости
+     * @return Пул с наибольшим из заданных чисел потоков
+     */
+    ThreadPool& pool() const;
+
+    /**
+     * @brief Определяет число потоков, которым выполняется операция над документом
+     * @param operation Операция
+     * @return Количество потоков (1 для документов меньше порога параллельной обработки)
+     */
+    size_t operationParallelism(BulkOperation operation) const;
+
+    /**
+     * @brief Выбирает размер части для параллельной обработки всех строк документа
+     * @param operation Операция
+     * @return Количество строк в части (все строки, если операция выполняется в одном потоке)
+     */
+    size_t linesPerShard(BulkOperation operation) const;
+
+    /**
+     * @brief Обрабатывает строки [first, last) частями по grain строк
+     *
+     * Части выравнены по grain от first; при нескольких потоках они
+     * распределяются по пулу, иначе обрабатываются по порядку в вызывающем потоке.
+     *
+     * @param operation Операция, задающая число потоков
+     * @param first Первая строка
+     * @param last Строка за последней
+     * @param grain Размер части (не меньше 1)
+     * @param fn Функция обработки части
+     */
+    void parallelForLines(BulkOperation operation, size_t first, size_t last, size_t grain,
+                          const ThreadPool::RangeTask& fn) const;
+
+    /**
+     * @brief Форматирует строки [first, last) с колонкой номеров в буфер вывода
+     *
+     * Номера выравниваются вправо по ширине колонки; при включенной подсветке
+     * лексемы окружаются ANSI-последовательностями цвета. Размер буфера
+     * вычисляется заранее, поэтому память выделяется не больше одного раза.
+     *
+     * @param first Первая строка
+     * @param last Строка за последней
+     * @param width Ширина колонки номеров
+     * @param out Буфер, содержимое которого заменяется
+     */
+    void renderLines(size_t first, size_t last, size_t width, std::string& out) const;
+
+    /**
+     * @brief Безопасно очищает строку (заполняет нулями)
+     * @param str Ссылка на строку для очистки
+     */
+    void secureClear(std::string& str);
+
+    /**
+     * @brief Преобразует регистр одной строки с записью в журнал отмены
+     * @param lineNumber Номер строки (начиная с 1)
+     * @param mode Вид преобразования
+     * @return true при успешном изменении, false при неверном номере
      */
-    std::string toTitle(const std::string& str) const;
+    bool convertLineCase(size_t lineNumber, LetterCase mode);
 
 public:
     /**
@@ -117,6 +309,44 @@ public:
      */
     void displayText() const;
 
+    /**
+     * @brief Отображает диапазон строк с нумерацией
+     *
+     * Строки форматируются в буфер и выводятся одной записью в std::cout на
+     * каждые 1024 строки (экран выводится одной записью).
+     * При включенной подсветке размечаются только выводимые строки.
+     *
+     * @param firstLine Номер первой строки (начиная с 1)
+     * @param lastLine Номер последней строки (включительно; обрезается до количества строк)
+     * @return true при успешном выводе, false при неверном диапазоне
+     */
+    bool displayText(size_t firstLine, size_t lastLine) const;
+
+    /**
+     * @brief Возвращает время подготовки и вывода последнего диапазона строк
+     * @return Длительность последнего вызова displayText
+     */
+    std::chrono::nanoseconds getLastRenderTime() const;
+
+    /**
+     * @brief Передает строки диапазона и их лексемы без копирования
+     *
+     * Используется полноэкранным режимом: подсветка готовится один раз для
+     * всего диапазона. При выключенной подсветке лексемы пусты.
+     *
+     * @param firstLine Номер первой строки (начиная с 1)
+     * @param lastLine Номер последней строки (включительно; обрезается до количества строк)
+     * @param visitor Функция, получающая индекс строки (с 0), строку и лексемы
+     */
+    void visitLines(size_t firstLine, size_t lastLine,
+                    const std::function<void(size_t, std::string_view, const std::vector<TokenSpan>&)>& visitor) const;
+
+    /**
+     * @brief Возвращает путь к текущему файлу
+     * @return Путь или пустая строка для нового документа
+     */
+    const std::string& getFilePath() const;
+
     /**
      * @brief Проверяет наличие несохраненных изменений
      * @return true если есть несохраненные изменения
@@ -124,20 +354,42 @@ public:
     bool hasUnsavedChanges() const;
 
     /**
-     * @brief Возвращает ссылку на текущие строки текста
-     * @return Константная ссылка на вектор строк
+     * @brief Проверяет, ждет ли зашифрованный файл пароля для загрузки
+     * @return true если последняя загрузка остановилась на зашифрованном файле
+     */
+    bool hasPendingEncryptedFile() const;
+
+    /**
+     * @brief Возвращает копию текущих строк текста
+     * @return Вектор строк документа
+     */
+    std::vector<std::string> getLines() const;
+
+    /**
+     * @brief Возвращает одну строку текста без копирования всего документа
+     * @param lineNumber Номер строки (начиная с 1)
+     * @return Содержимое строки или пустая строка при неверном номере
      */
-    const std::vector<std::string>& getLines() const;
+    std::string getLine(size_t lineNumber) const;
 
     /**
-     * @brief Шифрует текущий текст с использованием пароля
+     * @brief Включает шифрование файла паролем
+     *
+     * Документ в памяти не изменяется: сохранение записывает его в зашифрованный
+     * файл, пока пароль не будет очищен.
+     *
      * @param password Пароль для шифрования
      * @return true при успешном шифровании, false при ошибке
      */
     bool encryptFile(const std::string& password);
 
     /**
-     * @brief Расшифровывает текущий текст с использованием пароля
+     * @brief Расшифровывает файл с использованием пароля
+     *
+     * Если загружаемый файл оказался зашифрованным, он открывается с этим
+     * паролем. Иначе шифрование текущего документа отключается, если пароль
+     * совпадает с паролем шифрования.
+     *
      * @param password Пароль для расшифровки
      * @return true при успешной расшифровке, false при ошибке
      */
@@ -154,6 +406,14 @@ public:
      */
     void addLine(const std::string& line);
 
+    /**
+     * @brief Вставляет строку перед указанной позицией
+     * @param lineNumber Номер, который получит новая строка (от 1 до количества строк + 1)
+     * @param line Текст вставляемой строки
+     * @return true при успешной вставке, false при неверном номере
+     */
+    bool insertLine(size_t lineNumber, const std::string& line);
+
     /**
      * @brief Удаляет строку по номеру
      * @param lineNumber Номер строки (начиная с 1)
@@ -171,16 +431,56 @@ public:
 
     /**
      * @brief Ищет текст в строках
+     *
+     * При включенном индексе слов ответ берется из индекса, если искомый текст
+     * является одним словом. Иначе большие документы делятся на части, которые
+     * просматриваются параллельно в пуле потоков; результаты объединяются
+     * в порядке строк.
+     *
      * @param keyword Искомый текст
      * @return Вектор номеров строк, содержащих искомый текст
      */
     std::vector<size_t> searchText(const std::string& keyword) const;
 
     /**
-     * @brief Подсвечивает синтаксис в тексте (заглушка)
+     * @brief Включает подсветку синтаксиса и размечает весь документ
+     *
+     * Текст не изменяется: лексемы хранятся отдельно и используются displayText.
+     * Язык (C/C++, Python или командная оболочка) выбирается по расширению файла.
+     * После правок заново разбираются только измененные строки и следующие
+     * за ними, пока не совпадет состояние лексера.
      */
     void highlightSyntax();
 
+    /**
+     * @brief Включает или выключает подсветку синтаксиса при выводе текста
+     *
+     * Документ не размечается сразу: лексемы вычисляются при выводе только
+     * для выводимых строк и кэшируются до их правки.
+     *
+     * @param enabled true чтобы выводить текст с подсветкой
+     */
+    void setSyntaxHighlightEnabled(bool enabled);
+
+    /**
+     * @brief Проверяет, включена ли подсветка синтаксиса
+     * @return true если подсветка включена
+     */
+    bool isSyntaxHighlightEnabled() const;
+
+    /**
+     * @brief Возвращает язык подсветки, определенный по расширению текущего файла
+     * @return Язык
+     */
+    Language getSyntaxLanguage() const;
+
+    /**
+     * @brief Возвращает лексемы подсветки строки
+     * @param lineNumber Номер строки (начиная с 1)
+     * @return Лексемы строки или пустой вектор при неверном номере или выключенной подсветке
+     */
+    std::vector<TokenSpan> getLineTokens(size_t lineNumber) const;
+
     /**
      * @brief Конвертирует строку в верхний регистр
      * @param lineNumber Номер строки (начиная с 1)
@@ -204,6 +504,11 @@ public:
 
     /**
      * @brief Конвертирует все строки в указанный регистр
+     *
+     * Документ копируется один раз в общий блок и преобразуется в нем на месте,
+     * без выделения памяти на каждую строку; большие документы обрабатываются
+     * частями параллельно в пуле потоков.
+     *
      * @param caseType Тип регистра (1 - верхний, 2 - нижний, 3 - заголовочный)
      */
     void changeAllLinesCase(int caseType);
@@ -221,30 +526,105 @@ public:
     bool redo();
 
     /**
-     * @brief Подсчитывает количество слов в тексте
+     * @brief Возвращает количество слов в тексте
+     *
+     * Счетчик поддерживается при каждой правке, поэтому вызов не просматривает текст.
+     *
      * @return Общее количество слов
      */
     size_t getWordCount() const;
 
     /**
-     * @brief Подсчитывает количество символов в тексте
+     * @brief Возвращает количество символов (байт) в тексте без переводов строк
      * @return Общее количество символов
      */
     size_t getCharCount() const;
 
     /**
-     * @brief Подсчитывает количество строк
+     * @brief Возвращает количество строк
      * @return Количество строк
      */
     size_t getLineCount() const;
 
     /**
-     * @brief Выводит статистику по тексту (строки, слова, символы)
+     * @brief Выводит статистику по тексту (строки, слова, символы, время вывода)
      */
     void showStats() const;
 
+    /**
+     * @brief Переключает механизм хранения строк с переносом содержимого
+     * @param engine Новый механизм хранения
+     */
+    void setStorageEngine(StorageEngine engine);
+
+    /**
+     * @brief Возвращает текущий механизм хранения строк
+     * @return Механизм хранения
+     */
+    StorageEngine getStorageEngine() const;
+
+    /**
+     * @brief Задает число потоков для массовых операций
+     * @param count Количество потоков (0 - по числу ядер процессора, 1 - без параллелизма)
+     */
+    void setThreadCount(size_t count);
+
+    /**
+     * @brief Возвращает число потоков, используемое для массовых операций
+     * @return Количество потоков
+     */
+    size_t getThreadCount() const;
+
+    /**
+     * @brief Задает число потоков для отдельной операции
+     * @param operation Операция
+     * @param count Количество потоков (0 - общее значение getThreadCount())
+     */
+    void setThreadCount(BulkOperation operation, size_t count);
+
+    /**
+     * @brief Возвращает число потоков, используемое операцией
+     * @param operation Операция
+     * @return Количество потоков
+     */
+    size_t getThreadCount(BulkOperation operation) const;
+
+    /**
+     * @brief Включает или выключает инвертированный индекс слов для searchText
+     * @param enabled true чтобы построить индекс и поддерживать его при правках
+     */
+    void setWordIndexEnabled(bool enabled);
+
+    /**
+     * @brief Проверяет, включен ли индекс слов
+     * @return true если индекс включен
+     */
+    bool isWordIndexEnabled() const;
+
+    /**
+     * @brief Включает или выключает индекс триграмм для filterLines и searchText
+     * @param enabled true чтобы построить индекс и поддерживать его при правках
+     */
+    void setTrigramIndexEnabled(bool enabled);
+
+    /**
+     * @brief Проверяет, включен ли индекс триграмм
+     * @return true если индекс включен
+     */
+    bool isTrigramIndexEnabled() const;
+
+    /**
+     * @brief Задает лимит памяти индекса триграмм
+     * @param bytes Наибольший размер индекса в байтах
+     */
+    void setTrigramIndexMemoryLimit(size_t bytes);
+
     /**
      * @brief Фильтрует строки, оставляя только содержащие указанный текст
+     *
+     * При включенном индексе триграмм проверяются только строки, содержащие
+     * все триграммы текста; тексты короче трех байт ищутся полным просмотром.
+     *
      * @param keyword Текст для фильтрации
      */
     void filterLines(const std::string& keyword);
@@ -0,0 +1,420 @@
+#include "encrypted_file.h"
+#include "mapped_file.h"
+#include "poly1305.h"
+#include "sha256.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <vector>
+
+namespace {
+
+/// Сигнатура зашифрованного файла
+constexpr std::string_view kMagic = "TXTCRYPT";
+
+/// Версия формата
+constexpr uint32_t kVersion = 1;
+
+/// Размер заголовка: сигнатура, версия, итерации, размер куска, соль, контрольное значение
+constexpr size_t kHeaderSize = 8 + 4 + 4 + 4 + kSaltSize + 16;
+
+/// Размер одноразового числа куска
+constexpr size_t kNonceSize = 12;
+
+/// Служебные байты куска: одноразовое число и код аутентичности
+constexpr size_t kChunkOverhead = kNonceSize + Poly1305::kTagSize;
+
+/**
+ * @brief Читает 32-битное число в порядке байтов little-endian
+ * @param p Адрес числа
+ * @return Значение
+ */
+uint32_t loadWord(const char* p) {
+    const auto* u = reinterpret_cast<const uint8_t*>(p);
+    return uint32_t(u[0]) | (uint32_t(u[1]) << 8) | (uint32_t(u[2]) << 16) | (uint32_t(u[3]) << 24);
+}
+
+/**
+ * @brief Дописывает 32-битное число в порядке байтов little-endian
+ * @param out Строка
+ * @param value Значение
+ */
+void appendWord(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out += static_cast<char>(value >> (8 * i));
+    }
+}
+
+/**
+ * @brief Формирует одноразовое число куска
+ * @param index Номер куска
+ * @param last Является ли кусок последним
+ * @return Одноразовое число
+ */
+std::array<uint8_t, kNonceSize> chunkNonce(uint64_t index, bool last) {
+    std::array<uint8_t, kNonceSize> nonce{};
+    for (int i = 0; i < 8; ++i) {
+        nonce[i] = static_cast<uint8_t>(index >> (8 * i));
+    }
+    nonce[8] = last ? 1 : 0;
+    return nonce;
+}
+
+/**
+ * @brief Вычисляет HMAC-SHA256 метки на ключе
+ * @param key Ключ
+ * @param label Метка
+ * @return Код
+ */
+Sha256::Digest labelledHmac(const std::array<uint8_t, 32>& key, std::string_view label) {
+    HmacSha256 mac(key.data(), key.size());
+    mac.update(label.data(), label.size());
+    return mac.finish();
+}
+
+} // namespace
+
+/**
+ * @brief Создает случайную соль
+ * @return Соль
+ */
+std::array<uint8_t, kSaltSize> makeSalt() {
+    std::array<uint8_t, kSaltSize> salt;
+    std::random_device random;
+    for (uint8_t& byte : salt) {
+        byte = static_cast<uint8_t>(random());
+    }
+    return salt;
+}
+
+/**
+ * @brief Выводит ключ шифрования и контрольное значение из пароля
+ *
+ * PBKDF2-HMAC-SHA256 выполняется один раз; ключ и контрольное значение
+ * получаются из его результата HMAC с разными метками, поэтому контрольное
+ * значение ничего не сообщает о ключе.
+ *
+ * @param password Пароль
+ * @param salt Соль
+ * @param iterations Число итераций PBKDF2
+ * @return Ключи
+ */
+FileKeys deriveFileKeys(std::string_view password, const std::array<uint8_t, kSaltSize>& salt,
+                        uint32_t iterations) {
+    std::array<uint8_t, 32> master;
+    pbkdf2HmacSha256(password, salt.data(), salt.size(), iterations, master.data(), master.size());
+
+    FileKeys keys;
+    Sha256::Digest key = labelledHmac(master, "chunk key");
+    Sha256::Digest check = labelledHmac(master, "key check");
+    std::copy(key.begin(), key.end(), keys.key.begin());
+    std::copy(check.begin(), check.begin() + keys.check.size(), keys.check.begin());
+    std::fill(master.begin(), master.end(), 0);
+    std::fill(key.begin(), key.end(), 0);
+    return keys;
+}
+
+/**
+ * @brief Проверяет, начинаются ли данные с сигнатуры зашифрованного файла
+ * @param bytes Начало файла
+ * @return true если это зашифрованный файл
+ */
+bool isEncryptedFile(std::string_view bytes) {
+    return bytes.substr(0, kMagic.size()) == kMagic;
+}
+
+/**
+ * @brief Создает закрытый объект записи
+ * @param pool Пул потоков для шифрования кусков (nullptr - в вызывающем потоке)
+ * @param threads Наибольшее число участвующих потоков (0 - все потоки пула)
+ */
+EncryptedFileWriter::EncryptedFileWriter(ThreadPool* pool, size_t threads)
+    : pool(pool), threads(threads), key{}, capacity(0), used(0), index(0), failed(false) {}
+
+/**
+ * @brief Затирает ключ и буфер куска
+ */
+EncryptedFileWriter::~EncryptedFileWriter() {
+    std::fill(key.begin(), key.end(), 0);
+    if (batch) {
+        std::memset(batch.get(), 0, capacity);
+    }
+}
+
+/**
+ * @brief Создает файл, выводит ключ из пароля и записывает заголовок
+ * @param path Путь к файлу
+ * @param password Пароль
+ * @param iterations Число итераций PBKDF2 (от 1 до kMaxKdfIterations)
+ * @return true если файл открыт
+ */
+bool EncryptedFileWriter::open(const std::string& path, std::string_view password, uint32_t iterations) {
+    // A file the reader would refuse is not written at all
+    if (iterations == 0 || iterations > kMaxKdfIterations) return false;
+    if (!file.open(path)) return false;
+
+    const auto salt = makeSalt();
+    FileKeys keys = deriveFileKeys(password, salt, iterations);
+    key = keys.key;
+
+    header.assign(kMagic);
+    appendWord(header, kVersion);
+    appendWord(header, iterations);
+    appendWord(header, static_cast<uint32_t>(kChunkSize));
+    header.append(reinterpret_cast<const char*>(salt.data()), salt.size());
+    header.append(reinterpret_cast<const char*>(keys.check.data()), keys.check.size());
+    std::fill(keys.key.begin(), keys.key.end(), 0);
+
+    // A few chunks per thread keep every worker busy between two writes
+    size_t workers = pool ? pool->size() : 0;
+    if (threads > 0) workers = std::min(workers, threads);
+    capacity = kChunkSize * (workers > 0 ? workers * 4 : 1);
+    batch.reset(new char[capacity]);
+    used = 0;
+    index = 0;
+    failed = !file.write(header);
+    return !failed;
+}
+
+/**
+ * @brief Шифрует и записывает накопленные куски
+ * @param last Содержит ли буфер последний кусок
+ */
+void EncryptedFileWriter::sealBatch(bool last) {
+    // An empty file still has one (empty) last chunk
+    const size_t count = std::max<size_t>(1, (used + kChunkSize - 1) / kChunkSize);
+    std::vector<Poly1305::Tag> tags(count);
+    auto seal = [&](size_t from, size_t to) {
+        for (size_t i = from; i < to; ++i) {
+            const auto nonce = chunkNonce(index + i, last && i + 1 == count);
+            const size_t size = std::min(kChunkSize, used - i * kChunkSize);
+            tags[i] = sealChaCha20Poly1305(key.data(), nonce.data(), header.data(), header.size(),
+                                           batch.get() + i * kChunkSize, size);
+        }
+    };
+    if (pool) {
+        pool->parallelFor(0, count, 1, seal, threads);
+    } else {
+        seal(0, count);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        const auto nonce = chunkNonce(index + i, last && i + 1 == count);
+        const size_t size = std::min(kChunkSize, used - i * kChunkSize);
+        bool written =
+            file.write(std::string_view(reinterpret_cast<const char*>(nonce.data()), nonce.size())) &&
+            file.write(std::string_view(batch.get() + i * kChunkSize, size)) &&
+            file.write(std::string_view(reinterpret_cast<const char*>(tags[i].data()), tags[i].size()));
+        failed = failed || !written;
+    }
+    index += count;
+    used = 0;
+}
+
+/**
+ * @brief Добавляет открытый текст
+ * @param data Данные
+ * @return false если ранее произошла ошибка записи
+ */
+bool EncryptedFileWriter::write(std::string_view data) {
+    while (!data.empty()) {
+        // A full buffer is sealed only once more data arrives: the last chunk
+        // has to carry the final flag, and it may be full
+        if (used == capacity) {
+            sealBatch(false);
+        }
+        size_t take = std::min(data.size(), capacity - used);
+        std::memcpy(batch.get() + used, data.data(), take);
+        used += take;
+        data.remove_prefix(take);
+    }
+    return !failed;
+}
+
+/**
+ * @brief Шифрует последний кусок и закрывает файл
+ * @return true если все данные записаны успешно
+ */
+bool EncryptedFileWriter::close() {
+    sealBatch(true);
+    return file.close() && !failed;
+}
+
+/**
+ * @brief Создает закрытый объект чтения
+ */
+EncryptedFileReader::EncryptedFileReader() : key{}, chunkPayload(0), chunks(0), plainSize(0) {}
+
+/**
+ * @brief Затирает ключ
+ */
+EncryptedFileReader::~EncryptedFileReader() {
+    std::fill(key.begin(), key.end(), 0);
+}
+
+/**
+ * @brief Открывает файл и проверяет пароль
+ * @param path Путь к файлу
+ * @param password Пароль
+ * @return Результат открытия
+ */
+EncryptedFileStatus EncryptedFileReader::open(const std::string& path, std::string_view password) {
+    if (auto mapped = MappedFile::open(path)) {
+        bytes = mapped->bytes();
+        owner = std::move(mapped);
+    } else {
+        std::error_code error;
+        uintmax_t size = std::filesystem::file_size(path, error);
+        std::ifstream file(path, std::ios::binary);
+        if (error || !file.is_open()) return EncryptedFileStatus::Unreadable;
+        auto text = std::make_shared<std::string>(static_cast<size_t>(size), '\0');
+        if (size > 0 && !file.read(&(*text)[0], static_cast<std::streamsize>(size))) {
+            return EncryptedFileStatus::Unreadable;
+        }
+        bytes = *text;
+        owner = std::move(text);
+    }
+
+    if (bytes.size() < kHeaderSize || !isEncryptedFile(bytes)) {
+        return EncryptedFileStatus::NotEncrypted;
+    }
+    const uint32_t version = loadWord(bytes.data() + 8);
+    const uint32_t iterations = loadWord(bytes.data() + 12);
+    chunkPayload = loadWord(bytes.data() + 16);
+    // The header is checked before the slow key derivation it controls
+    if (version != kVersion || iterations == 0 || iterations > kMaxKdfIterations ||
+        chunkPayload != EncryptedFileWriter::kChunkSize) {
+        return EncryptedFileStatus::Corrupted;
+    }
+
+    std::array<uint8_t, kSaltSize> salt;
+    std::memcpy(salt.data(), bytes.data() + 20, salt.size());
+    FileKeys keys = deriveFileKeys(password, salt, iterations);
+    key = keys.key;
+    std::fill(keys.key.begin(), keys.key.end(), 0);
+    const auto* storedCheck = reinterpret_cast<const uint8_t*>(bytes.data() + 20 + kSaltSize);
+    if (!constantTimeEqual(keys.check.data(), storedCheck, keys.check.size())) {
+        return EncryptedFileStatus::WrongPassword;
+    }
+
+    // Every chunk but the last is full; the last one still carries a nonce and a tag
+    const size_t payload = bytes.size() - kHeaderSize;
+    const size_t record = chunkPayload + kChunkOverhead;
+    const size_t remainder = payload % record;
+    if (payload < kChunkOverhead || (remainder > 0 && remainder < kChunkOverhead)) {
+        return EncryptedFileStatus::Corrupted;
+    }
+    chunks = payload / record + (remainder > 0 ? 1 : 0);
+    plainSize = payload - chunks * kChunkOverhead;
+    return EncryptedFileStatus::Ok;
+}
+
+/**
+ * @brief Возвращает размер открытого текста
+ * @return Размер в байтах
+ */
+uint64_t EncryptedFileReader::size() const {
+    return plainSize;
+}
+
+/**
+ * @brief Возвращает количество кусков
+ * @return Количество кусков (не меньше 1 у открытого файла)
+ */
+size_t EncryptedFileReader::chunkCount() const {
+    return chunks;
+}
+
+/**
+ * @brief Возвращает размер открытого текста куска
+ * @param index Номер куска
+ * @return Размер в байтах
+ */
+size_t EncryptedFileReader::chunkSize(size_t index) const {
+    if (index + 1 < chunks) return chunkPayload;
+    return static_cast<size_t>(plainSize - uint64_t(chunks - 1) * chunkPayload);
+}
+
+/**
+ * @brief Аутентифицирует и расшифровывает один кусок
+ * @param index Номер куска
+ * @param out Буфер не меньше chunkSize(index) байт
+ * @return false если кусок поврежден или подменен
+ */
+bool EncryptedFileReader::readChunk(size_t index, char* out) const {
+    if (index >= chunks) return false;
+    const char* record = bytes.data() + kHeaderSize + index * (chunkPayload + kChunkOverhead);
+    const size_t size = chunkSize(index);
+
+    const auto nonce = chunkNonce(index, index + 1 == chunks);
+    if (std::memcmp(record, nonce.data(), nonce.size()) != 0) {
+        return false;
+    }
+    std::memcpy(out, record + kNonceSize, size);
+    const auto* tag = reinterpret_cast<const uint8_t*>(record + kNonceSize + size);
+    return openChaCha20Poly1305(key.data(), nonce.data(), bytes.data(), kHeaderSize, out, size, tag);
+}
+
+/**
+ * @brief Расшифровывает весь файл
+ *
+ * Куски распределяются по потокам пула; после первого куска, не прошедшего
+ * проверку, остальные потоки прекращают работу.
+ *
+ * @param out Буфер не меньше size() байт
+ * @param pool Пул потоков (nullptr - в вызывающем потоке)
+ * @param threads Наибольшее число участвующих потоков (0 - все потоки пула)
+ * @return false если какой-либо кусок поврежден или подменен
+ */
+bool EncryptedFileReader::readAll(char* out, ThreadPool* pool, size_t threads) const {
+    std::atomic<bool> failed{false};
+    auto open = [&](size_t from, size_t to) {
+        for (size_t i = from; i < to && !failed.load(std::memory_order_relaxed); ++i) {
+            if (!readChunk(i, out + i * chunkPayload)) {
+                failed.store(true, std::memory_order_relaxed);
+            }
+        }
+    };
+    if (pool) {
+        pool->parallelFor(0, chunks, 1, open, threads);
+    } else {
+        open(0, chunks);
+    }
+    return !failed.load();
+}
+
+/**
+ * @brief Читает произвольный диапазон открытого текста
+ *
+ * Расшифровываются только куски, пересекающие диапазон.
+ *
+ * @param offset Смещение в открытом тексте
+ * @param out Буфер для данных
+ * @param size Размер диапазона
+ * @return false если диапазон выходит за конец или кусок поврежден
+ */
+bool EncryptedFileReader::read(uint64_t offset, char* out, size_t size) const {
+    if (offset > plainSize || size > plainSize - offset) return false;
+
+    std::unique_ptr<char[]> partial;
+    while (size > 0) {
+        const size_t index = static_cast<size_t>(offset / chunkPayload);
+        const size_t from = static_cast<size_t>(offset % chunkPayload);
+        const size_t available = chunkSize(index) - from;
+        const size_t take = std::min(size, available);
+        if (from == 0 && take == chunkSize(index)) {
+            if (!readChunk(index, out)) return false;
+        } else {
+            if (!partial) partial.reset(new char[chunkPayload]);
+            if (!readChunk(index, partial.get())) return false;
+            std::memcpy(out, partial.get() + from, take);
+        }
+        out += take;
+        offset += take;
+        size -= take;
+    }
+    return true;
+}
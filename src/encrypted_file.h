@@ -0,0 +1,246 @@
+#ifndef ENCRYPTED_FILE_H
+#define ENCRYPTED_FILE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "file_writer.h"
+#include "thread_pool.h"
+
+/**
+ * @file encrypted_file.h
+ * @brief Зашифрованный файл из независимо аутентифицируемых кусков
+ *
+ * Формат (все числа little-endian):
+ * - заголовок kHeaderSize байт: сигнатура "TXTCRYPT", версия, число итераций
+ *   PBKDF2, размер куска, соль и контрольное значение ключа;
+ * - куски: одноразовое число (12 байт), шифртекст ChaCha20 (kChunkSize байт,
+ *   последний кусок короче или пуст) и код Poly1305 (16 байт).
+ *
+ * Одноразовое число куска содержит его номер и признак последнего куска, а
+ * заголовок входит в аутентифицируемые данные каждого куска: перестановка,
+ * удаление кусков или подмена параметров заголовка обнаруживаются. Неверный
+ * пароль распознается по контрольному значению ключа без обращения к кускам.
+ */
+
+/**
+ * @brief Ключи, выведенные из пароля
+ */
+struct FileKeys {
+    std::array<uint8_t, 32> key;   ///< Ключ шифрования кусков
+    std::array<uint8_t, 16> check; ///< Контрольное значение для проверки пароля
+};
+
+/// Размер соли в байтах
+constexpr size_t kSaltSize = 16;
+
+/// Число итераций PBKDF2 по умолчанию
+constexpr uint32_t kDefaultKdfIterations = 100000;
+
+/// Наибольшее число итераций PBKDF2: заголовок не аутентифицирован до проверки
+/// пароля, и большее число из чужого файла надолго заняло бы вывод ключа
+constexpr uint32_t kMaxKdfIterations = 10 * kDefaultKdfIterations;
+
+/**
+ * @brief Создает случайную соль
+ * @return Соль
+ */
+std::array<uint8_t, kSaltSize> makeSalt();
+
+/**
+ * @brief Выводит ключ шифрования и контрольное значение из пароля
+ *
+ * PBKDF2-HMAC-SHA256 выполняется один раз; ключ и контрольное значение
+ * получаются из его результата HMAC с разными метками, поэтому контрольное
+ * значение ничего не сообщает о ключе.
+ *
+ * @param password Пароль
+ * @param salt Соль
+ * @param iterations Число итераций PBKDF2
+ * @return Ключи
+ */
+FileKeys deriveFileKeys(std::string_view password, const std::array<uint8_t, kSaltSize>& salt,
+                        uint32_t iterations);
+
+/**
+ * @brief Проверяет, начинаются ли данные с сигнатуры зашифрованного файла
+ * @param bytes Начало файла
+ * @return true если это зашифрованный файл
+ */
+bool isEncryptedFile(std::string_view bytes);
+
+/**
+ * @class EncryptedFileWriter
+ * @brief Потоковая запись зашифрованного файла
+ *
+ * Открытый текст накапливается в буфере из нескольких кусков; заполненный
+ * буфер шифруется (куски - параллельно на пуле потоков) и записывается, как
+ * только становится известно, что в нем нет последнего куска.
+ */
+class EncryptedFileWriter {
+public:
+    static constexpr size_t kChunkSize = 64 << 10; ///< Размер открытого текста в куске
+
+    /**
+     * @brief Создает закрытый объект записи
+     * @param pool Пул потоков для шифрования кусков (nullptr - в вызывающем потоке)
+     * @param threads Наибольшее число участвующих потоков (0 - все потоки пула)
+     */
+    explicit EncryptedFileWriter(ThreadPool* pool = nullptr, size_t threads = 0);
+
+    /**
+     * @brief Затирает ключ и буфер куска
+     */
+    ~EncryptedFileWriter();
+
+    EncryptedFileWriter(const EncryptedFileWriter&) = delete;
+    EncryptedFileWriter& operator=(const EncryptedFileWriter&) = delete;
+
+    /**
+     * @brief Создает файл, выводит ключ из пароля и записывает заголовок
+     * @param path Путь к файлу
+     * @param password Пароль
+     * @param iterations Число итераций PBKDF2 (от 1 до kMaxKdfIterations)
+     * @return true если файл открыт
+     */
+    bool open(const std::string& path, std::string_view password,
+              uint32_t iterations = kDefaultKdfIterations);
+
+    /**
+     * @brief Добавляет открытый текст
+     * @param data Данные
+     * @return false если ранее произошла ошибка записи
+     */
+    bool write(std::string_view data);
+
+    /**
+     * @brief Шифрует последний кусок и закрывает файл
+     * @return true если все данные записаны успешно
+     */
+    bool close();
+
+private:
+    /**
+     * @brief Шифрует и записывает накопленные куски
+     * @param last Содержит ли буфер последний кусок
+     */
+    void sealBatch(bool last);
+
+    ThreadPool* pool;              ///< Пул потоков для шифрования (может отсутствовать)
+    size_t threads;                ///< Наибольшее число потоков пула (0 - все)
+    FileWriter file;               ///< Файл
+    std::array<uint8_t, 32> key;   ///< Ключ шифрования кусков
+    std::string header;            ///< Заголовок (аутентифицируется в каждом куске)
+    std::unique_ptr<char[]> batch; ///< Открытый текст накапливаемых кусков
+    size_t capacity;               ///< Размер буфера (целое число кусков)
+    size_t used;                   ///< Заполненная часть буфера
+    uint64_t index;                ///< Номер первого куска в буфере
+    bool failed;                   ///< Признак ошибки записи
+};
+
+/**
+ * @brief Результат открытия зашифрованного файла
+ */
+enum class EncryptedFileStatus {
+    Ok,            ///< Файл открыт
+    Unreadable,    ///< Файл не удалось прочитать
+    NotEncrypted,  ///< Нет сигнатуры зашифрованного файла
+    WrongPassword, ///< Контрольное значение ключа не совпало
+    Corrupted      ///< Нарушена структура файла
+};
+
+/**
+ * @class EncryptedFileReader
+ * @brief Чтение зашифрованного файла с расшифровкой кусков по требованию
+ *
+ * Файл отображается в память; при открытии проверяются только заголовок и
+ * пароль, а каждый кусок аутентифицируется и расшифровывается при обращении.
+ */
+class EncryptedFileReader {
+public:
+    /**
+     * @brief Создает закрытый объект чтения
+     */
+    EncryptedFileReader();
+
+    /**
+     * @brief Затирает ключ
+     */
+    ~EncryptedFileReader();
+
+    EncryptedFileReader(const EncryptedFileReader&) = delete;
+    EncryptedFileReader& operator=(const EncryptedFileReader&) = delete;
+
+    /**
+     * @brief Открывает файл и проверяет пароль
+     * @param path Путь к файлу
+     * @param password Пароль
+     * @return Результат открытия
+     */
+    EncryptedFileStatus open(const std::string& path, std::string_view password);
+
+    /**
+     * @brief Возвращает размер открытого текста
+     * @return Размер в байтах
+     */
+    uint64_t size() const;
+
+    /**
+     * @brief Возвращает количество кусков
+     * @return Количество кусков (не меньше 1 у открытого файла)
+     */
+    size_t chunkCount() const;
+
+    /**
+     * @brief Возвращает размер открытого текста куска
+     * @param index Номер куска
+     * @return Размер в байтах
+     */
+    size_t chunkSize(size_t index) const;
+
+    /**
+     * @brief Аутентифицирует и расшифровывает один кусок
+     * @param index Номер куска
+     * @param out Буфер не меньше chunkSize(index) байт
+     * @return false если кусок поврежден или подменен
+     */
+    bool readChunk(size_t index, char* out) const;
+
+    /**
+     * @brief Расшифровывает весь файл
+     *
+     * Куски распределяются по потокам пула; после первого куска, не прошедшего
+     * проверку, остальные потоки прекращают работу.
+     *
+     * @param out Буфер не меньше size() байт
+     * @param pool Пул потоков (nullptr - в вызывающем потоке)
+     * @param threads Наибольшее число участвующих потоков (0 - все потоки пула)
+     * @return false если какой-либо кусок поврежден или подменен
+     */
+    bool readAll(char* out, ThreadPool* pool = nullptr, size_t threads = 0) const;
+
+    /**
+     * @brief Читает произвольный диапазон открытого текста
+     *
+     * Расшифровываются только куски, пересекающие диапазон.
+     *
+     * @param offset Смещение в открытом тексте
+     * @param out Буфер для данных
+     * @param size Размер диапазона
+     * @return false если диапазон выходит за конец или кусок поврежден
+     */
+    bool read(uint64_t offset, char* out, size_t size) const;
+
+private:
+    std::shared_ptr<const void> owner; ///< Владелец байтов файла
+    std::string_view bytes;            ///< Содержимое файла
+    std::array<uint8_t, 32> key;       ///< Ключ шифрования кусков
+    size_t chunkPayload;               ///< Размер открытого текста полного куска
+    size_t chunks;                     ///< Количество кусков
+    uint64_t plainSize;                ///< Размер открытого текста
+};
+
+#endif // ENCRYPTED_FILE_H
@@ -1,16 +1,159 @@
 
 #include "editor.h"
+#include "encrypted_file.h"
+#include "file_writer.h"
+#include "mapped_file.h"
+#include "text_kernels.h"
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <filesystem>
 #include <locale>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TEXT_EDITOR_HAS_POSIX_IO 1
+#endif
+
+namespace {
+
+/// Файлы не меньше этого размера отображаются в память, меньшие читаются целиком
+constexpr uintmax_t kMapThreshold = 1 << 20;
+
+/// Наибольшее количество строк, форматируемых в буфер для одной записи в поток
+constexpr size_t kRenderBlockLines = 1024;
+
+/**
+ * @brief Читает файл целиком в один буфер
+ * @param filePath Путь к файлу
+ * @param size Размер файла
+ * @param block Блок, в который помещается содержимое
+ * @return true при успешном чтении
+ */
+bool readWholeFile(const std::string& filePath, uintmax_t size, TextBlock& block) {
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    auto text = std::make_shared<std::string>(static_cast<size_t>(size), '\0');
+    if (size > 0 && !file.read(&(*text)[0], static_cast<std::streamsize>(size))) {
+        return false;
+    }
+    block.bytes = std::string_view(*text);
+    block.owner = std::move(text);
+    return true;
+}
+
+/**
+ * @brief Записывает строки документа, завершая каждую переводом строки
+ * @param storage Хранилище строк
+ * @param file Открытый объект записи (FileWriter или EncryptedFileWriter)
+ * @return true если все данные записаны и файл закрыт успешно
+ */
+template <typename Writer>
+bool writeLines(const TextStorage& storage, Writer& file) {
+    storage.forEachLine(0, storage.lineCount(), [&](size_t, std::string_view line) {
+        file.write(line);
+        file.write("\n");
+    });
+    return file.close();
+}
+
+/**
+ * @brief Находит файл, который на самом деле заменит сохранение
+ * @param filePath Путь для сохранения
+ * @return Путь, у которого разрешены символические ссылки в последнем компоненте
+ */
+std::filesystem::path resolveSaveTarget(const std::string& filePath) {
+    // Saving through a symlink replaces the file it points to, not the link
+    std::filesystem::path target = filePath;
+    std::error_code error;
+    for (int hops = 0; hops < 40 && std::filesystem::is_symlink(target, error); ++hops) {
+        std::filesystem::path link = std::filesystem::read_symlink(target, error);
+        if (error) break;
+        target = link.is_absolute() ? link : target.parent_path() / link;
+    }
+    return target;
+}
+
+/**
+ * @brief Создает новый временный файл в каталоге целевого
+ *
+ * На POSIX имя выбирает mkstemp, файл получает права и владельца заменяемого
+ * файла (для нового файла - 0666 без umask).
+ *
+ * @param target Заменяемый файл
+ * @param tempPath Путь созданного файла
+ * @return false если файл не создан
+ */
+bool createTempFile(const std::filesystem::path& target, std::string& tempPath) {
+    const std::filesystem::path directory = target.parent_path();
+    const std::string name = "." + target.filename().string();
+#ifdef TEXT_EDITOR_HAS_POSIX_IO
+    std::string pattern = (directory / (name + ".XXXXXX")).string();
+    const int fd = ::mkstemp(&pattern[0]);
+    if (fd < 0) return false;
+    struct stat existing;
+    bool ok;
+    if (::stat(target.c_str(), &existing) == 0) {
+        // Changing the owner needs privileges; without them the caller keeps ownership
+        [[maybe_unused]] const int owned = ::fchown(fd, existing.st_uid, existing.st_gid);
+        ok = ::fchmod(fd, existing.st_mode & 07777) == 0;
+    } else {
+        const mode_t mask = ::umask(0);
+        ::umask(mask);
+        ok = ::fchmod(fd, 0666 & ~mask) == 0;
+    }
+    ::close(fd);
+    if (!ok) {
+        ::unlink(pattern.c_str());
+        return false;
+    }
+    tempPath = pattern;
+    return true;
+#else
+    std::error_code error;
+    for (unsigned attempt = 0; attempt < 1000; ++attempt) {
+        std::filesystem::path candidate = directory / (name + "." + std::to_string(attempt) + ".tmp");
+        if (!std::filesystem::exists(candidate, error)) {
+            tempPath = candidate.string();
+            return true;
+        }
+    }
+    return false;
+#endif
+}
+
+/**
+ * @brief Сбрасывает содержимое файла на диск
+ * @param path Путь к файлу
+ * @return false при ошибке
+ */
+bool syncFile(const std::string& path) {
+#ifdef TEXT_EDITOR_HAS_POSIX_IO
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    const bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#else
+    (void)path;
+    return true;
+#endif
+}
+
+} // namespace
+
 /**
  * @brief Создает новый файл (очищает текущее содержимое)
  */
 void TextEditor::createNewFile() {
-    saveState();
-    lines.clear();
+    replaceDocument(makeTextStorage(storageEngine));
     currentFilePath.clear();
+    highlighter.setLanguage(languageFromPath(currentFilePath));
+    pendingEncryptedPath.clear();
     clearPassword();
     unsavedChanges = true;
     std::cout << "New file created\n";
@@ -22,27 +165,108 @@ void TextEditor::createNewFile() {
  * @return true при успешной загрузке, false при ошибке
  */
 bool TextEditor::loadFile(const std::string& filePath) {
-    std::ifstream file(filePath);
-    if (!file.is_open()) {
+    // Only the most recent load attempt can be waiting for a password
+    pendingEncryptedPath.clear();
+    std::error_code error;
+    uintmax_t size = std::filesystem::file_size(filePath, error);
+    if (error) {
         std::cerr << "Error: Unable to open file\n";
         return false;
     }
 
-    saveState();
-    lines.clear();
-    std::string line;
+    // Большие файлы отображаются в память: строки остаются представлениями
+    // внутри отображения и не копируются
+    TextBlock block;
+    if (size >= kMapThreshold) {
+        if (auto mapped = MappedFile::open(filePath)) {
+            block.bytes = mapped->bytes();
+            block.owner = std::move(mapped);
+        }
+    }
+    if (!block.owner && !readWholeFile(filePath, size, block)) {
+        std::cerr << "Error: Unable to read file\n";
+        return false;
+    }
 
-    while (std::getline(file, line)) {
-        lines.push_back(line);
+    if (isEncryptedFile(block.bytes)) {
+        // The contents are decrypted straight into the document once the password is known
+        pendingEncryptedPath = filePath;
+        std::cerr << "Error: File is encrypted, use decrypt to open it\n";
+        return false;
     }
 
-    currentFilePath = filePath;
     clearPassword();
-    unsavedChanges = false;
+    openDocument(std::move(block), filePath);
     std::cout << "File loaded: " << filePath << "\n";
     return true;
 }
 
+/**
+ * @brief Загружает зашифрованный файл, расшифровывая куски сразу в документ
+ * @param filePath Путь к файлу
+ * @param password Пароль
+ * @return true при успешной загрузке, false при неверном пароле или ошибке
+ */
+bool TextEditor::loadEncryptedFile(const std::string& filePath, const std::string& password) {
+    EncryptedFileReader reader;
+    switch (reader.open(filePath, password)) {
+        case EncryptedFileStatus::Ok: break;
+        case EncryptedFileStatus::WrongPassword:
+            std::cerr << "Error: Wrong password\n";
+            return false;
+        case EncryptedFileStatus::Unreadable:
+            std::cerr << "Error: Unable to read file\n";
+            return false;
+        case EncryptedFileStatus::NotEncrypted:
+        case EncryptedFileStatus::Corrupted:
+            std::cerr << "Error: Encrypted file is corrupted\n";
+            return false;
+    }
+
+    // The plain text exists only once, in the block that becomes the document
+    const size_t size = static_cast<size_t>(reader.size());
+    std::shared_ptr<char> text(new char[size], std::default_delete<char[]>());
+    const size_t threads = getThreadCount(BulkOperation::Encryption);
+    if (!reader.readAll(text.get(), threads > 1 ? &pool() : nullptr, threads)) {
+        std::memset(text.get(), 0, size);
+        std::cerr << "Error: Encrypted file is corrupted\n";
+        return false;
+    }
+
+    TextBlock block;
+    block.bytes = std::string_view(text.get(), size);
+    block.owner = std::move(text);
+    openDocument(std::move(block), filePath);
+    tempPassword = password;
+    std::cout << "File loaded: " << filePath << " (decrypted)\n";
+    return true;
+}
+
+/**
+ * @brief Делает блок текста, прочитанный из файла, текущим документом
+ * @param block Содержимое файла
+ * @param filePath Путь к файлу
+ */
+void TextEditor::openDocument(TextBlock block, const std::string& filePath) {
+    std::vector<LineSpan> spans;
+    scanLines(block.bytes.data(), block.bytes.size(), spans);
+    // Line breaks are whitespace, so counting the raw file gives the per-line total
+    size_t words = countWords(block.bytes.data(), block.bytes.size());
+
+    std::unique_ptr<TextStorage> document = makeTextStorage(storageEngine);
+    document->assignBlock(std::move(block), std::move(spans));
+    replaceDocument(std::move(document), words);
+    if (wordIndexEnabled) {
+        wordIndex.build(*buffer);
+    }
+    ensureTrigramIndex();
+
+    currentFilePath = filePath;
+    highlighter.setLanguage(languageFromPath(currentFilePath));
+    pendingEncryptedPath.clear();
+    unsavedChanges = false;
+}
+
 /**
  * @brief Сохраняет файл по текущему пути
  * @return true при успешном сохранении, false при ошибке
@@ -61,19 +285,48 @@ bool TextEditor::saveToFile() {
  * @return true при успешном сохранении, false при ошибке
  */
 bool TextEditor::saveToFile(const std::string& filePath) {
-    std::ofstream file(filePath);
-    if (!file.is_open()) {
+    pendingEncryptedPath.clear();
+    // Запись идет в новый временный файл, который затем заменяет целевой: исходный
+    // файл может быть отображен в память и не должен меняться под открытым документом
+    const std::filesystem::path target = resolveSaveTarget(filePath);
+    std::string tempPath;
+    if (!createTempFile(target, tempPath)) {
         std::cerr << "Error: Unable to save file\n";
         return false;
     }
+    bool written;
+    if (tempPassword.empty()) {
+        // Строки копируются в буфер записи размером 1 МБ, который уходит в файл
+        // одним системным вызовом; длинные строки пишутся напрямую
+        FileWriter file;
+        written = file.open(tempPath) && writeLines(*buffer, file);
+    } else {
+        // Строки шифруются кусками по мере записи (куски - параллельно),
+        // без копии всего документа
+        const size_t threads = getThreadCount(BulkOperation::Encryption);
+        EncryptedFileWriter file(threads > 1 ? &pool() : nullptr, threads);
+        written = file.open(tempPath, tempPassword) && writeLines(*buffer, file);
+    }
 
-    for (const auto& line : lines) {
-        file << line << "\n";
+    std::error_code error;
+    // The data must be on disk before the rename makes it the file's only copy
+    if (!written || !syncFile(tempPath)) {
+        std::cerr << "Error: Unable to save file\n";
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+
+    std::filesystem::rename(tempPath, target, error);
+    if (error) {
+        std::cerr << "Error: Unable to save file\n";
+        std::filesystem::remove(tempPath, error);
+        return false;
     }
 
     currentFilePath = filePath;
+    highlighter.setLanguage(languageFromPath(currentFilePath));
     unsavedChanges = false;
-    std::cout << "File saved: " << filePath << "\n";
+    std::cout << "File saved: " << filePath << (tempPassword.empty() ? "\n" : " (encrypted)\n");
     return true;
 }
 
@@ -81,8 +334,8 @@ bool TextEditor::saveToFile(const std::string& filePath) {
  * @brief Очищает текущий текст
  */
 void TextEditor::clearText() {
-    saveState();
-    lines.clear();
+    replaceDocument(makeTextStorage(storageEngine));
+    pendingEncryptedPath.clear();
     clearPassword();
     unsavedChanges = true;
     std::cout << "Text cleared\n";
@@ -92,13 +345,115 @@ void TextEditor::clearText() {
  * @brief Отображает текущий текст с нумерацией строк
  */
 void TextEditor::displayText() const {
-    if (lines.empty()) {
+    displayText(1, buffer->lineCount());
+}
+
+/**
+ * @brief Отображает диапазон строк с нумерацией
+ * @param firstLine Номер первой строки (начиная с 1)
+ * @param lastLine Номер последней строки (включительно; обрезается до количества строк)
+ * @return true при успешном выводе, false при неверном диапазоне
+ */
+bool TextEditor::displayText(size_t firstLine, size_t lastLine) const {
+    if (buffer->lineCount() == 0) {
         std::cout << "(File is empty)\n";
-        return;
+        return true;
+    }
+    if (firstLine < 1 || firstLine > lastLine || firstLine > buffer->lineCount()) {
+        std::cerr << "Error: Invalid line range\n";
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    const size_t first = firstLine - 1;
+    const size_t last = std::min(lastLine, buffer->lineCount());
+    if (highlightEnabled) {
+        // Only the shown lines are highlighted; the document itself is never modified
+        ensureHighlight(first, last);
+    }
+    size_t width = 1;
+    for (size_t n = last; n >= 10; n /= 10) ++width;
+    // A screen is one write; longer ranges are written block by block
+    for (size_t from = first; from < last; from += kRenderBlockLines) {
+        renderLines(from, std::min(last, from + kRenderBlockLines), width, screen);
+        std::cout.write(screen.data(), static_cast<std::streamsize>(screen.size()));
     }
-    for (size_t i = 0; i < lines.size(); ++i) {
-        std::cout << i + 1 << ": " << lines[i] << "\n";
+    renderTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    return true;
+}
+
+/**
+ * @brief Форматирует строки [first, last) с колонкой номеров в буфер вывода
+ * @param first Первая строка
+ * @param last Строка за последней
+ * @param width Ширина колонки номеров
+ * @param out Буфер, содержимое которого заменяется
+ */
+void TextEditor::renderLines(size_t first, size_t last, size_t width, std::string& out) const {
+    // Every token adds one color sequence and one reset
+    size_t size = 0;
+    buffer->forEachLine(first, last, [&](size_t i, std::string_view line) {
+        size += width + 3 + line.size();
+        if (highlightEnabled) size += highlighter.tokens(i).size() * 16;
+    });
+    out.clear();
+    out.reserve(size);
+
+    char number[24];
+    buffer->forEachLine(first, last, [&](size_t i, std::string_view line) {
+        char* digits = number + sizeof(number);
+        size_t n = i + 1;
+        do {
+            *--digits = static_cast<char>('0' + n % 10);
+            n /= 10;
+        } while (n > 0);
+        const size_t length = static_cast<size_t>(number + sizeof(number) - digits);
+        out.append(width > length ? width - length : 0, ' ');
+        out.append(digits, length);
+        out.append(": ");
+        if (highlightEnabled) {
+            SyntaxHighlighter::render(line, highlighter.tokens(i), out);
+        } else {
+            out.append(line.data(), line.size());
+        }
+        out.push_back('\n');
+    });
+}
+
+/**
+ * @brief Возвращает время подготовки и вывода последнего диапазона строк
+ * @return Длительность последнего вызова displayText
+ */
+std::chrono::nanoseconds TextEditor::getLastRenderTime() const {
+    return renderTime;
+}
+
+/**
+ * @brief Передает строки диапазона и их лексемы без копирования
+ * @param firstLine Номер первой строки (начиная с 1)
+ * @param lastLine Номер последней строки (включительно; обрезается до количества строк)
+ * @param visitor Функция, получающая индекс строки (с 0), строку и лексемы
+ */
+void TextEditor::visitLines(size_t firstLine, size_t lastLine,
+                            const std::function<void(size_t, std::string_view, const std::vector<TokenSpan>&)>& visitor) const {
+    if (firstLine < 1 || firstLine > lastLine || firstLine > buffer->lineCount()) return;
+    const size_t first = firstLine - 1;
+    const size_t last = std::min(lastLine, buffer->lineCount());
+    static const std::vector<TokenSpan> noTokens;
+    if (highlightEnabled) {
+        ensureHighlight(first, last);
     }
+    buffer->forEachLine(first, last, [&](size_t i, std::string_view line) {
+        visitor(i, line, highlightEnabled ? highlighter.tokens(i) : noTokens);
+    });
+}
+
+/**
+ * @brief Возвращает путь к текущему файлу
+ * @return Путь или пустая строка для нового документа
+ */
+const std::string& TextEditor::getFilePath() const {
+    return currentFilePath;
 }
 
 /**
@@ -110,10 +465,35 @@ bool TextEditor::hasUnsavedChanges() const {
 }
 
 /**
- * @brief Возвращает ссылку на текущие строки текста
- * @return Константная ссылка на вектор строк
+ * @brief Проверяет, ждет ли зашифрованный файл пароля для загрузки
+ * @return true если последняя загрузка остановилась на зашифрованном файле
  */
-const std::vector<std::string>& TextEditor::getLines() const {
-    return lines;
+bool TextEditor::hasPendingEncryptedFile() const {
+    return !pendingEncryptedPath.empty();
+}
+
+/**
+ * @brief Возвращает копию текущих строк текста
+ * @return Вектор строк документа
+ */
+std::vector<std::string> TextEditor::getLines() const {
+    std::vector<std::string> result;
+    result.reserve(buffer->lineCount());
+    buffer->forEachLine(0, buffer->lineCount(), [&](size_t, std::string_view line) {
+        result.emplace_back(line);
+    });
+    return result;
+}
+
+/**
+ * @brief Возвращает одну строку текста без копирования всего документа
+ * @param lineNumber Номер строки (начиная с 1)
+ * @return Содержимое строки или пустая строка при неверном номере
+ */
+std::string TextEditor::getLine(size_t lineNumber) const {
+    if (lineNumber < 1 || lineNumber > buffer->lineCount()) {
+        return std::string();
+    }
+    return std::string(buffer->line(lineNumber - 1));
 }
 
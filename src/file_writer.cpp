@@ -0,0 +1,136 @@
+#include "file_writer.h"
+#include <cerrno>
+#include <cstdio>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#define TEXT_EDITOR_HAS_POSIX_IO 1
+#endif
+
+namespace {
+
+/// Выравнивание буфера записи (размер страницы)
+constexpr std::align_val_t kBufferAlignment{4096};
+
+} // namespace
+
+/**
+ * @brief Освобождает выровненный буфер
+ * @param p Указатель на буфер
+ */
+void FileWriter::AlignedDelete::operator()(char* p) const {
+    ::operator delete[](p, kBufferAlignment);
+}
+
+/**
+ * @brief Создает закрытый объект записи
+ */
+FileWriter::FileWriter()
+    : buffer(static_cast<char*>(::operator new[](kBufferSize, kBufferAlignment))),
+      used(0), failed(false), fd(-1), stream(nullptr) {}
+
+/**
+ * @brief Закрывает файл, если он еще открыт (несохраненные данные теряются)
+ */
+FileWriter::~FileWriter() {
+#ifdef TEXT_EDITOR_HAS_POSIX_IO
+    if (fd >= 0) ::close(fd);
+#else
+    if (stream) std::fclose(static_cast<std::FILE*>(stream));
+#endif
+}
+
+/**
+ * @brief Создает (или очищает) файл для записи
+ * @param path Путь к файлу
+ * @return true если файл открыт
+ */
+bool FileWriter::open(const std::string& path) {
+    // A file left open by an earlier open() is closed, its buffered data discarded
+    used = 0;
+    failed = false;
+#ifdef TEXT_EDITOR_HAS_POSIX_IO
+    if (fd >= 0) ::close(fd);
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    return fd >= 0;
+#else
+    if (stream) std::fclose(static_cast<std::FILE*>(stream));
+    // Binary mode: ciphertext and \r bytes must reach the file unchanged
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file) std::setvbuf(file, nullptr, _IONBF, 0);
+    stream = file;
+    return file != nullptr;
+#endif
+}
+
+/**
+ * @brief Записывает данные, не поместившиеся в буфер
+ * @param data Записываемые байты
+ * @return false при ошибке записи
+ */
+bool FileWriter::writeSlow(std::string_view data) {
+    if (!flush()) return false;
+    if (data.size() >= kBypassSize) {
+        return writeRaw(data.data(), data.size());
+    }
+    std::memcpy(buffer.get(), data.data(), data.size());
+    used = data.size();
+    return !failed;
+}
+
+/**
+ * @brief Отправляет содержимое буфера в файл
+ * @return false при ошибке записи
+ */
+bool FileWriter::flush() {
+    if (used == 0) return !failed;
+    bool ok = writeRaw(buffer.get(), used);
+    used = 0;
+    return ok;
+}
+
+/**
+ * @brief Записывает байты в файл, повторяя частичные записи
+ * @param data Начало данных
+ * @param size Размер данных
+ * @return false при ошибке записи
+ */
+bool FileWriter::writeRaw(const char* data, size_t size) {
+    if (failed) return false;
+#ifdef TEXT_EDITOR_HAS_POSIX_IO
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            failed = true;
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+#else
+    if (std::fwrite(data, 1, size, static_cast<std::FILE*>(stream)) != size) {
+        failed = true;
+        return false;
+    }
+#endif
+    return true;
+}
+
+/**
+ * @brief Дописывает остаток буфера и закрывает файл
+ * @return true если все данные записаны успешно
+ */
+bool FileWriter::close() {
+    bool ok = flush();
+#ifdef TEXT_EDITOR_HAS_POSIX_IO
+    if (fd >= 0 && ::close(fd) != 0) ok = false;
+    fd = -1;
+#else
+    if (stream && std::fclose(static_cast<std::FILE*>(stream)) != 0) ok = false;
+    stream = nullptr;
+#endif
+    return ok && !failed;
+}
@@ -0,0 +1,103 @@
+#ifndef FILE_WRITER_H
+#define FILE_WRITER_H
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+
+/**
+ * @class FileWriter
+ * @brief Буферизованная запись в файл крупными блоками
+ *
+ * Данные копируются в выровненный буфер размером kBufferSize и отправляются
+ * в файл одним системным вызовом на каждый заполненный буфер. Фрагменты,
+ * не меньшие kBypassSize, пишутся напрямую без копирования.
+ */
+class FileWriter {
+public:
+    static constexpr size_t kBufferSize = 1 << 20;  ///< Размер буфера записи
+    static constexpr size_t kBypassSize = 64 << 10; ///< Порог прямой записи фрагмента
+
+    /**
+     * @brief Создает закрытый объект записи
+     */
+    FileWriter();
+
+    /**
+     * @brief Закрывает файл, если он еще открыт (несохраненные данные теряются)
+     */
+    ~FileWriter();
+
+    FileWriter(const FileWriter&) = delete;
+    FileWriter& operator=(const FileWriter&) = delete;
+
+    /**
+     * @brief Создает (или очищает) файл для записи
+     *
+     * Ранее открытый файл закрывается, его недописанный буфер теряется.
+     * Файл пишется в двоичном режиме, без преобразования переводов строк.
+     *
+     * @param path Путь к файлу
+     * @return true если файл открыт
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief Добавляет данные в файл
+     * @param data Записываемые байты
+     * @return false если ранее произошла ошибка записи
+     */
+    bool write(std::string_view data) {
+        if (data.size() <= kBufferSize - used) {
+            std::memcpy(buffer.get() + used, data.data(), data.size());
+            used += data.size();
+            return !failed;
+        }
+        return writeSlow(data);
+    }
+
+    /**
+     * @brief Дописывает остаток буфера и закрывает файл
+     * @return true если все данные записаны успешно
+     */
+    bool close();
+
+private:
+    /**
+     * @brief Освобождает выровненный буфер
+     */
+    struct AlignedDelete {
+        void operator()(char* p) const;
+    };
+
+    std::unique_ptr<char[], AlignedDelete> buffer; ///< Буфер записи
+    size_t used;  ///< Заполненная часть буфера
+    bool failed;  ///< Признак ошибки записи
+    int fd;       ///< Дескриптор файла (POSIX)
+    void* stream; ///< Поток C (платформы без POSIX)
+
+    /**
+     * @brief Записывает данные, не поместившиеся в буфер
+     * @param data Записываемые байты
+     * @return false при ошибке записи
+     */
+    bool writeSlow(std::string_view data);
+
+    /**
+     * @brief Отправляет содержимое буфера в файл
+     * @return false при ошибке записи
+     */
+    bool flush();
+
+    /**
+     * @brief Записывает байты в файл, повторяя частичные записи
+     * @param data Начало данных
+     * @param size Размер данных
+     * @return false при ошибке записи
+     */
+    bool writeRaw(const char* data, size_t size);
+};
+
+#endif // FILE_WRITER_H
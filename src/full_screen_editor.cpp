@@ -0,0 +1,464 @@
+#include "full_screen_editor.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+/**
+ * @brief Возвращает цвет ячейки для вида лексемы
+ * @param kind Вид лексемы
+ * @return Цвет
+ */
+CellColor tokenColor(TokenKind kind) {
+    switch (kind) {
+        case TokenKind::Keyword: return CellColor::Keyword;
+        case TokenKind::Number: return CellColor::Number;
+        case TokenKind::String: return CellColor::String;
+        case TokenKind::Comment: return CellColor::Comment;
+    }
+    return CellColor::Default;
+}
+
+/**
+ * @brief Проверяет, является ли байт продолжением символа UTF-8
+ * @param c Байт
+ * @return true для байтов 10xxxxxx
+ */
+bool isContinuation(char c) {
+    return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+} // namespace
+
+/**
+ * @brief Создает режим для документа
+ * @param editor Редактор, документ которого показывается и изменяется
+ * @param rows Количество строк экрана
+ * @param columns Количество столбцов экрана
+ */
+FullScreenEditor::FullScreenEditor(TextEditor& editor, size_t rows, size_t columns)
+    : editor(editor), next(rows, columns), line(0), offset(0), goalColumn(0), top(0), left(0),
+      quitArmed(false), frameTime(0) {}
+
+/**
+ * @brief Меняет размер экрана (следующий кадр выводится целиком)
+ * @param rows Количество строк
+ * @param columns Количество столбцов
+ */
+void FullScreenEditor::resize(size_t rows, size_t columns) {
+    next = ScreenBuffer(rows, columns);
+}
+
+/**
+ * @brief Перемещает курсор в начало строки
+ * @param lineNumber Номер строки (начиная с 1; обрезается до количества строк)
+ */
+void FullScreenEditor::goToLine(size_t lineNumber) {
+    const size_t count = editor.getLineCount();
+    line = count == 0 ? 0 : std::min(lineNumber > 0 ? lineNumber - 1 : 0, count - 1);
+    offset = 0;
+    goalColumn = 0;
+}
+
+/**
+ * @brief Обрабатывает нажатие клавиши
+ * @param key Клавиша
+ * @return false если пользователь вышел из режима
+ */
+bool FullScreenEditor::handleKey(const Key& key) {
+    if (key.type != KeyType::Quit) quitArmed = false;
+    status.clear();
+    const size_t page = std::max<size_t>(1, next.rows() > 2 ? next.rows() - 2 : 1);
+
+    switch (key.type) {
+        case KeyType::Char:
+            insertText(key.text);
+            break;
+        case KeyType::Enter:
+            splitLine();
+            break;
+        case KeyType::Backspace:
+            deleteBackward();
+            break;
+        case KeyType::Delete:
+            deleteForward();
+            break;
+        case KeyType::Up:
+            if (line > 0) moveToLine(line - 1);
+            return true;
+        case KeyType::Down:
+            moveToLine(line + 1);
+            return true;
+        case KeyType::PageUp:
+            moveToLine(line > page ? line - page : 0);
+            return true;
+        case KeyType::PageDown:
+            moveToLine(line + page);
+            return true;
+        case KeyType::Left:
+            if (offset > 0) {
+                std::string text = currentLine();
+                do --offset; while (offset > 0 && isContinuation(text[offset]));
+            } else if (line > 0) {
+                --line;
+                offset = currentLine().size();
+            }
+            break;
+        case KeyType::Right: {
+            std::string text = currentLine();
+            if (offset < text.size()) {
+                offset = std::min(text.size(), offset + utf8Length(static_cast<unsigned char>(text[offset])));
+            } else if (line + 1 < editor.getLineCount()) {
+                ++line;
+                offset = 0;
+            }
+            break;
+        }
+        case KeyType::Home:
+            offset = 0;
+            break;
+        case KeyType::End:
+            offset = currentLine().size();
+            break;
+        case KeyType::Save:
+            if (editor.getFilePath().empty()) {
+                status = "Error: No file name; use saveas in command mode";
+            } else {
+                runQuietly([this] { editor.saveToFile(); });
+            }
+            break;
+        case KeyType::Quit:
+            if (editor.hasUnsavedChanges() && !quitArmed) {
+                quitArmed = true;
+                status = "Unsaved changes: press Ctrl-Q again to quit";
+                return true;
+            }
+            return false;
+        case KeyType::Undo:
+            runQuietly([this] { editor.undo(); });
+            clampCursor();
+            break;
+        case KeyType::Redo:
+            runQuietly([this] { editor.redo(); });
+            clampCursor();
+            break;
+        case KeyType::Escape:
+        case KeyType::None:
+            return true;
+    }
+    // Horizontal movement and edits set the column kept by vertical movement
+    goalColumn = columnOf(currentLine(), offset);
+    return true;
+}
+
+/**
+ * @brief Строит следующий кадр и дописывает его отличия от показанного
+ * @param out Строка, к которой добавляется вывод для терминала
+ * @return Количество выведенных ячеек
+ */
+size_t FullScreenEditor::render(std::string& out) {
+    auto start = std::chrono::steady_clock::now();
+    const size_t rows = next.rows();
+    const size_t columns = next.columns();
+    const size_t textRows = rows > 0 ? rows - 1 : 0;
+    const size_t lineCount = editor.getLineCount();
+    size_t gutter = 2;
+    for (size_t n = std::max<size_t>(lineCount, 1); n >= 10; n /= 10) ++gutter;
+    const size_t textWidth = columns > gutter ? columns - gutter : 0;
+
+    // Scroll just enough to keep the cursor visible
+    const size_t column = columnOf(currentLine(), offset);
+    if (line < top) {
+        top = line;
+    } else if (textRows > 0 && line >= top + textRows) {
+        top = line - textRows + 1;
+    }
+    if (column < left) {
+        left = column;
+    } else if (textWidth > 0 && column >= left + textWidth) {
+        left = column - textWidth + 1;
+    }
+
+    next.clear();
+    if (textRows > 0 && lineCount > 0) {
+        editor.visitLines(top + 1, top + textRows,
+                          [&](size_t index, std::string_view text, const std::vector<TokenSpan>& tokens) {
+            drawLine(index - top, gutter, index, text, tokens);
+        });
+    }
+    if (rows > 0) drawStatus(column + 1);
+
+    const size_t cursorRow = std::min(line - top, textRows > 0 ? textRows - 1 : 0);
+    const size_t cursorColumn = std::min(gutter + column - left, columns > 0 ? columns - 1 : 0);
+    size_t drawn = diffScreens(shown, next, cursorRow, cursorColumn, out);
+    std::swap(shown, next);
+    if (next.rows() != rows || next.columns() != columns) {
+        next = ScreenBuffer(rows, columns);
+    }
+    frameTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    return drawn;
+}
+
+/**
+ * @brief Работает с терминалом до выхода пользователя
+ * @param terminal Терминал в неканоническом режиме
+ */
+void FullScreenEditor::run(RawTerminal& terminal) {
+    if (!terminal.isActive()) return;
+    size_t rows = next.rows();
+    size_t columns = next.columns();
+    terminal.size(rows, columns);
+    resize(rows, columns);
+
+    KeyDecoder decoder;
+    std::string out;
+    char input[4096];
+    bool dirty = true;
+    while (true) {
+        if (dirty) {
+            out.clear();
+            render(out);
+            terminal.write(out);
+            dirty = false;
+        }
+
+        Key key;
+        size_t count = terminal.read(input, sizeof(input), kEscapeTimeoutMs);
+        if (count == 0) {
+            // A lone Esc is only known once no continuation arrives
+            if (decoder.expire(key)) {
+                if (!handleKey(key)) return;
+                dirty = true;
+            }
+        } else {
+            decoder.feed(std::string_view(input, count));
+            while (decoder.next(key)) {
+                if (!handleKey(key)) return;
+                dirty = true;
+            }
+        }
+
+        size_t newRows, newColumns;
+        if (terminal.size(newRows, newColumns) && (newRows != rows || newColumns != columns)) {
+            rows = newRows;
+            columns = newColumns;
+            resize(rows, columns);
+            dirty = true;
+        }
+    }
+}
+
+/**
+ * @brief Возвращает строку курсора
+ * @return Содержимое строки (пустое для пустого документа)
+ */
+std::string FullScreenEditor::currentLine() const {
+    return editor.getLine(line + 1);
+}
+
+/**
+ * @brief Заменяет строку курсора (в пустом документе добавляет строку)
+ * @param text Новое содержимое
+ */
+void FullScreenEditor::setCurrentLine(const std::string& text) {
+    if (editor.getLineCount() == 0) {
+        editor.addLine(text);
+    } else {
+        editor.replaceLine(line + 1, text);
+    }
+}
+
+/**
+ * @brief Вставляет текст в позицию курсора
+ * @param text Текст без переводов строки
+ */
+void FullScreenEditor::insertText(const std::string& text) {
+    std::string current = currentLine();
+    current.insert(offset, text);
+    setCurrentLine(current);
+    offset += text.size();
+}
+
+/**
+ * @brief Разбивает строку в позиции курсора
+ */
+void FullScreenEditor::splitLine() {
+    std::string current = currentLine();
+    std::string tail = current.substr(offset);
+    current.resize(offset);
+    setCurrentLine(current);
+    editor.insertLine(line + 2, tail);
+    ++line;
+    offset = 0;
+}
+
+/**
+ * @brief Удаляет символ слева от курсора или склеивает строку с предыдущей
+ */
+void FullScreenEditor::deleteBackward() {
+    std::string current = currentLine();
+    if (offset > 0) {
+        size_t from = offset - 1;
+        while (from > 0 && isContinuation(current[from])) --from;
+        current.erase(from, offset - from);
+        setCurrentLine(current);
+        offset = from;
+    } else if (line > 0) {
+        std::string previous = editor.getLine(line);
+        editor.replaceLine(line, previous + current);
+        editor.deleteLine(line + 1);
+        --line;
+        offset = previous.size();
+    }
+}
+
+/**
+ * @brief Удаляет символ справа от курсора или склеивает строку со следующей
+ */
+void FullScreenEditor::deleteForward() {
+    std::string current = currentLine();
+    if (offset < current.size()) {
+        current.erase(offset, std::min(current.size() - offset,
+                                       utf8Length(static_cast<unsigned char>(current[offset]))));
+        setCurrentLine(current);
+    } else if (line + 1 < editor.getLineCount()) {
+        editor.replaceLine(line + 1, current + editor.getLine(line + 2));
+        editor.deleteLine(line + 2);
+    }
+}
+
+/**
+ * @brief Перемещает курсор на строку, сохраняя столбец
+ * @param target Индекс строки (обрезается до количества строк)
+ */
+void FullScreenEditor::moveToLine(size_t target) {
+    const size_t count = editor.getLineCount();
+    if (count == 0) return;
+    line = std::min(target, count - 1);
+    offset = offsetOf(currentLine(), goalColumn);
+}
+
+/**
+ * @brief Возвращает курсор в пределы документа (после отмены правок)
+ */
+void FullScreenEditor::clampCursor() {
+    const size_t count = editor.getLineCount();
+    if (count == 0) {
+        line = 0;
+        offset = 0;
+        return;
+    }
+    line = std::min(line, count - 1);
+    std::string text = currentLine();
+    offset = std::min(offset, text.size());
+    while (offset > 0 && offset < text.size() && isContinuation(text[offset])) --offset;
+}
+
+/**
+ * @brief Выполняет действие TextEditor, показывая его вывод в строке состояния
+ * @param action Действие, печатающее сообщения в std::cout и std::cerr
+ */
+void FullScreenEditor::runQuietly(const std::function<void()>& action) {
+    // Messages would scroll the raw screen; the last one goes to the status bar instead
+    std::ostringstream captured;
+    std::streambuf* savedOut = std::cout.rdbuf(captured.rdbuf());
+    std::streambuf* savedErr = std::cerr.rdbuf(captured.rdbuf());
+    action();
+    std::cout.rdbuf(savedOut);
+    std::cerr.rdbuf(savedErr);
+
+    std::string text = captured.str();
+    while (!text.empty() && text.back() == '\n') text.pop_back();
+    status = text.substr(text.rfind('\n') + 1);
+}
+
+/**
+ * @brief Выводит строку документа в строку экрана
+ * @param row Строка экрана
+ * @param gutter Ширина колонки номеров
+ * @param index Индекс строки документа
+ * @param text Содержимое строки
+ * @param tokens Лексемы подсветки
+ */
+void FullScreenEditor::drawLine(size_t row, size_t gutter, size_t index, std::string_view text,
+                                const std::vector<TokenSpan>& tokens) {
+    char number[24];
+    int length = std::snprintf(number, sizeof(number), "%*zu ", static_cast<int>(gutter - 1), index + 1);
+    next.write(row, 0, std::string_view(number, static_cast<size_t>(length)), CellColor::Gutter);
+
+    const size_t columns = next.columns();
+    size_t screenColumn = gutter;
+    size_t column = 0;
+    size_t token = 0;
+    for (size_t i = 0; i < text.size() && screenColumn < columns;) {
+        const size_t size = std::min(utf8Length(static_cast<unsigned char>(text[i])), text.size() - i);
+        while (token < tokens.size() && tokens[token].offset + tokens[token].length <= i) ++token;
+        const CellColor color = token < tokens.size() && tokens[token].offset <= i
+                                    ? tokenColor(tokens[token].kind) : CellColor::Default;
+        const bool tab = text[i] == '\t';
+        const size_t width = tab ? kTabWidth - column % kTabWidth : 1;
+        for (size_t w = 0; w < width && screenColumn < columns; ++w, ++column) {
+            if (column < left) continue;
+            screenColumn = next.write(row, screenColumn, tab ? std::string_view(" ") : text.substr(i, size), color);
+        }
+        i += size;
+    }
+}
+
+/**
+ * @brief Выводит строку состояния
+ * @param column Столбец курсора на экране текста (начиная с 1)
+ */
+void FullScreenEditor::drawStatus(size_t column) {
+    const size_t row = next.rows() - 1;
+    const std::string& path = editor.getFilePath();
+    char position[96];
+    std::snprintf(position, sizeof(position), "  Ln %zu/%zu, Col %zu  %.3f ms",
+                  line + 1, std::max<size_t>(editor.getLineCount(), 1), column,
+                  std::chrono::duration<double, std::milli>(frameTime).count());
+
+    std::string text = " ";
+    text += path.empty() ? "[New file]" : path;
+    if (editor.hasUnsavedChanges()) text += " [+]";
+    text += position;
+    if (!status.empty()) {
+        text += "  ";
+        text += status;
+    }
+    next.fill(row, 0, next.columns(), CellColor::Status);
+    next.write(row, 0, text, CellColor::Status);
+}
+
+/**
+ * @brief Возвращает экранный столбец смещения в строке
+ * @param text Строка
+ * @param bytes Смещение в байтах
+ * @return Столбец с учетом табуляции
+ */
+size_t FullScreenEditor::columnOf(std::string_view text, size_t bytes) {
+    size_t column = 0;
+    for (size_t i = 0; i < std::min(bytes, text.size()); i += utf8Length(static_cast<unsigned char>(text[i]))) {
+        column += text[i] == '\t' ? kTabWidth - column % kTabWidth : 1;
+    }
+    return column;
+}
+
+/**
+ * @brief Возвращает смещение символа, занимающего экранный столбец
+ * @param text Строка
+ * @param column Столбец
+ * @return Смещение в байтах (длина строки, если она короче)
+ */
+size_t FullScreenEditor::offsetOf(std::string_view text, size_t column) {
+    size_t at = 0;
+    size_t i = 0;
+    while (i < text.size()) {
+        const size_t width = text[i] == '\t' ? kTabWidth - at % kTabWidth : 1;
+        if (at + width > column) break;
+        at += width;
+        i = std::min(text.size(), i + utf8Length(static_cast<unsigned char>(text[i])));
+    }
+    return i;
+}
@@ -0,0 +1,195 @@
+#ifndef FULL_SCREEN_EDITOR_H
+#define FULL_SCREEN_EDITOR_H
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include "editor.h"
+#include "screen_buffer.h"
+#include "terminal.h"
+
+/**
+ * @class FullScreenEditor
+ * @brief Полноэкранный режим редактирования документа TextEditor
+ *
+ * Каждый кадр строится в модели экрана (ScreenBuffer) только из видимых
+ * строк; в терминал выводятся только ячейки, изменившиеся с прошлого кадра,
+ * поэтому нажатие клавиши стоит несколько десятков байтов вывода независимо
+ * от размера файла. Правки выполняются через построчные методы TextEditor и
+ * попадают в общий журнал отмены. Последняя строка экрана - строка состояния.
+ */
+class FullScreenEditor {
+public:
+    /// Ширина табуляции на экране
+    static constexpr size_t kTabWidth = 4;
+
+    /// Время ожидания продолжения escape-последовательности в миллисекундах
+    static constexpr int kEscapeTimeoutMs = 50;
+
+    /**
+     * @brief Создает режим для документа
+     * @param editor Редактор, документ которого показывается и изменяется
+     * @param rows Количество строк экрана
+     * @param columns Количество столбцов экрана
+     */
+    FullScreenEditor(TextEditor& editor, size_t rows, size_t columns);
+
+    /**
+     * @brief Меняет размер экрана (следующий кадр выводится целиком)
+     * @param rows Количество строк
+     * @param columns Количество столбцов
+     */
+    void resize(size_t rows, size_t columns);
+
+    /**
+     * @brief Обрабатывает нажатие клавиши
+     * @param key Клавиша
+     * @return false если пользователь вышел из режима
+     */
+    bool handleKey(const Key& key);
+
+    /**
+     * @brief Строит следующий кадр и дописывает его отличия от показанного
+     * @param out Строка, к которой добавляется вывод для терминала
+     * @return Количество выведенных ячеек
+     */
+    size_t render(std::string& out);
+
+    /**
+     * @brief Возвращает последний построенный кадр
+     * @return Модель экрана
+     */
+    const ScreenBuffer& frame() const { return shown; }
+
+    /**
+     * @brief Перемещает курсор в начало строки
+     * @param lineNumber Номер строки (начиная с 1; обрезается до количества строк)
+     */
+    void goToLine(size_t lineNumber);
+
+    /**
+     * @brief Возвращает номер строки курсора
+     * @return Номер строки (начиная с 1)
+     */
+    size_t getCursorLine() const { return line + 1; }
+
+    /**
+     * @brief Возвращает позицию курсора в строке
+     * @return Смещение в байтах от начала строки
+     */
+    size_t getCursorOffset() const { return offset; }
+
+    /**
+     * @brief Возвращает время построения и сравнения последнего кадра
+     * @return Длительность последнего вызова render
+     */
+    std::chrono::nanoseconds getLastFrameTime() const { return frameTime; }
+
+    /**
+     * @brief Работает с терминалом до выхода пользователя
+     *
+     * Кадр выводится одной записью только после нажатий клавиш или смены
+     * размера окна; нажатия, пришедшие одним чтением, дают один кадр.
+     *
+     * @param terminal Терминал в неканоническом режиме
+     */
+    void run(RawTerminal& terminal);
+
+private:
+    TextEditor& editor;   ///< Редактируемый документ
+    ScreenBuffer shown;   ///< Кадр, показанный в терминале
+    ScreenBuffer next;    ///< Строящийся кадр
+    size_t line;          ///< Индекс строки курсора
+    size_t offset;        ///< Смещение курсора в строке в байтах
+    size_t goalColumn;    ///< Столбец, который курсор сохраняет при движении по строкам
+    size_t top;           ///< Индекс первой видимой строки
+    size_t left;          ///< Первый видимый столбец текста
+    std::string status;   ///< Сообщение в строке состояния
+    bool quitArmed;       ///< Выход с несохраненными изменениями подтверждается повторным Ctrl-Q
+    std::chrono::nanoseconds frameTime; ///< Время последнего кадра
+
+    /**
+     * @brief Возвращает строку курсора
+     * @return Содержимое строки (пустое для пустого документа)
+     */
+    std::string currentLine() const;
+
+    /**
+     * @brief Заменяет строку курсора (в пустом документе добавляет строку)
+     * @param text Новое содержимое
+     */
+    void setCurrentLine(const std::string& text);
+
+    /**
+     * @brief Вставляет текст в позицию курсора
+     * @param text Текст без переводов строки
+     */
+    void insertText(const std::string& text);
+
+    /**
+     * @brief Разбивает строку в позиции курсора
+     */
+    void splitLine();
+
+    /**
+     * @brief Удаляет символ слева от курсора или склеивает строку с предыдущей
+     */
+    void deleteBackward();
+
+    /**
+     * @brief Удаляет символ справа от курсора или склеивает строку со следующей
+     */
+    void deleteForward();
+
+    /**
+     * @brief Перемещает курсор на строку, сохраняя столбец
+     * @param target Индекс строки (обрезается до количества строк)
+     */
+    void moveToLine(size_t target);
+
+    /**
+     * @brief Возвращает курсор в пределы документа (после отмены правок)
+     */
+    void clampCursor();
+
+    /**
+     * @brief Выполняет действие TextEditor, показывая его вывод в строке состояния
+     * @param action Действие, печатающее сообщения в std::cout и std::cerr
+     */
+    void runQuietly(const std::function<void()>& action);
+
+    /**
+     * @brief Выводит строку документа в строку экрана
+     * @param row Строка экрана
+     * @param gutter Ширина колонки номеров
+     * @param index Индекс строки документа
+     * @param text Содержимое строки
+     * @param tokens Лексемы подсветки
+     */
+    void drawLine(size_t row, size_t gutter, size_t index, std::string_view text,
+                  const std::vector<TokenSpan>& tokens);
+
+    /**
+     * @brief Выводит строку состояния
+     * @param column Столбец курсора на экране текста (начиная с 1)
+     */
+    void drawStatus(size_t column);
+
+    /**
+     * @brief Возвращает экранный столбец смещения в строке
+     * @param text Строка
+     * @param bytes Смещение в байтах
+     * @return Столбец с учетом табуляции
+     */
+    static size_t columnOf(std::string_view text, size_t bytes);
+
+    /**
+     * @brief Возвращает смещение символа, занимающего экранный столбец
+     * @param text Строка
+     * @param column Столбец
+     * @return Смещение в байтах (длина строки, если она короче)
+     */
+    static size_t offsetOf(std::string_view text, size_t column);
+};
+
+#endif // FULL_SCREEN_EDITOR_H
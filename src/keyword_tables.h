@@ -0,0 +1,137 @@
+#ifndef KEYWORD_TABLES_H
+#define KEYWORD_TABLES_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @file keyword_tables.h
+ * @brief Таблицы ключевых слов с совершенным хешированием, построенные при компиляции
+ *
+ * Ключ слова составляется из его длины и пяти байтов (двух первых, среднего
+ * и двух последних) и хешируется умножением со сдвигом. Множитель подбирается
+ * при компиляции так, чтобы ключевые слова не сталкивались; проверка слова -
+ * одно умножение, чтение ячейки и одно сравнение строк.
+ */
+
+/**
+ * @brief Составляет 64-битный ключ слова для хеширования
+ * @param word Непустое слово
+ * @return Ключ из длины и пяти байтов слова
+ */
+constexpr uint64_t keywordKey(std::string_view word) {
+    const size_t n = word.size();
+    auto at = [&](size_t i) { return static_cast<uint64_t>(static_cast<unsigned char>(word[i])); };
+    return static_cast<uint64_t>(n & 0xFF) | at(0) << 8 | at(n > 1 ? 1 : 0) << 16 | at(n / 2) << 24 |
+           at(n > 1 ? n - 2 : 0) << 32 | at(n - 1) << 40;
+}
+
+/**
+ * @class KeywordTable
+ * @brief Совершенная хеш-таблица множества ключевых слов
+ * @tparam N Количество слов
+ * @tparam Bits Логарифм числа ячеек
+ */
+template <size_t N, unsigned Bits>
+struct KeywordTable {
+    static_assert(N < 256, "slots store word numbers in one byte");
+
+    std::array<std::string_view, N> words{};      ///< Ключевые слова
+    std::array<uint8_t, size_t(1) << Bits> slots{}; ///< Ячейка -> номер слова + 1 (0 - пусто)
+    uint64_t multiplier = 0;                      ///< Нечетный множитель хеш-функции
+    size_t minLength = 0;                         ///< Длина самого короткого слова
+    size_t maxLength = 0;                         ///< Длина самого длинного слова
+
+    /**
+     * @brief Вычисляет ячейку ключа
+     * @param key Ключ слова
+     * @return Номер ячейки
+     */
+    constexpr size_t slot(uint64_t key) const {
+        return static_cast<size_t>((key * multiplier) >> (64 - Bits));
+    }
+
+    /**
+     * @brief Возвращает номер слова в таблице
+     * @param word Слово
+     * @return Индекс слова в words или -1, если слова нет в таблице
+     */
+    constexpr int find(std::string_view word) const {
+        if (word.size() < minLength || word.size() > maxLength) return -1;
+        uint8_t index = slots[slot(keywordKey(word))];
+        return index != 0 && words[index - 1] == word ? index - 1 : -1;
+    }
+
+    /**
+     * @brief Проверяет, является ли слово ключевым
+     * @param word Слово
+     * @return true если слово входит в таблицу
+     */
+    constexpr bool contains(std::string_view word) const {
+        return find(word) >= 0;
+    }
+};
+
+/**
+ * @brief Строит таблицу, подбирая множитель без столкновений
+ *
+ * Если множитель не находится, вычисление доходит до throw и компиляция
+ * завершается ошибкой.
+ *
+ * @tparam Bits Логарифм числа ячеек
+ * @param words Различные непустые ключевые слова
+ * @return Таблица
+ */
+template <unsigned Bits, size_t N>
+constexpr KeywordTable<N, Bits> makeKeywordTable(const std::array<std::string_view, N>& words) {
+    for (uint64_t seed = 0; seed < 100000; ++seed) {
+        KeywordTable<N, Bits> table{};
+        table.words = words;
+        table.multiplier = (seed * 2 + 1) * 0x9E3779B97F4A7C15ull;
+        table.minLength = words[0].size();
+        table.maxLength = words[0].size();
+        bool collision = false;
+        for (size_t i = 0; i < N && !collision; ++i) {
+            size_t slot = table.slot(keywordKey(words[i]));
+            collision = table.slots[slot] != 0;
+            table.slots[slot] = static_cast<uint8_t>(i + 1);
+            table.minLength = words[i].size() < table.minLength ? words[i].size() : table.minLength;
+            table.maxLength = words[i].size() > table.maxLength ? words[i].size() : table.maxLength;
+        }
+        if (!collision) return table;
+    }
+    throw "no collision-free multiplier";
+}
+
+/// Ключевые слова C и C++
+constexpr auto kCppKeywords = makeKeywordTable<10>(std::array<std::string_view, 97>{
+    "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor", "bool", "break",
+    "case", "catch", "char", "char8_t", "char16_t", "char32_t", "class", "co_await",
+    "co_return", "co_yield", "compl", "concept", "const", "const_cast", "consteval",
+    "constexpr", "constinit", "continue", "decltype", "default", "delete", "do", "double",
+    "dynamic_cast", "else", "enum", "explicit", "export", "extern", "false", "final", "float",
+    "for", "friend", "goto", "if", "import", "inline", "int", "long", "module", "mutable",
+    "namespace", "new", "noexcept", "not", "not_eq", "nullptr", "operator", "or", "or_eq",
+    "override", "private", "protected", "public", "register", "reinterpret_cast",
+    "requires", "restrict", "return", "short", "signed", "sizeof", "static", "static_assert",
+    "static_cast", "struct", "switch", "template", "this", "thread_local", "throw", "true",
+    "try", "typedef", "typeid", "typename", "union", "unsigned", "using", "virtual", "void",
+    "volatile", "wchar_t", "while", "xor", "xor_eq"});
+
+/// Ключевые слова Python
+constexpr auto kPythonKeywords = makeKeywordTable<9>(std::array<std::string_view, 35>{
+    "False", "None", "True", "and", "as", "assert", "async", "await", "break", "class",
+    "continue", "def", "del", "elif", "else", "except", "finally", "for", "from", "global",
+    "if", "import", "in", "is", "lambda", "nonlocal", "not", "or", "pass", "raise", "return",
+    "try", "while", "with", "yield"});
+
+/// Ключевые слова и встроенные команды командной оболочки
+constexpr auto kShellKeywords = makeKeywordTable<9>(std::array<std::string_view, 34>{
+    "break", "case", "cd", "continue", "declare", "do", "done", "echo", "elif", "else", "esac",
+    "eval", "exec", "exit", "export", "fi", "for", "function", "if", "in", "local", "read",
+    "readonly", "return", "select", "set", "shift", "source", "then", "time", "trap", "unset",
+    "until", "while"});
+
+#endif // KEYWORD_TABLES_H
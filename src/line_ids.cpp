@@ -0,0 +1,201 @@
+#include "line_ids.h"
+#include <algorithm>
+#include <numeric>
+
+/**
+ * @brief Нумерует строки документа подряд: идентификатор равен номеру строки
+ * @param lineCount Количество строк
+ */
+void LineIds::reset(size_t lineCount) {
+    std::vector<uint32_t> order(lineCount);
+    std::iota(order.begin(), order.end(), 0u);
+    freeIds.clear();
+    places.assign(lineCount, Place());
+    assign(order);
+}
+
+/**
+ * @brief Освобождает память
+ */
+void LineIds::clear() {
+    std::vector<Block>().swap(blocks);
+    std::vector<Place>().swap(places);
+    std::vector<uint32_t>().swap(freeIds);
+    lineCount = 0;
+}
+
+/**
+ * @brief Возвращает идентификатор строки
+ * @param position Номер строки (начиная с 0)
+ * @return Идентификатор
+ */
+uint32_t LineIds::idAt(size_t position) const {
+    const Block& block = blocks[blockAt(position)];
+    return block.ids[position - block.before];
+}
+
+/**
+ * @brief Учитывает замену диапазона строк
+ * @param first Номер первой замененной строки
+ * @param removed Количество строк в диапазоне до замены
+ * @param added Количество строк в диапазоне после замены
+ * @return Идентификаторы строк диапазона после замены
+ */
+std::vector<uint32_t> LineIds::replace(size_t first, size_t removed, size_t added) {
+    size_t from = blockAt(first);
+    size_t to = removed ? blockAt(first + removed - 1) : from;
+    std::vector<uint32_t> merged;
+    for (size_t k = from; k <= to; ++k) {
+        merged.insert(merged.end(), blocks[k].ids.begin(), blocks[k].ids.end());
+    }
+    const size_t start = first - blocks[from].before;
+
+    // Lines that stay in the range keep their ids; the rest are freed or allocated
+    const size_t common = std::min(removed, added);
+    std::vector<uint32_t> ids(merged.begin() + start, merged.begin() + start + common);
+    for (size_t i = common; i < removed; ++i) {
+        freeIds.push_back(merged[start + i]);
+    }
+    for (size_t i = common; i < added; ++i) {
+        ids.push_back(allocate());
+    }
+    merged.erase(merged.begin() + start + common, merged.begin() + start + removed);
+    merged.insert(merged.begin() + start + common, ids.begin() + common, ids.end());
+    lineCount = lineCount - removed + added;
+
+    // Small blocks are merged with a neighbour so the block count stays near lineCount / kMaxBlock
+    if (merged.size() < kMaxBlock / 4 && to + 1 < blocks.size()) {
+        ++to;
+        merged.insert(merged.end(), blocks[to].ids.begin(), blocks[to].ids.end());
+    } else if (merged.size() < kMaxBlock / 4 && from > 0) {
+        --from;
+        merged.insert(merged.begin(), blocks[from].ids.begin(), blocks[from].ids.end());
+    }
+
+    const size_t oldCount = to - from + 1;
+    size_t newCount = (merged.size() + kMaxBlock / 2 - 1) / (kMaxBlock / 2);
+    if (merged.size() <= kMaxBlock) newCount = merged.empty() && blocks.size() > oldCount ? 0 : 1;
+    std::vector<Block> rebuilt(newCount);
+    for (size_t k = 0; k < newCount; ++k) {
+        rebuilt[k].ids.assign(merged.begin() + merged.size() * k / newCount,
+                              merged.begin() + merged.size() * (k + 1) / newCount);
+    }
+    blocks.erase(blocks.begin() + from, blocks.begin() + to + 1);
+    blocks.insert(blocks.begin() + from, std::make_move_iterator(rebuilt.begin()),
+                  std::make_move_iterator(rebuilt.end()));
+    refresh(from, newCount != oldCount, from + newCount);
+    return ids;
+}
+
+/**
+ * @brief Оставляет только указанные строки и сжимает идентификаторы
+ * @param kept Отсортированные номера сохраненных строк
+ * @return Таблица новых идентификаторов по старым (kDroppedLine для удаленных)
+ */
+std::vector<uint32_t> LineIds::retain(const std::vector<size_t>& kept) {
+    std::vector<uint32_t> order(kept.size());
+    std::vector<uint32_t> renumber(places.size(), kDroppedLine);
+    for (size_t i = 0; i < kept.size(); ++i) {
+        order[i] = idAt(kept[i]);
+        renumber[order[i]] = 0;
+    }
+    uint32_t next = 0;
+    for (uint32_t& id : renumber) {
+        if (id != kDroppedLine) id = next++;
+    }
+    for (uint32_t& id : order) {
+        id = renumber[id];
+    }
+
+    freeIds.clear();
+    places.assign(next, Place());
+    assign(order);
+    return renumber;
+}
+
+/**
+ * @brief Переводит список идентификаторов в отсортированные номера строк
+ * @param ids Список идентификаторов
+ * @return Отсортированные номера строк (начиная с 0)
+ */
+std::vector<size_t> LineIds::positions(const Postings& ids) const {
+    std::vector<size_t> result(ids.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+        result[i] = positionOf(ids[i]);
+    }
+    // Ids follow line order until lines are inserted in the middle
+    if (!std::is_sorted(result.begin(), result.end())) {
+        std::sort(result.begin(), result.end());
+    }
+    return result;
+}
+
+/**
+ * @brief Оценивает занимаемую память
+ * @return Размер в байтах
+ */
+size_t LineIds::memoryUsage() const {
+    return places.capacity() * sizeof(Place) + lineCount * sizeof(uint32_t) +
+           blocks.capacity() * sizeof(Block) + freeIds.capacity() * sizeof(uint32_t);
+}
+
+/**
+ * @brief Раскладывает идентификаторы по блокам заново
+ * @param order Идентификаторы в порядке строк
+ */
+void LineIds::assign(const std::vector<uint32_t>& order) {
+    lineCount = order.size();
+    // Half-full blocks leave room for inserts before the first split
+    const size_t count = std::max<size_t>(1, (order.size() + kMaxBlock / 2 - 1) / (kMaxBlock / 2));
+    blocks.assign(count, Block());
+    for (size_t k = 0; k < count; ++k) {
+        blocks[k].ids.assign(order.begin() + order.size() * k / count,
+                             order.begin() + order.size() * (k + 1) / count);
+    }
+    refresh(0, true, count);
+}
+
+/**
+ * @brief Находит блок, содержащий строку
+ * @param position Номер строки (не больше количества строк)
+ * @return Номер блока
+ */
+size_t LineIds::blockAt(size_t position) const {
+    auto it = std::upper_bound(blocks.begin(), blocks.end(), position,
+                               [](size_t value, const Block& block) { return value < block.before; });
+    return static_cast<size_t>(it - blocks.begin()) - 1;
+}
+
+/**
+ * @brief Выдает идентификатор для новой строки
+ * @return Идентификатор
+ */
+uint32_t LineIds::allocate() {
+    if (!freeIds.empty()) {
+        uint32_t id = freeIds.back();
+        freeIds.pop_back();
+        return id;
+    }
+    places.emplace_back();
+    return static_cast<uint32_t>(places.size() - 1);
+}
+
+/**
+ * @brief Обновляет положения идентификаторов и счетчики строк начиная с блока
+ * @param from Первый измененный блок
+ * @param renumberAll true если номера следующих блоков тоже изменились
+ * @param end Блок после последнего, чьи идентификаторы переместились
+ */
+void LineIds::refresh(size_t from, bool renumberAll, size_t end) {
+    size_t before = from > 0 ? blocks[from - 1].before + blocks[from - 1].ids.size() : 0;
+    for (size_t k = from; k < blocks.size(); ++k) {
+        Block& block = blocks[k];
+        block.before = before;
+        before += block.ids.size();
+        if (k < end || renumberAll) {
+            for (size_t j = 0; j < block.ids.size(); ++j) {
+                places[block.ids[j]] = Place{static_cast<uint32_t>(k), static_cast<uint32_t>(j)};
+            }
+        }
+    }
+}
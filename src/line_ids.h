@@ -0,0 +1,145 @@
+#ifndef LINE_IDS_H
+#define LINE_IDS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "postings.h"
+
+/**
+ * @class LineIds
+ * @brief Устойчивые идентификаторы строк для списков индексов поиска
+ *
+ * Списки индексов хранят идентификаторы строк, а не их номера, поэтому
+ * вставка или удаление строк не требует перенумерации списков. Порядок
+ * идентификаторов в документе хранится блоками по kMaxBlock; для каждого
+ * идентификатора известны блок и место в нем, а для блока - число строк перед
+ * ним. Правка диапазона стоит O(kMaxBlock + число блоков), номер строки по
+ * идентификатору вычисляется за O(1).
+ */
+class LineIds {
+public:
+    static constexpr size_t kMaxBlock = 1024; ///< Наибольший размер блока
+
+    /**
+     * @brief Нумерует строки документа подряд: идентификатор равен номеру строки
+     * @param lineCount Количество строк
+     */
+    void reset(size_t lineCount);
+
+    /**
+     * @brief Освобождает память
+     */
+    void clear();
+
+    /**
+     * @brief Возвращает количество строк
+     * @return Количество строк
+     */
+    size_t size() const { return lineCount; }
+
+    /**
+     * @brief Возвращает идентификатор строки
+     * @param position Номер строки (начиная с 0)
+     * @return Идентификатор
+     */
+    uint32_t idAt(size_t position) const;
+
+    /**
+     * @brief Возвращает номер строки по идентификатору
+     * @param id Идентификатор существующей строки
+     * @return Номер строки (начиная с 0)
+     */
+    size_t positionOf(uint32_t id) const {
+        const Place& place = places[id];
+        return blocks[place.block].before + place.offset;
+    }
+
+    /**
+     * @brief Учитывает замену диапазона строк
+     *
+     * Строки, оставшиеся на своих местах в диапазоне, сохраняют идентификаторы;
+     * идентификаторы удаленных строк освобождаются для повторного использования.
+     *
+     * @param first Номер первой замененной строки
+     * @param removed Количество строк в диапазоне до замены
+     * @param added Количество строк в диапазоне после замены
+     * @return Идентификаторы строк диапазона после замены
+     */
+    std::vector<uint32_t> replace(size_t first, size_t removed, size_t added);
+
+    /**
+     * @brief Оставляет только указанные строки и сжимает идентификаторы
+     *
+     * Новые идентификаторы назначаются в порядке старых, поэтому
+     * отсортированные списки после renumberPostings остаются отсортированными.
+     *
+     * @param kept Отсортированные номера сохраненных строк
+     * @return Таблица новых идентификаторов по старым (kDroppedLine для удаленных)
+     */
+    std::vector<uint32_t> retain(const std::vector<size_t>& kept);
+
+    /**
+     * @brief Переводит список идентификаторов в отсортированные номера строк
+     * @param ids Список идентификаторов
+     * @return Отсортированные номера строк (начиная с 0)
+     */
+    std::vector<size_t> positions(const Postings& ids) const;
+
+    /**
+     * @brief Оценивает занимаемую память
+     * @return Размер в байтах
+     */
+    size_t memoryUsage() const;
+
+private:
+    /**
+     * @brief Блок идентификаторов, идущих в документе подряд
+     */
+    struct Block {
+        std::vector<uint32_t> ids; ///< Идентификаторы в порядке строк
+        size_t before = 0;         ///< Количество строк в предыдущих блоках
+    };
+
+    /**
+     * @brief Положение идентификатора
+     */
+    struct Place {
+        uint32_t block = 0;  ///< Номер блока
+        uint32_t offset = 0; ///< Место в блоке
+    };
+
+    std::vector<Block> blocks;      ///< Блоки в порядке документа
+    std::vector<Place> places;      ///< Положение по идентификатору
+    std::vector<uint32_t> freeIds;  ///< Освобожденные идентификаторы
+    size_t lineCount = 0;           ///< Количество строк
+
+    /**
+     * @brief Раскладывает идентификаторы по блокам заново
+     * @param order Идентификаторы в порядке строк
+     */
+    void assign(const std::vector<uint32_t>& order);
+
+    /**
+     * @brief Находит блок, содержащий строку
+     * @param position Номер строки (не больше количества строк)
+     * @return Номер блока
+     */
+    size_t blockAt(size_t position) const;
+
+    /**
+     * @brief Выдает идентификатор для новой строки
+     * @return Идентификатор
+     */
+    uint32_t allocate();
+
+    /**
+     * @brief Обновляет положения идентификаторов и счетчики строк начиная с блока
+     * @param from Первый измененный блок
+     * @param renumberAll true если номера следующих блоков тоже изменились
+     * @param end Блок после последнего, чьи идентификаторы переместились
+     */
+    void refresh(size_t from, bool renumberAll, size_t end);
+};
+
+#endif // LINE_IDS_H
@@ -0,0 +1,65 @@
+#include "mapped_file.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TEXT_EDITOR_HAS_MMAP 1
+#endif
+
+/**
+ * @brief Создает объект для уже выполненного отображения
+ * @param address Адрес отображения
+ * @param length Размер отображения
+ */
+MappedFile::MappedFile(void* address, size_t length) : address(address), length(length) {}
+
+/**
+ * @brief Снимает отображение
+ */
+MappedFile::~MappedFile() {
+#ifdef TEXT_EDITOR_HAS_MMAP
+    munmap(address, length);
+#endif
+}
+
+/**
+ * @brief Отображает файл в память
+ * @param path Путь к файлу
+ * @return Отображение или nullptr, если файл нельзя отобразить
+ */
+std::shared_ptr<const MappedFile> MappedFile::open(const std::string& path) {
+#ifdef TEXT_EDITOR_HAS_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0) {
+        close(fd);
+        return nullptr;
+    }
+
+    int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE;
+#endif
+    size_t length = static_cast<size_t>(info.st_size);
+    void* address = mmap(nullptr, length, PROT_READ, flags, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) return nullptr;
+
+    return std::shared_ptr<const MappedFile>(new MappedFile(address, length));
+#else
+    (void)path;
+    return nullptr;
+#endif
+}
+
+/**
+ * @brief Возвращает содержимое файла
+ * @return Представление отображенных байт
+ */
+std::string_view MappedFile::bytes() const {
+    return std::string_view(static_cast<const char*>(address), length);
+}
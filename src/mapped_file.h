@@ -0,0 +1,55 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+/**
+ * @class MappedFile
+ * @brief Файл, отображенный в память только для чтения
+ *
+ * Содержимое подгружается операционной системой по мере обращения к страницам,
+ * поэтому открытие большого файла не требует копирования его в память процесса.
+ * Файл не должен усекаться другими процессами, пока отображение существует;
+ * редактор сохраняет файлы через временный файл и переименование, поэтому
+ * собственные сохранения отображение не затрагивают.
+ */
+class MappedFile {
+public:
+    /**
+     * @brief Отображает файл в память
+     * @param path Путь к файлу
+     * @return Отображение или nullptr, если файл нельзя отобразить
+     *         (ошибка открытия, пустой файл или платформа без mmap)
+     */
+    static std::shared_ptr<const MappedFile> open(const std::string& path);
+
+    /**
+     * @brief Снимает отображение
+     */
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Возвращает содержимое файла
+     * @return Представление отображенных байт
+     */
+    std::string_view bytes() const;
+
+private:
+    /**
+     * @brief Создает объект для уже выполненного отображения
+     * @param address Адрес отображения
+     * @param length Размер отображения
+     */
+    MappedFile(void* address, size_t length);
+
+    void* address; ///< Адрес отображения
+    size_t length; ///< Размер отображения в байтах
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,202 @@
+#include "piece_table.h"
+#include <algorithm>
+#include <stdexcept>
+
+/**
+ * @brief Создает пустую таблицу
+ */
+PieceTable::PieceTable()
+    : originalSpans(std::make_shared<const std::vector<LineSpan>>()),
+      totalLines(0), totalBytes(0) {}
+
+/**
+ * @brief Делает блок исходным буфером таблицы без копирования
+ * @param block Блок текста документа
+ * @param spans Положения строк в блоке
+ */
+void PieceTable::assignBlock(TextBlock block, std::vector<LineSpan> spans) {
+    totalBytes = 0;
+    for (const auto& span : spans) {
+        totalBytes += span.length;
+    }
+    totalLines = spans.size();
+
+    original = std::move(block);
+    originalSpans = std::make_shared<const std::vector<LineSpan>>(std::move(spans));
+    added.clear();
+    addedSpans.clear();
+    pieces.clear();
+    if (totalLines > 0) {
+        pieces.push_back({Source::Original, 0, totalLines});
+    }
+    rebuildIndex();
+}
+
+/**
+ * @brief Удаляет все строки
+ */
+void PieceTable::clear() {
+    assignBlock(TextBlock(), std::vector<LineSpan>());
+}
+
+/**
+ * @brief Возвращает количество строк
+ * @return Количество строк
+ */
+size_t PieceTable::lineCount() const {
+    return totalLines;
+}
+
+/**
+ * @brief Возвращает суммарный размер строк в байтах
+ * @return Количество байт без переводов строк
+ */
+size_t PieceTable::byteCount() const {
+    return totalBytes;
+}
+
+/**
+ * @brief Возвращает количество фрагментов (для диагностики)
+ * @return Размер списка фрагментов
+ */
+size_t PieceTable::pieceCount() const {
+    return pieces.size();
+}
+
+/**
+ * @brief Возвращает строку буфера по номеру в его таблице строк
+ * @param source Буфер
+ * @param span Индекс строки в таблице буфера
+ * @return Представление строки
+ */
+std::string_view PieceTable::spanText(Source source, size_t span) const {
+    if (source == Source::Original) {
+        const LineSpan& s = (*originalSpans)[span];
+        return std::string_view(original.bytes.data() + s.offset, s.length);
+    }
+    const LineSpan& s = addedSpans[span];
+    return std::string_view(added.data() + s.offset, s.length);
+}
+
+/**
+ * @brief Возвращает строку по индексу
+ * @param index Индекс строки (начиная с 0)
+ * @return Представление строки, действительное до следующего изменения
+ */
+std::string_view PieceTable::line(size_t index) const {
+    if (index >= totalLines) {
+        throw std::out_of_range("PieceTable::line");
+    }
+    size_t p = findPiece(index);
+    const Piece& piece = pieces[p];
+    return spanText(piece.source, piece.firstSpan + (index - pieceStarts[p]));
+}
+
+/**
+ * @brief Находит фрагмент, содержащий строку
+ * @param index Индекс строки документа (меньше lineCount())
+ * @return Индекс фрагмента
+ */
+size_t PieceTable::findPiece(size_t index) const {
+    auto it = std::upper_bound(pieceStarts.begin(), pieceStarts.end(), index);
+    return static_cast<size_t>(it - pieceStarts.begin()) - 1;
+}
+
+/**
+ * @brief Разрезает фрагменты так, чтобы строка index начинала фрагмент
+ * @param index Индекс строки документа (не больше lineCount())
+ * @return Индекс фрагмента, начинающегося со строки index
+ */
+size_t PieceTable::splitAt(size_t index) {
+    if (index == totalLines) return pieces.size();
+
+    size_t p = findPiece(index);
+    size_t offset = index - pieceStarts[p];
+    if (offset == 0) return p;
+
+    Piece tail = pieces[p];
+    tail.firstSpan += offset;
+    tail.spanCount -= offset;
+    pieces[p].spanCount = offset;
+    pieces.insert(pieces.begin() + p + 1, tail);
+    pieceStarts.insert(pieceStarts.begin() + p + 1, index);
+    return p + 1;
+}
+
+/**
+ * @brief Пересчитывает индексы начала фрагментов
+ */
+void PieceTable::rebuildIndex() {
+    pieceStarts.resize(pieces.size());
+    size_t start = 0;
+    for (size_t i = 0; i < pieces.size(); ++i) {
+        pieceStarts[i] = start;
+        start += pieces[i].spanCount;
+    }
+}
+
+/**
+ * @brief Заменяет диапазон строк новыми строками
+ * @param index Индекс первой заменяемой строки
+ * @param count Количество заменяемых строк
+ * @param newLines Новые строки
+ */
+void PieceTable::replaceLines(size_t index, size_t count, const std::vector<std::string>& newLines) {
+    if (index > totalLines || count > totalLines - index) {
+        throw std::out_of_range("PieceTable::replaceLines");
+    }
+    if (count == 0 && newLines.empty()) return;
+
+    size_t first = splitAt(index);
+    size_t last = splitAt(index + count);
+
+    for (size_t p = first; p < last; ++p) {
+        for (size_t i = 0; i < pieces[p].spanCount; ++i) {
+            totalBytes -= spanText(pieces[p].source, pieces[p].firstSpan + i).size();
+        }
+    }
+    pieces.erase(pieces.begin() + first, pieces.begin() + last);
+    totalLines -= count;
+
+    if (!newLines.empty()) {
+        size_t firstSpan = addedSpans.size();
+        for (const auto& line : newLines) {
+            addedSpans.push_back({added.size(), line.size()});
+            added += line;
+            totalBytes += line.size();
+        }
+        totalLines += newLines.size();
+
+        // Последовательные добавления в конец продолжают предыдущий фрагмент
+        if (first > 0 && pieces[first - 1].source == Source::Added &&
+            pieces[first - 1].firstSpan + pieces[first - 1].spanCount == firstSpan) {
+            pieces[first - 1].spanCount += newLines.size();
+        } else {
+            pieces.insert(pieces.begin() + first, Piece{Source::Added, firstSpan, newLines.size()});
+        }
+    }
+    rebuildIndex();
+}
+
+/**
+ * @brief Последовательно обходит строки диапазона [first, last)
+ * @param first Индекс первой строки
+ * @param last Индекс за последней строкой
+ * @param fn Функция обхода
+ */
+void PieceTable::forEachLine(size_t first, size_t last, const LineVisitor& fn) const {
+    if (last > totalLines) last = totalLines;
+    if (first >= last) return;
+
+    size_t p = findPiece(first);
+    size_t index = first;
+    size_t offset = first - pieceStarts[p];
+    while (index < last) {
+        const Piece& piece = pieces[p];
+        for (size_t i = offset; i < piece.spanCount && index < last; ++i, ++index) {
+            fn(index, spanText(piece.source, piece.firstSpan + i));
+        }
+        offset = 0;
+        ++p;
+    }
+}
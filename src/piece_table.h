@@ -0,0 +1,130 @@
+#ifndef PIECE_TABLE_H
+#define PIECE_TABLE_H
+
+#include <cstdint>
+#include "text_storage.h"
+
+/**
+ * @class PieceTable
+ * @brief Таблица фрагментов (piece table) для хранения строк документа
+ *
+ * Текст хранится в двух буферах: исходном (только для чтения, заполняется
+ * при загрузке одним выделением памяти или отображается из файла) и буфере
+ * добавлений (только дописывается).
+ * Документ описывается списком фрагментов — диапазонов подряд идущих строк
+ * одного из буферов. Вставка, удаление и замена строк изменяют только список
+ * фрагментов и стоят O(число фрагментов), а не O(размер файла).
+ */
+class PieceTable : public TextStorage {
+public:
+    /**
+     * @brief Создает пустую таблицу
+     */
+    PieceTable();
+
+    /**
+     * @brief Делает блок исходным буфером таблицы без копирования
+     * @param block Блок текста документа
+     * @param spans Положения строк в блоке
+     */
+    void assignBlock(TextBlock block, std::vector<LineSpan> spans) override;
+
+    /**
+     * @brief Удаляет все строки
+     */
+    void clear() override;
+
+    /**
+     * @brief Возвращает количество строк
+     * @return Количество строк
+     */
+    size_t lineCount() const override;
+
+    /**
+     * @brief Возвращает суммарный размер строк в байтах
+     * @return Количество байт без переводов строк
+     */
+    size_t byteCount() const override;
+
+    /**
+     * @brief Возвращает строку по индексу
+     * @param index Индекс строки (начиная с 0)
+     * @return Представление строки, действительное до следующего изменения
+     */
+    std::string_view line(size_t index) const override;
+
+    /**
+     * @brief Заменяет диапазон строк новыми строками
+     * @param index Индекс первой заменяемой строки
+     * @param count Количество заменяемых строк
+     * @param newLines Новые строки
+     */
+    void replaceLines(size_t index, size_t count, const std::vector<std::string>& newLines) override;
+
+    /**
+     * @brief Последовательно обходит строки диапазона [first, last)
+     * @param first Индекс первой строки
+     * @param last Индекс за последней строкой
+     * @param fn Функция обхода
+     */
+    void forEachLine(size_t first, size_t last, const LineVisitor& fn) const override;
+
+    /**
+     * @brief Возвращает количество фрагментов (для диагностики)
+     * @return Размер списка фрагментов
+     */
+    size_t pieceCount() const;
+
+private:
+    /**
+     * @brief Буфер, на который ссылается фрагмент
+     */
+    enum class Source : uint8_t { Original, Added };
+
+    /**
+     * @brief Фрагмент: диапазон подряд идущих строк одного буфера
+     */
+    struct Piece {
+        Source source;    ///< Буфер фрагмента
+        size_t firstSpan; ///< Индекс первой строки в таблице строк буфера
+        size_t spanCount; ///< Количество строк во фрагменте
+    };
+
+    TextBlock original;               ///< Исходный буфер (общий для копий таблицы)
+    std::shared_ptr<const std::vector<LineSpan>> originalSpans; ///< Строки исходного буфера
+    std::string added;                ///< Буфер добавлений
+    std::vector<LineSpan> addedSpans; ///< Строки буфера добавлений
+    std::vector<Piece> pieces;        ///< Список фрагментов документа
+    std::vector<size_t> pieceStarts;  ///< Индекс первой строки каждого фрагмента
+    size_t totalLines;                ///< Количество строк документа
+    size_t totalBytes;                ///< Размер документа в байтах
+
+    /**
+     * @brief Возвращает строку буфера по номеру в его таблице строк
+     * @param source Буфер
+     * @param span Индекс строки в таблице буфера
+     * @return Представление строки
+     */
+    std::string_view spanText(Source source, size_t span) const;
+
+    /**
+     * @brief Находит фрагмент, содержащий строку
+     * @param index Индекс строки документа (меньше lineCount())
+     * @return Индекс фрагмента
+     */
+    size_t findPiece(size_t index) const;
+
+    /**
+     * @brief Разрезает фрагменты так, чтобы строка index начинала фрагмент
+     * @param index Индекс строки документа (не больше lineCount())
+     * @return Индекс фрагмента, начинающегося со строки index
+     */
+    size_t splitAt(size_t index);
+
+    /**
+     * @brief Пересчитывает индексы начала фрагментов
+     */
+    void rebuildIndex();
+};
+
+#endif // PIECE_TABLE_H
@@ -0,0 +1,276 @@
+#include "poly1305.h"
+#include "chacha20.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+/// Маска 26-битной части числа
+constexpr uint32_t kLimbMask = 0x3ffffff;
+
+/**
+ * @brief Читает слово в порядке байтов little-endian
+ * @param p Адрес слова
+ * @return Значение слова
+ */
+inline uint32_t loadLittleEndian(const uint8_t* p) {
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+/**
+ * @brief Записывает слово в порядке байтов little-endian
+ * @param p Адрес слова
+ * @param value Значение слова
+ */
+inline void storeLittleEndian(uint8_t* p, uint32_t value) {
+    p[0] = uint8_t(value);
+    p[1] = uint8_t(value >> 8);
+    p[2] = uint8_t(value >> 16);
+    p[3] = uint8_t(value >> 24);
+}
+
+/**
+ * @brief Вычисляет код аутентичности AEAD над шифртекстом
+ * @param oneTimeKey Ключ Poly1305, полученный из блока 0 ключевого потока
+ * @param aad Дополнительные аутентифицируемые данные
+ * @param aadSize Размер дополнительных данных
+ * @param ciphertext Шифртекст
+ * @param size Размер шифртекста
+ * @return Код аутентичности
+ */
+Poly1305::Tag aeadTag(const uint8_t* oneTimeKey, const void* aad, size_t aadSize,
+                      const void* ciphertext, size_t size) {
+    Poly1305 mac(oneTimeKey);
+    mac.update(aad, aadSize);
+    mac.pad();
+    mac.update(ciphertext, size);
+    mac.pad();
+    uint8_t lengths[16];
+    for (int i = 0; i < 8; ++i) {
+        lengths[i] = static_cast<uint8_t>(uint64_t(aadSize) >> (8 * i));
+        lengths[8 + i] = static_cast<uint8_t>(uint64_t(size) >> (8 * i));
+    }
+    mac.update(lengths, sizeof(lengths));
+    return mac.finish();
+}
+
+} // namespace
+
+/**
+ * @brief Создает вычислитель для одноразового ключа
+ * @param key Ключ размером kKeySize байт
+ */
+Poly1305::Poly1305(const uint8_t* key) : h{}, tail{}, buffered(0) {
+    r[0] = loadLittleEndian(key) & 0x3ffffff;
+    r[1] = (loadLittleEndian(key + 3) >> 2) & 0x3ffff03;
+    r[2] = (loadLittleEndian(key + 6) >> 4) & 0x3ffc0ff;
+    r[3] = (loadLittleEndian(key + 9) >> 6) & 0x3f03fff;
+    r[4] = (loadLittleEndian(key + 12) >> 8) & 0x00fffff;
+    for (int i = 0; i < 4; ++i) {
+        padWords[i] = loadLittleEndian(key + 16 + 4 * i);
+    }
+}
+
+/**
+ * @brief Затирает ключ и состояние
+ */
+Poly1305::~Poly1305() {
+    std::fill(std::begin(r), std::end(r), 0);
+    std::fill(std::begin(h), std::end(h), 0);
+    std::fill(std::begin(padWords), std::end(padWords), 0);
+}
+
+/**
+ * @brief Обрабатывает блоки по 16 байт
+ * @param data Блоки
+ * @param size Размер (кратен 16)
+ * @param highBit 1 << 24 для полных блоков, 0 для дополненного последнего
+ */
+void Poly1305::blocks(const uint8_t* data, size_t size, uint32_t highBit) {
+    const uint64_t r0 = r[0], r1 = r[1], r2 = r[2], r3 = r[3], r4 = r[4];
+    const uint64_t s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+    uint32_t h0 = h[0], h1 = h[1], h2 = h[2], h3 = h[3], h4 = h[4];
+
+    for (; size >= 16; data += 16, size -= 16) {
+        h0 += loadLittleEndian(data) & kLimbMask;
+        h1 += (loadLittleEndian(data + 3) >> 2) & kLimbMask;
+        h2 += (loadLittleEndian(data + 6) >> 4) & kLimbMask;
+        h3 += (loadLittleEndian(data + 9) >> 6) & kLimbMask;
+        h4 += (loadLittleEndian(data + 12) >> 8) | highBit;
+
+        uint64_t d0 = h0 * r0 + h1 * s4 + h2 * s3 + h3 * s2 + h4 * s1;
+        uint64_t d1 = h0 * r1 + h1 * r0 + h2 * s4 + h3 * s3 + h4 * s2;
+        uint64_t d2 = h0 * r2 + h1 * r1 + h2 * r0 + h3 * s4 + h4 * s3;
+        uint64_t d3 = h0 * r3 + h1 * r2 + h2 * r1 + h3 * r0 + h4 * s4;
+        uint64_t d4 = h0 * r4 + h1 * r3 + h2 * r2 + h3 * r1 + h4 * r0;
+
+        uint32_t carry = static_cast<uint32_t>(d0 >> 26);
+        h0 = static_cast<uint32_t>(d0) & kLimbMask;
+        d1 += carry;
+        carry = static_cast<uint32_t>(d1 >> 26);
+        h1 = static_cast<uint32_t>(d1) & kLimbMask;
+        d2 += carry;
+        carry = static_cast<uint32_t>(d2 >> 26);
+        h2 = static_cast<uint32_t>(d2) & kLimbMask;
+        d3 += carry;
+        carry = static_cast<uint32_t>(d3 >> 26);
+        h3 = static_cast<uint32_t>(d3) & kLimbMask;
+        d4 += carry;
+        carry = static_cast<uint32_t>(d4 >> 26);
+        h4 = static_cast<uint32_t>(d4) & kLimbMask;
+        h0 += carry * 5;
+        carry = h0 >> 26;
+        h0 &= kLimbMask;
+        h1 += carry;
+    }
+
+    h[0] = h0; h[1] = h1; h[2] = h2; h[3] = h3; h[4] = h4;
+}
+
+/**
+ * @brief Добавляет данные к сообщению
+ * @param data Данные
+ * @param size Размер данных в байтах
+ */
+void Poly1305::update(const void* data, size_t size) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    if (buffered > 0) {
+        size_t take = std::min(size, tail.size() - buffered);
+        std::memcpy(tail.data() + buffered, p, take);
+        buffered += take;
+        p += take;
+        size -= take;
+        if (buffered < tail.size()) return;
+        blocks(tail.data(), tail.size(), 1u << 24);
+        buffered = 0;
+    }
+    const size_t whole = size & ~size_t(15);
+    blocks(p, whole, 1u << 24);
+    std::memcpy(tail.data(), p + whole, size - whole);
+    buffered = size - whole;
+}
+
+/**
+ * @brief Дополняет сообщение нулями до границы 16 байт
+ */
+void Poly1305::pad() {
+    if (buffered == 0) return;
+    std::fill(tail.begin() + buffered, tail.end(), 0);
+    blocks(tail.data(), tail.size(), 1u << 24);
+    buffered = 0;
+}
+
+/**
+ * @brief Завершает вычисление
+ * @return Код аутентичности
+ */
+Poly1305::Tag Poly1305::finish() {
+    if (buffered > 0) {
+        tail[buffered] = 1;
+        std::fill(tail.begin() + buffered + 1, tail.end(), 0);
+        blocks(tail.data(), tail.size(), 0);
+        buffered = 0;
+    }
+
+    uint32_t h0 = h[0], h1 = h[1], h2 = h[2], h3 = h[3], h4 = h[4];
+    uint32_t carry = h1 >> 26; h1 &= kLimbMask;
+    h2 += carry; carry = h2 >> 26; h2 &= kLimbMask;
+    h3 += carry; carry = h3 >> 26; h3 &= kLimbMask;
+    h4 += carry; carry = h4 >> 26; h4 &= kLimbMask;
+    h0 += carry * 5; carry = h0 >> 26; h0 &= kLimbMask;
+    h1 += carry;
+
+    // h - p вычисляется без ветвлений; если результат неотрицателен, берется он
+    uint32_t g0 = h0 + 5; carry = g0 >> 26; g0 &= kLimbMask;
+    uint32_t g1 = h1 + carry; carry = g1 >> 26; g1 &= kLimbMask;
+    uint32_t g2 = h2 + carry; carry = g2 >> 26; g2 &= kLimbMask;
+    uint32_t g3 = h3 + carry; carry = g3 >> 26; g3 &= kLimbMask;
+    uint32_t g4 = h4 + carry - (1u << 26);
+
+    uint32_t select = (g4 >> 31) - 1;
+    h0 = (h0 & ~select) | (g0 & select);
+    h1 = (h1 & ~select) | (g1 & select);
+    h2 = (h2 & ~select) | (g2 & select);
+    h3 = (h3 & ~select) | (g3 & select);
+    h4 = (h4 & ~select) | (g4 & select);
+
+    uint32_t w0 = h0 | (h1 << 26);
+    uint32_t w1 = (h1 >> 6) | (h2 << 20);
+    uint32_t w2 = (h2 >> 12) | (h3 << 14);
+    uint32_t w3 = (h3 >> 18) | (h4 << 8);
+
+    Tag tag;
+    uint64_t f = uint64_t(w0) + padWords[0];
+    storeLittleEndian(tag.data(), static_cast<uint32_t>(f));
+    f = uint64_t(w1) + padWords[1] + (f >> 32);
+    storeLittleEndian(tag.data() + 4, static_cast<uint32_t>(f));
+    f = uint64_t(w2) + padWords[2] + (f >> 32);
+    storeLittleEndian(tag.data() + 8, static_cast<uint32_t>(f));
+    f = uint64_t(w3) + padWords[3] + (f >> 32);
+    storeLittleEndian(tag.data() + 12, static_cast<uint32_t>(f));
+    return tag;
+}
+
+/**
+ * @brief Шифрует данные на месте и вычисляет код аутентичности (ChaCha20-Poly1305)
+ * @param key Ключ ChaCha20 размером 32 байта
+ * @param nonce Одноразовое число размером 12 байт
+ * @param aad Дополнительные аутентифицируемые данные
+ * @param aadSize Размер дополнительных данных
+ * @param data Открытый текст, заменяемый шифртекстом
+ * @param size Размер данных в байтах
+ * @return Код аутентичности
+ */
+Poly1305::Tag sealChaCha20Poly1305(const uint8_t* key, const uint8_t* nonce, const void* aad,
+                                   size_t aadSize, void* data, size_t size) {
+    ChaCha20 cipher(key, nonce);
+    uint8_t oneTimeKey[ChaCha20::kBlockSize] = {};
+    cipher.apply(oneTimeKey, sizeof(oneTimeKey));
+    cipher.apply(data, size);
+    Poly1305::Tag tag = aeadTag(oneTimeKey, aad, aadSize, data, size);
+    std::memset(oneTimeKey, 0, sizeof(oneTimeKey));
+    return tag;
+}
+
+/**
+ * @brief Проверяет код аутентичности и расшифровывает данные на месте
+ *
+ * При несовпадении кода данные не изменяются.
+ *
+ * @param key Ключ ChaCha20 размером 32 байта
+ * @param nonce Одноразовое число размером 12 байт
+ * @param aad Дополнительные аутентифицируемые данные
+ * @param aadSize Размер дополнительных данных
+ * @param data Шифртекст, заменяемый открытым текстом
+ * @param size Размер данных в байтах
+ * @param tag Ожидаемый код аутентичности
+ * @return true если код совпал и данные расшифрованы
+ */
+bool openChaCha20Poly1305(const uint8_t* key, const uint8_t* nonce, const void* aad, size_t aadSize,
+                          void* data, size_t size, const uint8_t* tag) {
+    ChaCha20 cipher(key, nonce);
+    uint8_t oneTimeKey[ChaCha20::kBlockSize] = {};
+    cipher.apply(oneTimeKey, sizeof(oneTimeKey));
+    Poly1305::Tag expected = aeadTag(oneTimeKey, aad, aadSize, data, size);
+    std::memset(oneTimeKey, 0, sizeof(oneTimeKey));
+    if (!constantTimeEqual(expected.data(), tag, expected.size())) {
+        return false;
+    }
+    cipher.apply(data, size);
+    return true;
+}
+
+/**
+ * @brief Сравнивает байты за время, не зависящее от их содержимого
+ * @param a Первый массив
+ * @param b Второй массив
+ * @param size Размер массивов
+ * @return true если массивы равны
+ */
+bool constantTimeEqual(const uint8_t* a, const uint8_t* b, size_t size) {
+    uint8_t difference = 0;
+    for (size_t i = 0; i < size; ++i) {
+        difference |= a[i] ^ b[i];
+    }
+    return difference == 0;
+}
@@ -0,0 +1,107 @@
+#ifndef POLY1305_H
+#define POLY1305_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @file poly1305.h
+ * @brief Код аутентичности Poly1305 и AEAD-режим ChaCha20-Poly1305 (RFC 8439)
+ */
+
+/**
+ * @brief Потоковое вычисление одноразового кода аутентичности Poly1305
+ */
+class Poly1305 {
+public:
+    static constexpr size_t kKeySize = 32; ///< Размер одноразового ключа в байтах
+    static constexpr size_t kTagSize = 16; ///< Размер кода аутентичности в байтах
+
+    using Tag = std::array<uint8_t, kTagSize>;
+
+    /**
+     * @brief Создает вычислитель для одноразового ключа
+     * @param key Ключ размером kKeySize байт
+     */
+    explicit Poly1305(const uint8_t* key);
+
+    /**
+     * @brief Затирает ключ и состояние
+     */
+    ~Poly1305();
+
+    /**
+     * @brief Добавляет данные к сообщению
+     * @param data Данные
+     * @param size Размер данных в байтах
+     */
+    void update(const void* data, size_t size);
+
+    /**
+     * @brief Дополняет сообщение нулями до границы 16 байт
+     */
+    void pad();
+
+    /**
+     * @brief Завершает вычисление
+     * @return Код аутентичности
+     */
+    Tag finish();
+
+private:
+    /**
+     * @brief Обрабатывает блоки по 16 байт
+     * @param data Блоки
+     * @param size Размер (кратен 16)
+     * @param highBit 1 << 24 для полных блоков, 0 для дополненного последнего
+     */
+    void blocks(const uint8_t* data, size_t size, uint32_t highBit);
+
+    uint32_t r[5];                ///< Множитель в виде 26-битных частей
+    uint32_t h[5];                ///< Накопитель в виде 26-битных частей
+    uint32_t padWords[4];         ///< Вторая половина ключа
+    std::array<uint8_t, 16> tail; ///< Неполный блок
+    size_t buffered;              ///< Заполненная часть блока
+};
+
+/**
+ * @brief Шифрует данные на месте и вычисляет код аутентичности (ChaCha20-Poly1305)
+ * @param key Ключ ChaCha20 размером 32 байта
+ * @param nonce Одноразовое число размером 12 байт
+ * @param aad Дополнительные аутентифицируемые данные
+ * @param aadSize Размер дополнительных данных
+ * @param data Открытый текст, заменяемый шифртекстом
+ * @param size Размер данных в байтах
+ * @return Код аутентичности
+ */
+Poly1305::Tag sealChaCha20Poly1305(const uint8_t* key, const uint8_t* nonce, const void* aad,
+                                   size_t aadSize, void* data, size_t size);
+
+/**
+ * @brief Проверяет код аутентичности и расшифровывает данные на месте
+ *
+ * При несовпадении кода данные не изменяются.
+ *
+ * @param key Ключ ChaCha20 размером 32 байта
+ * @param nonce Одноразовое число размером 12 байт
+ * @param aad Дополнительные аутентифицируемые данные
+ * @param aadSize Размер дополнительных данных
+ * @param data Шифртекст, заменяемый открытым текстом
+ * @param size Размер данных в байтах
+ * @param tag Ожидаемый код аутентичности
+ * @return true если код совпал и данные расшифрованы
+ */
+bool openChaCha20Poly1305(const uint8_t* key, const uint8_t* nonce, const void* aad, size_t aadSize,
+                          void* data, size_t size, const uint8_t* tag);
+
+/**
+ * @brief Сравнивает байты за время, не зависящее от их содержимого
+ * @param a Первый массив
+ * @param b Второй массив
+ * @param size Размер массивов
+ * @return true если массивы равны
+ */
+bool constantTimeEqual(const uint8_t* a, const uint8_t* b, size_t size);
+
+#endif // POLY1305_H
@@ -0,0 +1,69 @@
+#ifndef POSTINGS_H
+#define POSTINGS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/**
+ * @file postings.h
+ * @brief Операции над списками строк (posting lists) индексов поиска
+ *
+ * Список хранит отсортированные идентификаторы строк (см. LineIds) без
+ * повторов. Идентификаторы 32-битные: документы с большим числом строк не
+ * индексируются.
+ */
+
+/**
+ * @brief Отсортированный список индексов строк
+ */
+using Postings = std::vector<uint32_t>;
+
+/// Наибольшее количество строк документа, который можно проиндексировать
+constexpr size_t kMaxIndexedLines = std::numeric_limits<uint32_t>::max();
+
+/// Отметка удаленной строки в таблице новой нумерации (см. LineIds::retain)
+constexpr uint32_t kDroppedLine = std::numeric_limits<uint32_t>::max();
+
+/**
+ * @brief Добавляет строку в список, если ее там нет
+ * @param lines Список
+ * @param line Индекс строки
+ * @return true если строка добавлена
+ */
+inline bool insertPosting(Postings& lines, uint32_t line) {
+    auto it = std::lower_bound(lines.begin(), lines.end(), line);
+    if (it != lines.end() && *it == line) return false;
+    lines.insert(it, line);
+    return true;
+}
+
+/**
+ * @brief Удаляет строку из списка
+ * @param lines Список
+ * @param line Индекс строки
+ * @return true если строка была в списке
+ */
+inline bool erasePosting(Postings& lines, uint32_t line) {
+    auto it = std::lower_bound(lines.begin(), lines.end(), line);
+    if (it == lines.end() || *it != line) return false;
+    lines.erase(it);
+    return true;
+}
+
+/**
+ * @brief Перенумеровывает список, отбрасывая удаленные строки
+ * @param lines Список
+ * @param renumber Таблица новой нумерации (см. LineIds::retain)
+ */
+inline void renumberPostings(Postings& lines, const std::vector<uint32_t>& renumber) {
+    size_t out = 0;
+    for (uint32_t line : lines) {
+        if (renumber[line] != kDroppedLine) lines[out++] = renumber[line];
+    }
+    lines.resize(out);
+}
+
+#endif // POSTINGS_H
@@ -0,0 +1,431 @@
+#include "rope.h"
+#include <algorithm>
+#include <stdexcept>
+
+/**
+ * @brief Создает пустое дерево
+ */
+Rope::Rope() : root(std::make_unique<Node>()) {}
+
+/**
+ * @brief Копирующий конструктор (глубокая копия дерева)
+ * @param other Исходное дерево
+ */
+Rope::Rope(const Rope& other) : root(copyNode(*other.root)) {}
+
+/**
+ * @brief Копирующее присваивание (глубокая копия дерева)
+ * @param other Исходное дерево
+ * @return Ссылка на это дерево
+ */
+Rope& Rope::operator=(const Rope& other) {
+    if (this != &other) {
+        root = copyNode(*other.root);
+    }
+    return *this;
+}
+
+/**
+ * @brief Рекурсивно копирует поддерево
+ * @param node Копируемый узел
+ * @return Копия узла
+ */
+std::unique_ptr<Rope::Node> Rope::copyNode(const Node& node) {
+    auto copy = std::make_unique<Node>();
+    copy->leaf = node.leaf;
+    copy->lines = node.lines;
+    copy->bytes = node.bytes;
+    copy->text = node.text;
+    copy->starts = node.starts;
+    copy->children.reserve(node.children.size());
+    for (const auto& child : node.children) {
+        copy->children.push_back(copyNode(*child));
+    }
+    return copy;
+}
+
+/**
+ * @brief Строит дерево, копируя строки блока в листья
+ * @param block Блок текста документа
+ * @param spans Положения строк в блоке
+ */
+void Rope::assignBlock(TextBlock block, std::vector<LineSpan> spans) {
+    std::vector<std::string_view> views;
+    views.reserve(spans.size());
+    for (const auto& span : spans) {
+        views.emplace_back(block.bytes.data() + span.offset, span.length);
+    }
+    buildRoot(packLeaves(views));
+}
+
+/**
+ * @brief Удаляет все строки
+ */
+void Rope::clear() {
+    root = std::make_unique<Node>();
+}
+
+/**
+ * @brief Возвращает количество строк
+ * @return Количество строк
+ */
+size_t Rope::lineCount() const {
+    return root->lines;
+}
+
+/**
+ * @brief Возвращает суммарный размер строк в байтах
+ * @return Количество байт без переводов строк
+ */
+size_t Rope::byteCount() const {
+    return root->bytes;
+}
+
+/**
+ * @brief Возвращает высоту дерева (для диагностики)
+ * @return Количество уровней, включая листья
+ */
+size_t Rope::height() const {
+    size_t levels = 1;
+    for (const Node* node = root.get(); !node->leaf; node = node->children.front().get()) {
+        ++levels;
+    }
+    return levels;
+}
+
+/**
+ * @brief Возвращает строку листа
+ * @param leaf Лист
+ * @param index Индекс строки внутри листа
+ * @return Представление строки
+ */
+std::string_view Rope::leafLine(const Node& leaf, size_t index) {
+    size_t start = leaf.starts[index];
+    size_t end = index + 1 < leaf.starts.size() ? leaf.starts[index + 1] : leaf.text.size();
+    return std::string_view(leaf.text.data() + start, end - start);
+}
+
+/**
+ * @brief Пересчитывает количество строк и байт узла
+ * @param node Узел
+ */
+void Rope::recount(Node& node) {
+    if (node.leaf) {
+        node.lines = node.starts.size();
+        node.bytes = node.text.size();
+        return;
+    }
+    node.lines = 0;
+    node.bytes = 0;
+    for (const auto& child : node.children) {
+        node.lines += child->lines;
+        node.bytes += child->bytes;
+    }
+}
+
+/**
+ * @brief Раскладывает строки по листам с учетом ограничений размера
+ * @param lines Строки в порядке следования
+ * @return Список заполненных листов
+ */
+Rope::NodeList Rope::packLeaves(const std::vector<std::string_view>& lines) {
+    NodeList leaves;
+    auto leaf = std::make_unique<Node>();
+    for (std::string_view line : lines) {
+        if (!leaf->starts.empty() &&
+            (leaf->text.size() + line.size() > kMaxLeafBytes || leaf->starts.size() == kMaxLeafLines)) {
+            recount(*leaf);
+            leaves.push_back(std::move(leaf));
+            leaf = std::make_unique<Node>();
+        }
+        leaf->starts.push_back(leaf->text.size());
+        leaf->text.append(line.data(), line.size());
+    }
+    if (!leaf->starts.empty()) {
+        recount(*leaf);
+        leaves.push_back(std::move(leaf));
+    }
+    return leaves;
+}
+
+/**
+ * @brief Группирует узлы одного уровня под равномерно заполненных родителей
+ * @param nodes Узлы уровня
+ * @return Родительские узлы (не более kMaxChildren потомков у каждого)
+ */
+Rope::NodeList Rope::packInternal(NodeList nodes) {
+    size_t groups = (nodes.size() + kMaxChildren - 1) / kMaxChildren;
+    NodeList parents;
+    parents.reserve(groups);
+    size_t next = 0;
+    for (size_t g = 0; g < groups; ++g) {
+        size_t take = (nodes.size() - next) / (groups - g);
+        auto parent = std::make_unique<Node>();
+        parent->leaf = false;
+        for (size_t i = 0; i < take; ++i) {
+            parent->children.push_back(std::move(nodes[next++]));
+        }
+        recount(*parent);
+        parents.push_back(std::move(parent));
+    }
+    return parents;
+}
+
+/**
+ * @brief Строит корень из списка узлов одного уровня
+ * @param nodes Узлы уровня (может быть пустым)
+ */
+void Rope::buildRoot(NodeList nodes) {
+    if (nodes.empty()) {
+        root = std::make_unique<Node>();
+        return;
+    }
+    while (nodes.size() > 1) {
+        nodes = packInternal(std::move(nodes));
+    }
+    root = std::move(nodes.front());
+}
+
+/**
+ * @brief Возвращает строку по индексу за O(log n)
+ * @param index Индекс строки (начиная с 0)
+ * @return Представление строки, действительное до следующего изменения
+ */
+std::string_view Rope::line(size_t index) const {
+    if (index >= root->lines) {
+        throw std::out_of_range("Rope::line");
+    }
+    const Node* node = root.get();
+    while (!node->leaf) {
+        for (const auto& child : node->children) {
+            if (index < child->lines) {
+                node = child.get();
+                break;
+            }
+            index -= child->lines;
+        }
+    }
+    return leafLine(*node, index);
+}
+
+/**
+ * @brief Вставляет строки в поддерево
+ * @param node Узел
+ * @param index Позиция вставки внутри поддерева
+ * @param newLines Вставляемые строки
+ * @return Новые узлы того же уровня, которые нужно поставить после node
+ */
+Rope::NodeList Rope::insertInto(Node& node, size_t index, const std::vector<std::string>& newLines) {
+    if (node.leaf) {
+        size_t at = index < node.starts.size() ? node.starts[index] : node.text.size();
+        std::string text;
+        std::vector<size_t> starts;
+        size_t added = 0;
+        for (const auto& line : newLines) {
+            added += line.size();
+        }
+        text.reserve(node.text.size() + added);
+        starts.reserve(node.starts.size() + newLines.size());
+
+        text.append(node.text, 0, at);
+        starts.assign(node.starts.begin(), node.starts.begin() + index);
+        for (const auto& line : newLines) {
+            starts.push_back(text.size());
+            text += line;
+        }
+        for (size_t i = index; i < node.starts.size(); ++i) {
+            starts.push_back(node.starts[i] + added);
+        }
+        text.append(node.text, at, std::string::npos);
+        node.text = std::move(text);
+        node.starts = std::move(starts);
+        recount(node);
+
+        if (node.bytes <= kMaxLeafBytes && node.lines <= kMaxLeafLines) {
+            return {};
+        }
+
+        std::vector<std::string_view> views;
+        views.reserve(node.lines);
+        for (size_t i = 0; i < node.lines; ++i) {
+            views.push_back(leafLine(node, i));
+        }
+        NodeList leaves = packLeaves(views);
+        node.text = std::move(leaves.front()->text);
+        node.starts = std::move(leaves.front()->starts);
+        recount(node);
+        leaves.erase(leaves.begin());
+        return leaves;
+    }
+
+    size_t c = 0;
+    while (c + 1 < node.children.size() && index > node.children[c]->lines) {
+        index -= node.children[c]->lines;
+        ++c;
+    }
+    NodeList extra = insertInto(*node.children[c], index, newLines);
+    for (size_t i = 0; i < extra.size(); ++i) {
+        node.children.insert(node.children.begin() + c + 1 + i, std::move(extra[i]));
+    }
+    recount(node);
+
+    if (node.children.size() <= kMaxChildren) {
+        return {};
+    }
+
+    NodeList groups = packInternal(std::move(node.children));
+    node.children = std::move(groups.front()->children);
+    recount(node);
+    groups.erase(groups.begin());
+    return groups;
+}
+
+/**
+ * @brief Удаляет строки из поддерева
+ * @param node Узел
+ * @param index Индекс первой удаляемой строки внутри поддерева
+ * @param count Количество удаляемых строк
+ */
+void Rope::eraseFrom(Node& node, size_t index, size_t count) {
+    if (node.leaf) {
+        size_t end = index + count;
+        size_t from = node.starts[index];
+        size_t to = end < node.starts.size() ? node.starts[end] : node.text.size();
+        node.text.erase(from, to - from);
+        node.starts.erase(node.starts.begin() + index, node.starts.begin() + end);
+        for (size_t i = index; i < node.starts.size(); ++i) {
+            node.starts[i] -= to - from;
+        }
+        recount(node);
+        return;
+    }
+
+    size_t base = 0;
+    for (auto& child : node.children) {
+        size_t childLines = child->lines;
+        size_t childEnd = base + childLines;
+        if (childEnd > index && base < index + count) {
+            size_t from = index > base ? index - base : 0;
+            size_t to = std::min(index + count, childEnd) - base;
+            eraseFrom(*child, from, to - from);
+        }
+        base = childEnd;
+        if (base >= index + count) break;
+    }
+
+    NodeList kept;
+    kept.reserve(node.children.size());
+    for (auto& child : node.children) {
+        if (child->lines > 0) kept.push_back(std::move(child));
+    }
+    node.children = std::move(kept);
+    mergeSmallChildren(node);
+    recount(node);
+}
+
+/**
+ * @brief Объединяет соседних недозаполненных потомков
+ * @param node Внутренний узел
+ */
+void Rope::mergeSmallChildren(Node& node) {
+    size_t i = 0;
+    while (i + 1 < node.children.size()) {
+        Node& a = *node.children[i];
+        Node& b = *node.children[i + 1];
+        bool merge;
+        if (a.leaf) {
+            bool underfull = a.bytes < kMaxLeafBytes / 2 || b.bytes < kMaxLeafBytes / 2;
+            merge = underfull && a.bytes + b.bytes <= kMaxLeafBytes && a.lines + b.lines <= kMaxLeafLines;
+        } else {
+            size_t sa = a.children.size();
+            size_t sb = b.children.size();
+            merge = (sa < kMaxChildren / 2 || sb < kMaxChildren / 2) && sa + sb <= kMaxChildren;
+        }
+        if (!merge) {
+            ++i;
+            continue;
+        }
+
+        if (a.leaf) {
+            size_t shift = a.text.size();
+            a.text += b.text;
+            for (size_t start : b.starts) {
+                a.starts.push_back(start + shift);
+            }
+        } else {
+            for (auto& child : b.children) {
+                a.children.push_back(std::move(child));
+            }
+        }
+        recount(a);
+        node.children.erase(node.children.begin() + i + 1);
+    }
+}
+
+/**
+ * @brief Заменяет диапазон строк новыми строками
+ * @param index Индекс первой заменяемой строки
+ * @param count Количество заменяемых строк
+ * @param newLines Новые строки
+ */
+void Rope::replaceLines(size_t index, size_t count, const std::vector<std::string>& newLines) {
+    if (index > root->lines || count > root->lines - index) {
+        throw std::out_of_range("Rope::replaceLines");
+    }
+
+    if (count > 0) {
+        eraseFrom(*root, index, count);
+        while (!root->leaf && root->children.size() == 1) {
+            root = std::move(root->children.front());
+        }
+        if (!root->leaf && root->children.empty()) {
+            root = std::make_unique<Node>();
+        }
+    }
+
+    if (!newLines.empty()) {
+        NodeList extra = insertInto(*root, index, newLines);
+        if (!extra.empty()) {
+            extra.insert(extra.begin(), std::move(root));
+            buildRoot(std::move(extra));
+        }
+    }
+}
+
+/**
+ * @brief Обходит строки поддерева, попадающие в диапазон
+ * @param node Узел
+ * @param base Индекс первой строки поддерева в документе
+ * @param first Индекс первой строки диапазона
+ * @param last Индекс за последней строкой диапазона
+ * @param fn Функция обхода
+ */
+void Rope::visit(const Node& node, size_t base, size_t first, size_t last, const LineVisitor& fn) {
+    if (node.leaf) {
+        size_t from = first > base ? first - base : 0;
+        size_t to = std::min(last - base, node.lines);
+        for (size_t i = from; i < to; ++i) {
+            fn(base + i, leafLine(node, i));
+        }
+        return;
+    }
+    for (const auto& child : node.children) {
+        if (base >= last) break;
+        if (base + child->lines > first) {
+            visit(*child, base, first, last, fn);
+        }
+        base += child->lines;
+    }
+}
+
+/**
+ * @brief Последовательно обходит строки диапазона [first, last)
+ * @param first Индекс первой строки
+ * @param last Индекс за последней строкой
+ * @param fn Функция обхода
+ */
+void Rope::forEachLine(size_t first, size_t last, const LineVisitor& fn) const {
+    if (last > root->lines) last = root->lines;
+    if (first >= last) return;
+    visit(*root, 0, first, last, fn);
+}
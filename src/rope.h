@@ -0,0 +1,184 @@
+#ifndef ROPE_H
+#define ROPE_H
+
+#include "text_storage.h"
+
+/**
+ * @class Rope
+ * @brief Сбалансированное B-дерево блоков строк (rope)
+ *
+ * Листья хранят блоки целых строк размером до kMaxLeafBytes, внутренние узлы —
+ * до kMaxChildren потомков. Каждый узел знает количество строк и байт в своем
+ * поддереве, поэтому поиск, вставка и удаление строки по номеру стоят O(log n)
+ * даже для сотен миллионов строк.
+ */
+class Rope : public TextStorage {
+public:
+    static constexpr size_t kMaxLeafBytes = 16 * 1024; ///< Максимальный размер листа в байтах
+    static constexpr size_t kMaxLeafLines = 1024;      ///< Максимальное количество строк в листе
+    static constexpr size_t kMaxChildren = 16;         ///< Максимальная степень ветвления
+
+    /**
+     * @brief Создает пустое дерево
+     */
+    Rope();
+
+    /**
+     * @brief Копирующий конструктор (глубокая копия дерева)
+     * @param other Исходное дерево
+     */
+    Rope(const Rope& other);
+
+    /**
+     * @brief Копирующее присваивание (глубокая копия дерева)
+     * @param other Исходное дерево
+     * @return Ссылка на это дерево
+     */
+    Rope& operator=(const Rope& other);
+
+    /**
+     * @brief Строит дерево, копируя строки блока в листья
+     * @param block Блок текста документа
+     * @param spans Положения строк в блоке
+     */
+    void assignBlock(TextBlock block, std::vector<LineSpan> spans) override;
+
+    /**
+     * @brief Удаляет все строки
+     */
+    void clear() override;
+
+    /**
+     * @brief Возвращает количество строк
+     * @return Количество строк
+     */
+    size_t lineCount() const override;
+
+    /**
+     * @brief Возвращает суммарный размер строк в байтах
+     * @return Количество байт без переводов строк
+     */
+    size_t byteCount() const override;
+
+    /**
+     * @brief Возвращает строку по индексу за O(log n)
+     * @param index Индекс строки (начиная с 0)
+     * @return Представление строки, действительное до следующего изменения
+     */
+    std::string_view line(size_t index) const override;
+
+    /**
+     * @brief Заменяет диапазон строк новыми строками
+     * @param index Индекс первой заменяемой строки
+     * @param count Количество заменяемых строк
+     * @param newLines Новые строки
+     */
+    void replaceLines(size_t index, size_t count, const std::vector<std::string>& newLines) override;
+
+    /**
+     * @brief Последовательно обходит строки диапазона [first, last)
+     * @param first Индекс первой строки
+     * @param last Индекс за последней строкой
+     * @param fn Функция обхода
+     */
+    void forEachLine(size_t first, size_t last, const LineVisitor& fn) const override;
+
+    /**
+     * @brief Возвращает высоту дерева (для диагностики)
+     * @return Количество уровней, включая листья
+     */
+    size_t height() const;
+
+private:
+    /**
+     * @brief Узел дерева: лист с блоком строк или внутренний узел
+     */
+    struct Node {
+        bool leaf = true;  ///< Признак листа
+        size_t lines = 0;  ///< Количество строк в поддереве
+        size_t bytes = 0;  ///< Количество байт в поддереве
+        std::vector<std::unique_ptr<Node>> children; ///< Потомки внутреннего узла
+        std::string text;           ///< Строки листа без разделителей
+        std::vector<size_t> starts; ///< Смещения начала строк листа в text
+    };
+
+    using NodeList = std::vector<std::unique_ptr<Node>>;
+
+    std::unique_ptr<Node> root; ///< Корень дерева
+
+    /**
+     * @brief Рекурсивно копирует поддерево
+     * @param node Копируемый узел
+     * @return Копия узла
+     */
+    static std::unique_ptr<Node> copyNode(const Node& node);
+
+    /**
+     * @brief Возвращает строку листа
+     * @param leaf Лист
+     * @param index Индекс строки внутри листа
+     * @return Представление строки
+     */
+    static std::string_view leafLine(const Node& leaf, size_t index);
+
+    /**
+     * @brief Пересчитывает количество строк и байт узла
+     * @param node Узел
+     */
+    static void recount(Node& node);
+
+    /**
+     * @brief Раскладывает строки по листам с учетом ограничений размера
+     * @param lines Строки в порядке следования
+     * @return Список заполненных листов
+     */
+    static NodeList packLeaves(const std::vector<std::string_view>& lines);
+
+    /**
+     * @brief Группирует узлы одного уровня под равномерно заполненных родителей
+     * @param nodes Узлы уровня
+     * @return Родительские узлы (не более kMaxChildren потомков у каждого)
+     */
+    static NodeList packInternal(NodeList nodes);
+
+    /**
+     * @brief Вставляет строки в поддерево
+     * @param node Узел
+     * @param index Позиция вставки внутри поддерева
+     * @param newLines Вставляемые строки
+     * @return Новые узлы того же уровня, которые нужно поставить после node
+     */
+    static NodeList insertInto(Node& node, size_t index, const std::vector<std::string>& newLines);
+
+    /**
+     * @brief Удаляет строки из поддерева
+     * @param node Узел
+     * @param index Индекс первой удаляемой строки внутри поддерева
+     * @param count Количество удаляемых строк
+     */
+    static void eraseFrom(Node& node, size_t index, size_t count);
+
+    /**
+     * @brief Объединяет соседних недозаполненных потомков
+     * @param node Внутренний узел
+     */
+    static void mergeSmallChildren(Node& node);
+
+    /**
+     * @brief Обходит строки поддерева, попадающие в диапазон
+     * @param node Узел
+     * @param base Индекс первой строки поддерева в документе
+     * @param first Индекс первой строки диапазона
+     * @param last Индекс за последней строкой диапазона
+     * @param fn Функция обхода
+     */
+    static void visit(const Node& node, size_t base, size_t first, size_t last, const LineVisitor& fn);
+
+    /**
+     * @brief Строит корень из списка узлов одного уровня
+     * @param nodes Узлы уровня (может быть пустым)
+     */
+    void buildRoot(NodeList nodes);
+};
+
+#endif // ROPE_H
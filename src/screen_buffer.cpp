@@ -0,0 +1,175 @@
+#include "screen_buffer.h"
+#include <algorithm>
+#include <array>
+
+namespace {
+
+/// Последовательности цветов ячеек, в порядке CellColor (каждая сбрасывает прежний цвет)
+constexpr std::array<std::string_view, 7> kPalette = {
+    "\033[0m",      // Default
+    "\033[0;1;32m", // Keyword
+    "\033[0;36m",   // Number
+    "\033[0;33m",   // String
+    "\033[0;90m",   // Comment
+    "\033[0;2m",    // Gutter
+    "\033[0;7m"     // Status
+};
+
+/**
+ * @brief Дописывает последовательность перемещения курсора
+ * @param row Строка (начиная с 0)
+ * @param column Столбец (начиная с 0)
+ * @param out Строка, к которой добавляется последовательность
+ */
+void moveCursor(size_t row, size_t column, std::string& out) {
+    char text[48];
+    char* end = text + sizeof(text);
+    char* p = end;
+    *--p = 'H';
+    for (size_t n = column + 1; ; n /= 10) {
+        *--p = static_cast<char>('0' + n % 10);
+        if (n < 10) break;
+    }
+    *--p = ';';
+    for (size_t n = row + 1; ; n /= 10) {
+        *--p = static_cast<char>('0' + n % 10);
+        if (n < 10) break;
+    }
+    *--p = '[';
+    *--p = '\033';
+    out.append(p, static_cast<size_t>(end - p));
+}
+
+} // namespace
+
+/**
+ * @brief Возвращает длину символа UTF-8 по первому байту
+ * @param lead Первый байт
+ * @return Длина от 1 до 4 (некорректный байт считается отдельным символом)
+ */
+size_t utf8Length(unsigned char lead) {
+    if (lead >= 0xF0 && lead < 0xF8) return 4;
+    if (lead >= 0xE0) return lead < 0xF0 ? 3 : 1;
+    if (lead >= 0xC0) return 2;
+    return 1;
+}
+
+/**
+ * @brief Создает экран, заполненный пробелами
+ * @param rows Количество строк
+ * @param columns Количество столбцов
+ */
+ScreenBuffer::ScreenBuffer(size_t rows, size_t columns)
+    : cells(rows * columns), rowCount(rows), columnCount(columns) {}
+
+/**
+ * @brief Заполняет экран пробелами цвета по умолчанию
+ */
+void ScreenBuffer::clear() {
+    std::fill(cells.begin(), cells.end(), Cell());
+}
+
+/**
+ * @brief Пишет текст в строку экрана, обрезая его по правому краю
+ * @param row Строка
+ * @param column Первый столбец
+ * @param text Текст UTF-8 (управляющие символы выводятся как пробелы)
+ * @param color Цвет
+ * @return Столбец после последнего записанного символа
+ */
+size_t ScreenBuffer::write(size_t row, size_t column, std::string_view text, CellColor color) {
+    size_t i = 0;
+    while (i < text.size() && column < columnCount) {
+        size_t length = std::min(utf8Length(static_cast<unsigned char>(text[i])), text.size() - i);
+        Cell& cell = at(row, column++);
+        cell.color = color;
+        if (static_cast<unsigned char>(text[i]) < 0x20 || text[i] == 0x7F) {
+            cell.text[0] = ' ';
+            cell.length = 1;
+        } else {
+            std::char_traits<char>::copy(cell.text, text.data() + i, length);
+            cell.length = static_cast<uint8_t>(length);
+        }
+        i += length;
+    }
+    return column;
+}
+
+/**
+ * @brief Заполняет часть строки экрана пробелами
+ * @param row Строка
+ * @param from Первый столбец
+ * @param to Столбец за последним
+ * @param color Цвет
+ */
+void ScreenBuffer::fill(size_t row, size_t from, size_t to, CellColor color) {
+    Cell blank;
+    blank.color = color;
+    for (size_t column = from; column < std::min(to, columnCount); ++column) {
+        at(row, column) = blank;
+    }
+}
+
+/**
+ * @brief Возвращает текст строки экрана без цветов
+ * @param row Строка
+ * @return Символы строки
+ */
+std::string ScreenBuffer::rowText(size_t row) const {
+    std::string text;
+    for (size_t column = 0; column < columnCount; ++column) {
+        const Cell& cell = at(row, column);
+        text.append(cell.text, cell.length);
+    }
+    return text;
+}
+
+/**
+ * @brief Дописывает escape-последовательности, превращающие экран previous в next
+ * @param previous Экран, показанный в терминале
+ * @param next Новый кадр
+ * @param cursorRow Строка курсора
+ * @param cursorColumn Столбец курсора
+ * @param out Строка, к которой добавляется вывод
+ * @return Количество выведенных ячеек
+ */
+size_t diffScreens(const ScreenBuffer& previous, const ScreenBuffer& next,
+                   size_t cursorRow, size_t cursorColumn, std::string& out) {
+    // The cursor is hidden while cells change so it does not flicker across the screen
+    out.append("\033[?25l");
+    ScreenBuffer blank;
+    const ScreenBuffer* shown = &previous;
+    if (previous.rows() != next.rows() || previous.columns() != next.columns()) {
+        out.append("\033[0m\033[2J");
+        blank = ScreenBuffer(next.rows(), next.columns());
+        shown = &blank;
+    }
+
+    size_t drawn = 0;
+    size_t atRow = next.rows();
+    size_t atColumn = 0;
+    CellColor color = CellColor::Default;
+    for (size_t row = 0; row < next.rows(); ++row) {
+        for (size_t column = 0; column < next.columns(); ++column) {
+            const Cell& cell = next.at(row, column);
+            if (cell == shown->at(row, column)) continue;
+            if (row != atRow || column != atColumn) {
+                moveCursor(row, column, out);
+            }
+            if (cell.color != color) {
+                color = cell.color;
+                out.append(kPalette[static_cast<size_t>(color)]);
+            }
+            out.append(cell.text, cell.length);
+            atRow = row;
+            atColumn = column + 1;
+            ++drawn;
+        }
+    }
+    if (color != CellColor::Default) {
+        out.append(kPalette[0]);
+    }
+    moveCursor(cursorRow, cursorColumn, out);
+    out.append("\033[?25h");
+    return drawn;
+}
@@ -0,0 +1,145 @@
+#ifndef SCREEN_BUFFER_H
+#define SCREEN_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Цвет ячейки экрана (индекс палитры ANSI-последовательностей)
+ */
+enum class CellColor : uint8_t {
+    Default, ///< Цвет терминала
+    Keyword, ///< Ключевое слово
+    Number,  ///< Числовой литерал
+    String,  ///< Строковый литерал
+    Comment, ///< Комментарий
+    Gutter,  ///< Колонка номеров строк
+    Status   ///< Строка состояния (инверсия)
+};
+
+/**
+ * @brief Ячейка экрана: один символ UTF-8 и его цвет
+ */
+struct Cell {
+    char text[4] = {' ', 0, 0, 0}; ///< Байты символа
+    uint8_t length = 1;            ///< Количество байтов символа
+    CellColor color = CellColor::Default; ///< Цвет
+
+    bool operator==(const Cell& other) const {
+        return length == other.length && color == other.color &&
+               std::char_traits<char>::compare(text, other.text, length) == 0;
+    }
+    bool operator!=(const Cell& other) const { return !(*this == other); }
+};
+
+/**
+ * @class ScreenBuffer
+ * @brief Модель экрана терминала: прямоугольник ячеек
+ *
+ * Каждый символ UTF-8 занимает одну ячейку (символы двойной ширины не
+ * учитываются). Кадр строится в буфере, а в терминал выводятся только
+ * ячейки, отличающиеся от предыдущего кадра (см. diffScreens).
+ */
+class ScreenBuffer {
+public:
+    /**
+     * @brief Создает экран, заполненный пробелами
+     * @param rows Количество строк
+     * @param columns Количество столбцов
+     */
+    ScreenBuffer(size_t rows = 0, size_t columns = 0);
+
+    /**
+     * @brief Заполняет экран пробелами цвета по умолчанию
+     */
+    void clear();
+
+    /**
+     * @brief Пишет текст в строку экрана, обрезая его по правому краю
+     * @param row Строка
+     * @param column Первый столбец
+     * @param text Текст UTF-8 (управляющие символы выводятся как пробелы)
+     * @param color Цвет
+     * @return Столбец после последнего записанного символа
+     */
+    size_t write(size_t row, size_t column, std::string_view text, CellColor color);
+
+    /**
+     * @brief Заполняет часть строки экрана пробелами
+     * @param row Строка
+     * @param from Первый столбец
+     * @param to Столбец за последним
+     * @param color Цвет
+     */
+    void fill(size_t row, size_t from, size_t to, CellColor color);
+
+    /**
+     * @brief Возвращает ячейку
+     * @param row Строка
+     * @param column Столбец
+     * @return Ячейка
+     */
+    Cell& at(size_t row, size_t column) { return cells[row * columnCount + column]; }
+
+    /**
+     * @brief Возвращает ячейку
+     * @param row Строка
+     * @param column Столбец
+     * @return Ячейка
+     */
+    const Cell& at(size_t row, size_t column) const { return cells[row * columnCount + column]; }
+
+    /**
+     * @brief Возвращает текст строки экрана без цветов
+     * @param row Строка
+     * @return Символы строки
+     */
+    std::string rowText(size_t row) const;
+
+    /**
+     * @brief Возвращает количество строк
+     * @return Количество строк
+     */
+    size_t rows() const { return rowCount; }
+
+    /**
+     * @brief Возвращает количество столбцов
+     * @return Количество столбцов
+     */
+    size_t columns() const { return columnCount; }
+
+private:
+    std::vector<Cell> cells; ///< Ячейки по строкам
+    size_t rowCount;         ///< Количество строк
+    size_t columnCount;      ///< Количество столбцов
+};
+
+/**
+ * @brief Возвращает длину символа UTF-8 по первому байту
+ * @param lead Первый байт
+ * @return Длина от 1 до 4 (некорректный байт считается отдельным символом)
+ */
+size_t utf8Length(unsigned char lead);
+
+/**
+ * @brief Дописывает escape-последовательности, превращающие экран previous в next
+ *
+ * Курсор перемещается только к изменившимся ячейкам (подряд идущие ячейки
+ * выводятся без перемещения), цвет переключается только при смене. Если
+ * размеры экранов различаются, экран очищается и next выводится целиком.
+ * В конце курсор ставится в позицию (cursorRow, cursorColumn).
+ *
+ * @param previous Экран, показанный в терминале
+ * @param next Новый кадр
+ * @param cursorRow Строка курсора
+ * @param cursorColumn Столбец курсора
+ * @param out Строка, к которой добавляется вывод
+ * @return Количество выведенных ячеек
+ */
+size_t diffScreens(const ScreenBuffer& previous, const ScreenBuffer& next,
+                   size_t cursorRow, size_t cursorColumn, std::string& out);
+
+#endif // SCREEN_BUFFER_H
@@ -0,0 +1,231 @@
+#include "sha256.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+/// Константы раундов SHA-256
+constexpr uint32_t kRoundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+/**
+ * @brief Циклически сдвигает слово вправо
+ * @param value Слово
+ * @param bits Величина сдвига (от 1 до 31)
+ * @return Результат сдвига
+ */
+inline uint32_t rotr(uint32_t value, unsigned bits) {
+    return (value >> bits) | (value << (32 - bits));
+}
+
+/**
+ * @brief Читает слово в порядке байтов big-endian
+ * @param p Адрес слова
+ * @return Значение слова
+ */
+inline uint32_t loadBigEndian(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+/**
+ * @brief Записывает слово в порядке байтов big-endian
+ * @param p Адрес слова
+ * @param value Значение слова
+ */
+inline void storeBigEndian(uint8_t* p, uint32_t value) {
+    p[0] = uint8_t(value >> 24);
+    p[1] = uint8_t(value >> 16);
+    p[2] = uint8_t(value >> 8);
+    p[3] = uint8_t(value);
+}
+
+} // namespace
+
+/**
+ * @brief Создает вычислитель в начальном состоянии
+ */
+Sha256::Sha256()
+    : state{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+            0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19},
+      block{}, buffered(0), length(0) {}
+
+/**
+ * @brief Обрабатывает один блок сообщения
+ * @param data Блок размером kBlockSize байт
+ */
+void Sha256::compress(const uint8_t* data) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = loadBigEndian(data + 4 * i);
+    }
+    for (int i = 16; i < 64; ++i) {
+        uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; ++i) {
+        uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+        uint32_t choice = (e & f) ^ (~e & g);
+        uint32_t t1 = h + s1 + choice + kRoundConstants[i] + w[i];
+        uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+        uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+        uint32_t t2 = s0 + majority;
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+/**
+ * @brief Добавляет данные к хешируемому сообщению
+ * @param data Данные
+ * @param size Размер данных в байтах
+ */
+void Sha256::update(const void* data, size_t size) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    length += size;
+    if (buffered > 0) {
+        size_t take = std::min(size, kBlockSize - buffered);
+        std::memcpy(block.data() + buffered, p, take);
+        buffered += take;
+        p += take;
+        size -= take;
+        if (buffered < kBlockSize) return;
+        compress(block.data());
+        buffered = 0;
+    }
+    for (; size >= kBlockSize; p += kBlockSize, size -= kBlockSize) {
+        compress(p);
+    }
+    std::memcpy(block.data(), p, size);
+    buffered = size;
+}
+
+/**
+ * @brief Завершает вычисление
+ * @return Хеш сообщения
+ */
+Sha256::Digest Sha256::finish() {
+    const uint64_t bits = length * 8;
+    block[buffered++] = 0x80;
+    if (buffered > kBlockSize - 8) {
+        std::fill(block.begin() + buffered, block.end(), 0);
+        compress(block.data());
+        buffered = 0;
+    }
+    std::fill(block.begin() + buffered, block.end() - 8, 0);
+    storeBigEndian(block.data() + kBlockSize - 8, uint32_t(bits >> 32));
+    storeBigEndian(block.data() + kBlockSize - 4, uint32_t(bits));
+    compress(block.data());
+
+    Digest digest;
+    for (int i = 0; i < 8; ++i) {
+        storeBigEndian(digest.data() + 4 * i, state[i]);
+    }
+    return digest;
+}
+
+/**
+ * @brief Вычисляет хеш одного сообщения
+ * @param data Данные
+ * @param size Размер данных в байтах
+ * @return Хеш сообщения
+ */
+Sha256::Digest Sha256::hash(const void* data, size_t size) {
+    Sha256 sha;
+    sha.update(data, size);
+    return sha.finish();
+}
+
+/**
+ * @brief Создает вычислитель для указанного ключа
+ * @param key Ключ
+ * @param size Размер ключа в байтах
+ */
+HmacSha256::HmacSha256(const void* key, size_t size) {
+    uint8_t pad[Sha256::kBlockSize] = {};
+    if (size > Sha256::kBlockSize) {
+        Sha256::Digest digest = Sha256::hash(key, size);
+        std::memcpy(pad, digest.data(), digest.size());
+    } else if (size > 0) {
+        std::memcpy(pad, key, size);
+    }
+
+    for (uint8_t& byte : pad) byte ^= 0x36;
+    inner.update(pad, sizeof(pad));
+    for (uint8_t& byte : pad) byte ^= 0x36 ^ 0x5c;
+    outer.update(pad, sizeof(pad));
+    std::memset(pad, 0, sizeof(pad));
+}
+
+/**
+ * @brief Добавляет данные к сообщению
+ * @param data Данные
+ * @param size Размер данных в байтах
+ */
+void HmacSha256::update(const void* data, size_t size) {
+    inner.update(data, size);
+}
+
+/**
+ * @brief Завершает вычисление
+ * @return Код аутентичности сообщения
+ */
+Sha256::Digest HmacSha256::finish() {
+    Sha256::Digest innerDigest = inner.finish();
+    outer.update(innerDigest.data(), innerDigest.size());
+    return outer.finish();
+}
+
+/**
+ * @brief Выводит ключ из пароля по PBKDF2-HMAC-SHA256
+ * @param password Пароль
+ * @param salt Соль
+ * @param saltSize Размер соли в байтах
+ * @param iterations Число итераций (не меньше 1)
+ * @param out Буфер для ключа
+ * @param outSize Требуемый размер ключа в байтах
+ */
+void pbkdf2HmacSha256(std::string_view password, const uint8_t* salt, size_t saltSize,
+                      uint32_t iterations, uint8_t* out, size_t outSize) {
+    const HmacSha256 keyed(password.data(), password.size());
+    for (uint32_t blockIndex = 1; outSize > 0; ++blockIndex) {
+        uint8_t counter[4];
+        storeBigEndian(counter, blockIndex);
+
+        HmacSha256 mac = keyed;
+        mac.update(salt, saltSize);
+        mac.update(counter, sizeof(counter));
+        Sha256::Digest u = mac.finish();
+        Sha256::Digest t = u;
+        for (uint32_t i = 1; i < iterations; ++i) {
+            mac = keyed;
+            mac.update(u.data(), u.size());
+            u = mac.finish();
+            for (size_t j = 0; j < t.size(); ++j) t[j] ^= u[j];
+        }
+
+        size_t take = std::min(outSize, t.size());
+        std::memcpy(out, t.data(), take);
+        out += take;
+        outSize -= take;
+    }
+}
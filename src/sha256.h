@@ -0,0 +1,108 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @file sha256.h
+ * @brief SHA-256, HMAC-SHA256 и PBKDF2-HMAC-SHA256 (FIPS 180-4, RFC 2104, RFC 8018)
+ */
+
+/**
+ * @brief Потоковое вычисление хеша SHA-256
+ */
+class Sha256 {
+public:
+    static constexpr size_t kDigestSize = 32; ///< Размер хеша в байтах
+    static constexpr size_t kBlockSize = 64;  ///< Размер блока сжатия в байтах
+
+    using Digest = std::array<uint8_t, kDigestSize>;
+
+    /**
+     * @brief Создает вычислитель в начальном состоянии
+     */
+    Sha256();
+
+    /**
+     * @brief Добавляет данные к хешируемому сообщению
+     * @param data Данные
+     * @param size Размер данных в байтах
+     */
+    void update(const void* data, size_t size);
+
+    /**
+     * @brief Завершает вычисление
+     * @return Хеш сообщения
+     */
+    Digest finish();
+
+    /**
+     * @brief Вычисляет хеш одного сообщения
+     * @param data Данные
+     * @param size Размер данных в байтах
+     * @return Хеш сообщения
+     */
+    static Digest hash(const void* data, size_t size);
+
+private:
+    /**
+     * @brief Обрабатывает один блок сообщения
+     * @param data Блок размером kBlockSize байт
+     */
+    void compress(const uint8_t* data);
+
+    std::array<uint32_t, 8> state;         ///< Промежуточное значение хеша
+    std::array<uint8_t, kBlockSize> block; ///< Неполный блок сообщения
+    size_t buffered;                       ///< Заполненная часть блока
+    uint64_t length;                       ///< Длина сообщения в байтах
+};
+
+/**
+ * @brief Потоковое вычисление HMAC-SHA256
+ *
+ * Копия объекта, которому передан только ключ, продолжает вычисление с уже
+ * обработанными блоками ключа: так PBKDF2 не хеширует ключ на каждой итерации.
+ */
+class HmacSha256 {
+public:
+    /**
+     * @brief Создает вычислитель для указанного ключа
+     * @param key Ключ
+     * @param size Размер ключа в байтах
+     */
+    HmacSha256(const void* key, size_t size);
+
+    /**
+     * @brief Добавляет данные к сообщению
+     * @param data Данные
+     * @param size Размер данных в байтах
+     */
+    void update(const void* data, size_t size);
+
+    /**
+     * @brief Завершает вычисление
+     * @return Код аутентичности сообщения
+     */
+    Sha256::Digest finish();
+
+private:
+    Sha256 inner; ///< Хеш (ключ ^ ipad) || сообщение
+    Sha256 outer; ///< Хеш (ключ ^ opad), продолжаемый внутренним хешем
+};
+
+/**
+ * @brief Выводит ключ из пароля по PBKDF2-HMAC-SHA256
+ * @param password Пароль
+ * @param salt Соль
+ * @param saltSize Размер соли в байтах
+ * @param iterations Число итераций (не меньше 1)
+ * @param out Буфер для ключа
+ * @param outSize Требуемый размер ключа в байтах
+ */
+void pbkdf2HmacSha256(std::string_view password, const uint8_t* salt, size_t saltSize,
+                      uint32_t iterations, uint8_t* out, size_t outSize);
+
+#endif // SHA256_H
@@ -0,0 +1,58 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+/**
+ * @class SpscQueue
+ * @brief Очередь без блокировок для одного производителя и одного потребителя
+ *
+ * Кольцевой буфер фиксированного размера. Производитель пишет только
+ * в tail, потребитель - только в head; элемент публикуется сохранением
+ * tail с release и виден потребителю после чтения tail с acquire.
+ * Индексы лежат в разных строках кэша, чтобы потоки не мешали друг другу.
+ *
+ * @tparam T Тип элемента (перемещаемый, с конструктором по умолчанию)
+ * @tparam Capacity Количество ячеек (степень двойки)
+ */
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+    /**
+     * @brief Добавляет элемент (вызывается только производителем)
+     * @param value Элемент; перемещается только при успехе
+     * @return false если очередь заполнена
+     */
+    bool tryPush(T& value) {
+        const size_t tail = tailIndex.load(std::memory_order_relaxed);
+        if (tail - headIndex.load(std::memory_order_acquire) == Capacity) return false;
+        slots[tail & (Capacity - 1)] = std::move(value);
+        tailIndex.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Извлекает элемент (вызывается только потребителем)
+     * @param value Извлеченный элемент
+     * @return false если очередь пуста
+     */
+    bool tryPop(T& value) {
+        const size_t head = headIndex.load(std::memory_order_relaxed);
+        if (head == tailIndex.load(std::memory_order_acquire)) return false;
+        value = std::move(slots[head & (Capacity - 1)]);
+        headIndex.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::array<T, Capacity> slots;                 ///< Ячейки кольцевого буфера
+    alignas(64) std::atomic<size_t> headIndex{0};  ///< Следующий извлекаемый элемент
+    alignas(64) std::atomic<size_t> tailIndex{0};  ///< Следующая свободная ячейка
+};
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,496 @@
+#include "syntax_highlighter.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <limits>
+#include <utility>
+#include "keyword_tables.h"
+
+namespace {
+
+/// Цвета лексем (ANSI), в порядке TokenKind
+constexpr std::array<std::string_view, 4> kColors = {
+    "\033[1;32m", // Keyword
+    "\033[36m",   // Number
+    "\033[33m",   // String
+    "\033[90m"    // Comment
+};
+
+/// Сброс цвета
+constexpr std::string_view kReset = "\033[0m";
+
+/**
+ * @brief Проверяет, может ли байт входить в идентификатор
+ * @param c Байт
+ * @return true для букв, цифр, '_' и байтов UTF-8 вне ASCII
+ */
+bool isIdentifierByte(unsigned char c) {
+    return std::isalnum(c) || c == '_' || c >= 0x80;
+}
+
+/**
+ * @brief Разбор одной строки: общие для всех языков виды лексем
+ */
+struct LineLexer {
+    std::string_view line;          ///< Строка (не длиннее 4 ГБ)
+    LexState& state;                ///< Текущее состояние
+    std::vector<TokenSpan>& tokens; ///< Найденные лексемы
+
+    /**
+     * @brief Добавляет непустую лексему [from, to)
+     * @param from Начало лексемы
+     * @param to Конец лексемы
+     * @param kind Вид лексемы
+     */
+    void emit(size_t from, size_t to, TokenKind kind) {
+        if (to > from) {
+            tokens.push_back({static_cast<uint32_t>(from), static_cast<uint32_t>(to - from), kind});
+        }
+    }
+
+    /**
+     * @brief Выделяет многострочную лексему до закрывающей последовательности
+     * @param from Начало лексемы
+     * @param searchFrom Позиция, с которой ищется закрывающая последовательность
+     * @param close Закрывающая последовательность
+     * @param open Состояние, если последовательность не найдена в строке
+     * @param kind Вид лексемы
+     * @return Позиция после лексемы
+     */
+    size_t until(size_t from, size_t searchFrom, std::string_view close, LexState open, TokenKind kind) {
+        size_t found = line.find(close, searchFrom);
+        if (found == std::string_view::npos) {
+            emit(from, line.size(), kind);
+            state = open;
+            return line.size();
+        }
+        emit(from, found + close.size(), kind);
+        state = LexState::Normal;
+        return found + close.size();
+    }
+
+    /**
+     * @brief Выделяет строковый литерал, заканчивающийся в этой же строке
+     * @param from Позиция открывающей кавычки
+     * @param escapes Экранирует ли '\\' следующий символ
+     * @return Позиция после литерала
+     */
+    size_t quoted(size_t from, bool escapes) {
+        const char quote = line[from];
+        size_t i = from + 1;
+        while (i < line.size() && line[i] != quote) {
+            i += escapes && line[i] == '\\' ? 2 : 1;
+        }
+        i = std::min(i + 1, line.size());
+        emit(from, i, TokenKind::String);
+        return i;
+    }
+
+    /**
+     * @brief Выделяет число (цифра и следующие символы идентификатора и точки)
+     * @param from Позиция первой цифры
+     * @return Позиция после числа
+     */
+    size_t number(size_t from) {
+        size_t i = from + 1;
+        while (i < line.size() &&
+               (isIdentifierByte(static_cast<unsigned char>(line[i])) || line[i] == '.')) ++i;
+        emit(from, i, TokenKind::Number);
+        return i;
+    }
+
+    /**
+     * @brief Выделяет идентификатор, если он ключевое слово
+     * @param from Начало идентификатора
+     * @param keywords Таблица ключевых слов
+     * @param dash Входит ли '-' в слово
+     * @return Позиция после идентификатора
+     */
+    template <typename Table>
+    size_t word(size_t from, const Table& keywords, bool dash = false) {
+        size_t i = from + 1;
+        while (i < line.size() &&
+               (isIdentifierByte(static_cast<unsigned char>(line[i])) || (dash && line[i] == '-'))) ++i;
+        if (keywords.contains(line.substr(from, i - from))) emit(from, i, TokenKind::Keyword);
+        return i;
+    }
+};
+
+/**
+ * @brief Разбирает строку C/C++
+ * @param lexer Разбор строки
+ */
+void lexCpp(LineLexer& lexer) {
+    std::string_view line = lexer.line;
+    size_t i = 0;
+    if (lexer.state == LexState::BlockComment) {
+        i = lexer.until(0, 0, "*/", LexState::BlockComment, TokenKind::Comment);
+    }
+    while (i < line.size()) {
+        unsigned char c = static_cast<unsigned char>(line[i]);
+        if (c == '/' && i + 1 < line.size() && line[i + 1] == '/') {
+            lexer.emit(i, line.size(), TokenKind::Comment);
+            break;
+        }
+        if (c == '/' && i + 1 < line.size() && line[i + 1] == '*') {
+            i = lexer.until(i, i + 2, "*/", LexState::BlockComment, TokenKind::Comment);
+        } else if (c == '"' || c == '\'') {
+            i = lexer.quoted(i, true);
+        } else if (std::isdigit(c)) {
+            i = lexer.number(i);
+        } else if (isIdentifierByte(c)) {
+            i = lexer.word(i, kCppKeywords);
+        } else {
+            ++i;
+        }
+    }
+}
+
+/**
+ * @brief Разбирает строку Python
+ * @param lexer Разбор строки
+ */
+void lexPython(LineLexer& lexer) {
+    std::string_view line = lexer.line;
+    size_t i = 0;
+    if (lexer.state == LexState::TripleDoubleString) {
+        i = lexer.until(0, 0, "\"\"\"", LexState::TripleDoubleString, TokenKind::String);
+    } else if (lexer.state == LexState::TripleSingleString) {
+        i = lexer.until(0, 0, "'''", LexState::TripleSingleString, TokenKind::String);
+    }
+    while (i < line.size()) {
+        unsigned char c = static_cast<unsigned char>(line[i]);
+        if (c == '#') {
+            lexer.emit(i, line.size(), TokenKind::Comment);
+            break;
+        }
+        if (c == '"' || c == '\'') {
+            if (line.compare(i, 3, c == '"' ? "\"\"\"" : "'''") == 0) {
+                i = c == '"'
+                    ? lexer.until(i, i + 3, "\"\"\"", LexState::TripleDoubleString, TokenKind::String)
+                    : lexer.until(i, i + 3, "'''", LexState::TripleSingleString, TokenKind::String);
+            } else {
+                i = lexer.quoted(i, true);
+            }
+        } else if (std::isdigit(c)) {
+            i = lexer.number(i);
+        } else if (isIdentifierByte(c)) {
+            i = lexer.word(i, kPythonKeywords);
+        } else {
+            ++i;
+        }
+    }
+}
+
+/**
+ * @brief Разбирает строку командной оболочки
+ * @param lexer Разбор строки
+ */
+void lexShell(LineLexer& lexer) {
+    std::string_view line = lexer.line;
+    size_t i = 0;
+    while (i < line.size()) {
+        unsigned char c = static_cast<unsigned char>(line[i]);
+        // '#' starts a comment only at the beginning of a word
+        if (c == '#' && (i == 0 || std::isspace(static_cast<unsigned char>(line[i - 1])))) {
+            lexer.emit(i, line.size(), TokenKind::Comment);
+            break;
+        }
+        if (c == '"' || c == '\'') {
+            i = lexer.quoted(i, c == '"');
+        } else if (c == '$') {
+            // Variable names are never keywords
+            ++i;
+            while (i < line.size() && isIdentifierByte(static_cast<unsigned char>(line[i]))) ++i;
+        } else if (std::isdigit(c)) {
+            i = lexer.number(i);
+        } else if (isIdentifierByte(c)) {
+            i = lexer.word(i, kShellKeywords, true);
+        } else {
+            ++i;
+        }
+    }
+}
+
+/**
+ * @brief Сравнивает строки ASCII без учета регистра
+ * @param a Первая строка
+ * @param b Вторая строка
+ * @return true если строки совпадают без учета регистра
+ */
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+        return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+    });
+}
+
+} // namespace
+
+/**
+ * @brief Определяет язык по расширению файла
+ * @param path Путь к файлу (пустой - новый документ, подсвечивается как C++)
+ * @return Язык или PlainText для неизвестного расширения
+ */
+Language languageFromPath(std::string_view path) {
+    if (path.empty()) return Language::Cpp;
+
+    static const std::pair<std::string_view, Language> extensions[] = {
+        {"c", Language::Cpp}, {"h", Language::Cpp}, {"cc", Language::Cpp}, {"cpp", Language::Cpp},
+        {"cxx", Language::Cpp}, {"hh", Language::Cpp}, {"hpp", Language::Cpp}, {"hxx", Language::Cpp},
+        {"inl", Language::Cpp}, {"py", Language::Python}, {"pyw", Language::Python},
+        {"pyi", Language::Python}, {"sh", Language::Shell}, {"bash", Language::Shell},
+        {"zsh", Language::Shell}, {"ksh", Language::Shell}};
+
+    size_t name = path.find_last_of("/\\");
+    name = name == std::string_view::npos ? 0 : name + 1;
+    size_t dot = path.rfind('.');
+    if (dot == std::string_view::npos || dot < name) return Language::PlainText;
+    std::string_view extension = path.substr(dot + 1);
+    for (const auto& entry : extensions) {
+        if (equalsIgnoreCase(extension, entry.first)) return entry.second;
+    }
+    return Language::PlainText;
+}
+
+/**
+ * @brief Создает недействительную (непостроенную) разметку
+ */
+SyntaxHighlighter::SyntaxHighlighter()
+    : language(Language::Cpp), pending(0), dirtyEnd(0), valid(false) {}
+
+/**
+ * @brief Подготавливает разметку документа, все строки которой еще не разобраны
+ * @param lineCount Количество строк документа
+ */
+void SyntaxHighlighter::reset(size_t lineCount) {
+    cache.clear();
+    lines.clear();
+    lines.resize(lineCount);
+    pending = 0;
+    dirtyEnd = lineCount;
+    valid = true;
+}
+
+/**
+ * @brief Освобождает разметку и помечает ее недействительной
+ */
+void SyntaxHighlighter::invalidate() {
+    std::vector<LineTokens>().swap(lines);
+    cache.clear();
+    pending = 0;
+    dirtyEnd = 0;
+    valid = false;
+}
+
+/**
+ * @brief Задает язык; при смене языка разметка становится недействительной
+ * @param language Язык
+ */
+void SyntaxHighlighter::setLanguage(Language language) {
+    if (language == this->language) return;
+    this->language = language;
+    invalidate();
+}
+
+/**
+ * @brief Учитывает замену диапазона строк
+ * @param first Индекс первой замененной строки
+ * @param removed Количество строк до замены
+ * @param added Количество строк после замены
+ */
+void SyntaxHighlighter::update(size_t first, size_t removed, size_t added) {
+    // Cached lines after the edit move with it; the edited ones are dropped
+    if (removed == added) {
+        for (size_t i = first; i < first + removed && !cache.empty(); ++i) {
+            cache.erase(i);
+        }
+    } else if (!cache.empty()) {
+        std::unordered_map<size_t, LineTokens> moved;
+        moved.reserve(cache.size());
+        for (auto& [index, entry] : cache) {
+            if (index < first) {
+                moved.emplace(index, std::move(entry));
+            } else if (index >= first + removed) {
+                moved.emplace(index - removed + added, std::move(entry));
+            }
+        }
+        cache.swap(moved);
+    }
+    if (!valid) return;
+
+    auto at = lines.erase(lines.begin() + first, lines.begin() + first + removed);
+    lines.insert(at, added, LineTokens());
+
+    // Lines past the edit keep their tokens; the first of them is rechecked
+    // against the new end state of the edited range
+    dirtyEnd = dirtyEnd > first + removed ? dirtyEnd - removed + added : first + added;
+    pending = std::min(pending, first);
+}
+
+/**
+ * @brief Разбирает строки [from, to), считая, что строка from начинается в обычном состоянии
+ * @param storage Хранилище строк
+ * @param from Первая строка
+ * @param to Строка за последней
+ */
+void SyntaxHighlighter::lexLines(const TextStorage& storage, size_t from, size_t to) {
+    LexState state = LexState::Normal;
+    storage.forEachLine(from, to, [&](size_t i, std::string_view line) {
+        lexInto(line, state, lines[i]);
+        state = lines[i].end;
+    });
+}
+
+/**
+ * @brief Приводит разметку строк [0, last) в соответствие с документом
+ *
+ * Просмотр начинается с первой строки, которая может быть неверной, и
+ * прекращается, как только строка за пределами правок оказывается разобранной
+ * с тем же начальным состоянием: все строки после нее уже согласованы.
+ *
+ * @param storage Хранилище строк
+ * @param last Строка за последней нужной
+ * @return Количество заново разобранных строк
+ */
+size_t SyntaxHighlighter::refresh(const TextStorage& storage, size_t last) {
+    if (!valid) return 0;
+    last = std::min(last, lines.size());
+
+    size_t relexed = 0;
+    size_t i = pending;
+    while (i < lines.size()) {
+        LexState start = i == 0 ? LexState::Normal : lines[i - 1].end;
+        bool current = lines[i].lexed && lines[i].start == start;
+        if (current && i >= dirtyEnd) {
+            i = lines.size();
+            break;
+        }
+        if (i >= last) break;
+        if (!current) {
+            lexAt(storage, i, start);
+            ++relexed;
+        }
+        ++i;
+    }
+    pending = i;
+    dirtyEnd = std::max(dirtyEnd, pending);
+    return relexed;
+}
+
+/**
+ * @brief Разбирает строку заново с заданным начальным состоянием
+ * @param storage Хранилище строк
+ * @param index Индекс строки
+ * @param start Состояние в начале строки
+ */
+void SyntaxHighlighter::lexAt(const TextStorage& storage, size_t index, LexState start) {
+    lexInto(storage.line(index), start, lines[index]);
+}
+
+/**
+ * @brief Разбирает строку в запись разметки
+ * @param line Содержимое строки
+ * @param start Состояние в начале строки
+ * @param entry Запись, получающая лексемы и состояния
+ */
+void SyntaxHighlighter::lexInto(std::string_view line, LexState start, LineTokens& entry) const {
+    LexState state = start;
+    entry.tokens.clear();
+    lexLine(line, language, state, entry.tokens);
+    entry.start = start;
+    entry.end = state;
+    entry.lexed = true;
+}
+
+/**
+ * @brief Готовит лексемы строк [first, last)
+ *
+ * Без полной разметки начальное состояние определяется разбором
+ * kLookbackLines предыдущих строк: многострочный комментарий, открытый
+ * раньше, не учитывается. Строки из кэша, разобранные с тем же начальным
+ * состоянием, повторно не разбираются.
+ *
+ * @param storage Хранилище строк
+ * @param first Первая строка
+ * @param last Строка за последней
+ * @return Количество заново разобранных строк
+ */
+size_t SyntaxHighlighter::prepare(const TextStorage& storage, size_t first, size_t last) {
+    if (valid) return refresh(storage, last);
+    last = std::min(last, storage.lineCount());
+    if (first >= last) return 0;
+
+    const size_t sync = first > kLookbackLines ? first - kLookbackLines : 0;
+    if (cache.size() + (last - sync) > kCacheLines) {
+        cache.clear();
+    }
+    size_t relexed = 0;
+    LexState state = LexState::Normal;
+    storage.forEachLine(sync, last, [&](size_t i, std::string_view line) {
+        LineTokens& entry = cache[i];
+        if (!entry.lexed || entry.start != state) {
+            lexInto(line, state, entry);
+            ++relexed;
+        }
+        state = entry.end;
+    });
+    return relexed;
+}
+
+/**
+ * @brief Возвращает лексемы строки (после refresh() или prepare())
+ * @param index Индекс строки
+ * @return Лексемы в порядке следования
+ */
+const std::vector<TokenSpan>& SyntaxHighlighter::tokens(size_t index) const {
+    return valid ? lines[index].tokens : cache.at(index).tokens;
+}
+
+/**
+ * @brief Возвращает состояние лексера в конце строки (после refresh() или prepare())
+ * @param index Индекс строки
+ * @return Состояние
+ */
+LexState SyntaxHighlighter::endState(size_t index) const {
+    return valid ? lines[index].end : cache.at(index).end;
+}
+
+/**
+ * @brief Разбирает одну строку
+ *
+ * Ключевые слова распознаются по таблицам с совершенным хешированием.
+ * Строки длиннее 4 ГБ разбираются только в пределах первых 4 ГБ.
+ *
+ * @param line Содержимое строки
+ * @param language Язык
+ * @param state Состояние в начале строки; заменяется состоянием в конце
+ * @param tokens Вектор, в который записываются лексемы
+ */
+void SyntaxHighlighter::lexLine(std::string_view line, Language language, LexState& state,
+                                std::vector<TokenSpan>& tokens) {
+    LineLexer lexer{line.substr(0, std::numeric_limits<uint32_t>::max()), state, tokens};
+    switch (language) {
+        case Language::PlainText: break;
+        case Language::Cpp: lexCpp(lexer); break;
+        case Language::Python: lexPython(lexer); break;
+        case Language::Shell: lexShell(lexer); break;
+    }
+}
+
+/**
+ * @brief Дописывает строку с ANSI-последовательностями цвета вокруг лексем
+ * @param line Содержимое строки
+ * @param tokens Лексемы строки
+ * @param out Строка, к которой добавляется результат
+ */
+void SyntaxHighlighter::render(std::string_view line, const std::vector<TokenSpan>& tokens, std::string& out) {
+    size_t pos = 0;
+    for (const TokenSpan& token : tokens) {
+        out.append(line.data() + pos, token.offset - pos);
+        out.append(kColors[static_cast<size_t>(token.kind)]);
+        out.append(line.data() + token.offset, token.length);
+        out.append(kReset);
+        pos = token.offset + token.length;
+    }
+    out.append(line.data() + pos, line.size() - pos);
+}
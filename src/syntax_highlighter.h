@@ -0,0 +1,233 @@
+#ifndef SYNTAX_HIGHLIGHTER_H
+#define SYNTAX_HIGHLIGHTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "text_storage.h"
+
+/**
+ * @brief Вид лексемы, выделяемой при подсветке
+ */
+enum class TokenKind : uint8_t {
+    Keyword, ///< Ключевое слово
+    Number,  ///< Числовой литерал
+    String,  ///< Строковый или символьный литерал
+    Comment  ///< Комментарий
+};
+
+/**
+ * @brief Лексема внутри строки: смещение и длина в байтах
+ */
+struct TokenSpan {
+    uint32_t offset; ///< Смещение от начала строки
+    uint32_t length; ///< Длина в байтах
+    TokenKind kind;  ///< Вид лексемы
+
+    bool operator==(const TokenSpan& other) const {
+        return offset == other.offset && length == other.length && kind == other.kind;
+    }
+};
+
+/**
+ * @brief Язык, правила которого использует лексер
+ */
+enum class Language : uint8_t {
+    PlainText, ///< Без подсветки
+    Cpp,       ///< C и C++
+    Python,    ///< Python
+    Shell      ///< Командная оболочка (sh, bash, zsh)
+};
+
+/**
+ * @brief Определяет язык по расширению файла
+ * @param path Путь к файлу (пустой - новый документ, подсвечивается как C++)
+ * @return Язык или PlainText для неизвестного расширения
+ */
+Language languageFromPath(std::string_view path);
+
+/**
+ * @brief Состояние лексера на границе строк
+ */
+enum class LexState : uint8_t {
+    Normal,             ///< Обычный текст
+    BlockComment,       ///< Внутри многострочного комментария C
+    TripleDoubleString, ///< Внутри строки Python в тройных двойных кавычках
+    TripleSingleString  ///< Внутри строки Python в тройных одинарных кавычках
+};
+
+/**
+ * @class SyntaxHighlighter
+ * @brief Разметка подсветки синтаксиса, хранящаяся отдельно от текста
+ *
+ * Для каждой строки хранятся лексемы и состояния лексера в начале и в конце
+ * строки, разобранной по правилам выбранного языка. Правка диапазона строк
+ * помечает только его; при обновлении заново разбираются помеченные строки и
+ * следующие за ними, пока состояние в начале строки не совпадет с прежним.
+ *
+ * Полная разметка строится для всего документа. Без нее prepare() разбирает
+ * только запрошенные строки и kLookbackLines строк перед ними (начиная
+ * в обычном состоянии) и хранит их в ограниченном кэше, поэтому стоимость
+ * вывода не зависит от размера файла. Замена документа целиком сбрасывает
+ * и разметку, и кэш.
+ */
+class SyntaxHighlighter {
+public:
+    /// Наибольшее количество строк в кэше разметки видимых строк
+    static constexpr size_t kCacheLines = 1 << 16;
+
+    /// Количество строк перед видимыми, разбираемых для определения начального состояния
+    static constexpr size_t kLookbackLines = 512;
+
+    /**
+     * @brief Создает недействительную (непостроенную) разметку
+     */
+    SyntaxHighlighter();
+
+    /**
+     * @brief Подготавливает разметку документа, все строки которой еще не разобраны
+     * @param lineCount Количество строк документа
+     */
+    void reset(size_t lineCount);
+
+    /**
+     * @brief Освобождает разметку и помечает ее недействительной
+     */
+    void invalidate();
+
+    /**
+     * @brief Задает язык; при смене языка разметка становится недействительной
+     * @param language Язык
+     */
+    void setLanguage(Language language);
+
+    /**
+     * @brief Возвращает язык разметки
+     * @return Язык
+     */
+    Language getLanguage() const { return language; }
+
+    /**
+     * @brief Проверяет, построена ли полная разметка документа
+     * @return true если разметка подготовлена и учитывает все правки
+     */
+    bool isValid() const { return valid; }
+
+    /**
+     * @brief Учитывает замену диапазона строк
+     * @param first Индекс первой замененной строки
+     * @param removed Количество строк до замены
+     * @param added Количество строк после замены
+     */
+    void update(size_t first, size_t removed, size_t added);
+
+    /**
+     * @brief Разбирает строки [from, to), считая, что строка from начинается в обычном состоянии
+     *
+     * Непересекающиеся диапазоны можно разбирать параллельно; неверно угаданное
+     * начальное состояние исправляется следующим вызовом refresh().
+     *
+     * @param storage Хранилище строк
+     * @param from Первая строка
+     * @param to Строка за последней
+     */
+    void lexLines(const TextStorage& storage, size_t from, size_t to);
+
+    /**
+     * @brief Приводит разметку строк [0, last) в соответствие с документом
+     * @param storage Хранилище строк
+     * @param last Строка за последней нужной
+     * @return Количество заново разобранных строк
+     */
+    size_t refresh(const TextStorage& storage, size_t last);
+
+    /**
+     * @brief Готовит лексемы строк [first, last)
+     *
+     * При построенной полной разметке вызывает refresh(); иначе разбирает
+     * строки через кэш видимых строк.
+     *
+     * @param storage Хранилище строк
+     * @param first Первая строка
+     * @param last Строка за последней
+     * @return Количество заново разобранных строк
+     */
+    size_t prepare(const TextStorage& storage, size_t first, size_t last);
+
+    /**
+     * @brief Возвращает лексемы строки (после refresh() или prepare())
+     * @param index Индекс строки
+     * @return Лексемы в порядке следования
+     */
+    const std::vector<TokenSpan>& tokens(size_t index) const;
+
+    /**
+     * @brief Возвращает состояние лексера в конце строки (после refresh() или prepare())
+     * @param index Индекс строки
+     * @return Состояние
+     */
+    LexState endState(size_t index) const;
+
+    /**
+     * @brief Возвращает количество строк в кэше видимых строк
+     * @return Размер кэша
+     */
+    size_t cachedLines() const { return cache.size(); }
+
+    /**
+     * @brief Разбирает одну строку
+     * @param line Содержимое строки
+     * @param language Язык
+     * @param state Состояние в начале строки; заменяется состоянием в конце
+     * @param tokens Вектор, в который записываются лексемы
+     */
+    static void lexLine(std::string_view line, Language language, LexState& state,
+                        std::vector<TokenSpan>& tokens);
+
+    /**
+     * @brief Дописывает строку с ANSI-последовательностями цвета вокруг лексем
+     * @param line Содержимое строки
+     * @param tokens Лексемы строки
+     * @param out Строка, к которой добавляется результат
+     */
+    static void render(std::string_view line, const std::vector<TokenSpan>& tokens, std::string& out);
+
+private:
+    /**
+     * @brief Разметка одной строки
+     */
+    struct LineTokens {
+        std::vector<TokenSpan> tokens;      ///< Лексемы
+        LexState start = LexState::Normal;  ///< Состояние, с которым строка разобрана
+        LexState end = LexState::Normal;    ///< Состояние в конце строки
+        bool lexed = false;                 ///< Строка разобрана после последней правки
+    };
+
+    std::vector<LineTokens> lines; ///< Полная разметка строк документа
+    std::unordered_map<size_t, LineTokens> cache; ///< Разметка видимых строк без полной разметки
+    Language language; ///< Язык, по правилам которого разбираются строки
+    size_t pending;    ///< Строки до этой разобраны верно
+    size_t dirtyEnd;   ///< Строки с этой согласованы между собой (не правились после разбора)
+    bool valid;        ///< Разметка соответствует документу
+
+    /**
+     * @brief Разбирает строку заново с заданным начальным состоянием
+     * @param storage Хранилище строк
+     * @param index Индекс строки
+     * @param start Состояние в начале строки
+     */
+    void lexAt(const TextStorage& storage, size_t index, LexState start);
+
+    /**
+     * @brief Разбирает строку в запись разметки
+     * @param line Содержимое строки
+     * @param start Состояние в начале строки
+     * @param entry Запись, получающая лексемы и состояния
+     */
+    void lexInto(std::string_view line, LexState start, LineTokens& entry) const;
+};
+
+#endif // SYNTAX_HIGHLIGHTER_H
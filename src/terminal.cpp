@@ -0,0 +1,295 @@
+#include "terminal.h"
+#include "screen_buffer.h"
+#include <cctype>
+
+#if defined(_WIN32)
+#include <windows.h>
+#define TEXT_EDITOR_HAS_WIN32_CONSOLE 1
+#elif defined(__unix__) || defined(__APPLE__)
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#define TEXT_EDITOR_HAS_TERMIOS 1
+#endif
+
+namespace {
+
+/// Переключение на альтернативный экран и обратно
+constexpr std::string_view kEnterScreen = "\033[?1049h\033[H";
+constexpr std::string_view kLeaveScreen = "\033[0m\033[?25h\033[?1049l";
+
+/**
+ * @brief Определяет клавишу по последовательности CSI или SS3
+ * @param final Завершающий байт
+ * @param parameter Первый числовой параметр (0 если отсутствует)
+ * @return Клавиша или KeyType::None
+ */
+KeyType escapeKey(char final, int parameter) {
+    switch (final) {
+        case 'A': return KeyType::Up;
+        case 'B': return KeyType::Down;
+        case 'C': return KeyType::Right;
+        case 'D': return KeyType::Left;
+        case 'H': return KeyType::Home;
+        case 'F': return KeyType::End;
+        case '~':
+            switch (parameter) {
+                case 1: case 7: return KeyType::Home;
+                case 4: case 8: return KeyType::End;
+                case 3: return KeyType::Delete;
+                case 5: return KeyType::PageUp;
+                case 6: return KeyType::PageDown;
+                default: return KeyType::None;
+            }
+        default: return KeyType::None;
+    }
+}
+
+/**
+ * @brief Определяет клавишу по управляющему байту
+ * @param c Байт меньше 0x20 или 0x7F
+ * @return Клавиша или KeyType::None
+ */
+KeyType controlKey(unsigned char c) {
+    switch (c) {
+        case '\r': case '\n': return KeyType::Enter;
+        case 0x7F: case 0x08: return KeyType::Backspace;
+        case 0x13: return KeyType::Save;
+        case 0x11: return KeyType::Quit;
+        case 0x1A: return KeyType::Undo;
+        case 0x19: return KeyType::Redo;
+        default: return KeyType::None;
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Добавляет прочитанные байты
+ * @param bytes Байты ввода
+ */
+void KeyDecoder::feed(std::string_view bytes) {
+    pending.append(bytes.data(), bytes.size());
+}
+
+/**
+ * @brief Извлекает следующую полную клавишу
+ * @param key Клавиша
+ * @return false если полной клавиши нет
+ */
+bool KeyDecoder::next(Key& key) {
+    if (pending.empty()) return false;
+    key = Key();
+    const unsigned char lead = static_cast<unsigned char>(pending[0]);
+    size_t used = 1;
+
+    if (lead == 0x1B) {
+        if (pending.size() < 2) return false;
+        if (pending[1] != '[' && pending[1] != 'O') {
+            // Alt+key: the key itself is decoded next
+            pending.erase(0, 1);
+            key.type = KeyType::Escape;
+            return true;
+        }
+        int parameter = 0;
+        bool hasParameter = false;
+        size_t i = 2;
+        while (i < pending.size() && (std::isdigit(static_cast<unsigned char>(pending[i])) || pending[i] == ';')) {
+            if (pending[i] != ';' && !hasParameter) parameter = parameter * 10 + (pending[i] - '0');
+            if (pending[i] == ';') hasParameter = true;
+            ++i;
+        }
+        if (i == pending.size()) return false;
+        key.type = escapeKey(pending[i], parameter);
+        used = i + 1;
+    } else if (lead < 0x20 || lead == 0x7F) {
+        key.type = lead == '\t' ? KeyType::Char : controlKey(lead);
+        if (lead == '\t') key.text = "\t";
+    } else {
+        used = utf8Length(lead);
+        if (pending.size() < used) return false;
+        key.type = KeyType::Char;
+        key.text = pending.substr(0, used);
+    }
+    pending.erase(0, used);
+    return true;
+}
+
+/**
+ * @brief Завершает неполную последовательность, если ввод закончился
+ * @param key Одиночный Esc или неизвестная клавиша
+ * @return false если незавершенных байтов нет
+ */
+bool KeyDecoder::expire(Key& key) {
+    if (pending.empty()) return false;
+    key = Key();
+    key.type = pending == "\033" ? KeyType::Escape : KeyType::None;
+    pending.clear();
+    return true;
+}
+
+/**
+ * @brief Переводит терминал в неканонический режим
+ */
+RawTerminal::RawTerminal() : active(false), savedInput(0), savedOutput(0), savedTermios(nullptr) {
+#if defined(TEXT_EDITOR_HAS_WIN32_CONSOLE)
+    HANDLE input = GetStdHandle(STD_INPUT_HANDLE);
+    HANDLE output = GetStdHandle(STD_OUTPUT_HANDLE);
+    DWORD inputMode = 0;
+    DWORD outputMode = 0;
+    if (!GetConsoleMode(input, &inputMode) || !GetConsoleMode(output, &outputMode)) return;
+    savedInput = inputMode;
+    savedOutput = outputMode;
+    inputMode &= ~(ENABLE_LINE_INPUT | ENABLE_ECHO_INPUT | ENABLE_PROCESSED_INPUT);
+    inputMode |= ENABLE_VIRTUAL_TERMINAL_INPUT;
+    outputMode |= ENABLE_VIRTUAL_TERMINAL_PROCESSING;
+    if (!SetConsoleMode(input, inputMode) || !SetConsoleMode(output, outputMode)) {
+        SetConsoleMode(input, savedInput);
+        SetConsoleMode(output, savedOutput);
+        return;
+    }
+    active = true;
+#elif defined(TEXT_EDITOR_HAS_TERMIOS)
+    if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO)) return;
+    auto* saved = new termios;
+    if (tcgetattr(STDIN_FILENO, saved) != 0) {
+        delete saved;
+        return;
+    }
+    termios raw = *saved;
+    raw.c_iflag &= ~(BRKINT | ICRNL | INPCK | ISTRIP | IXON);
+    raw.c_oflag &= ~(OPOST);
+    raw.c_cflag |= CS8;
+    raw.c_lflag &= ~(ECHO | ICANON | IEXTEN | ISIG);
+    raw.c_cc[VMIN] = 0;
+    raw.c_cc[VTIME] = 0;
+    if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) != 0) {
+        delete saved;
+        return;
+    }
+    savedTermios = saved;
+    active = true;
+#endif
+    if (active) write(kEnterScreen);
+}
+
+/**
+ * @brief Восстанавливает режим терминала
+ */
+RawTerminal::~RawTerminal() {
+    if (!active) return;
+    write(kLeaveScreen);
+#if defined(TEXT_EDITOR_HAS_WIN32_CONSOLE)
+    SetConsoleMode(GetStdHandle(STD_INPUT_HANDLE), savedInput);
+    SetConsoleMode(GetStdHandle(STD_OUTPUT_HANDLE), savedOutput);
+#elif defined(TEXT_EDITOR_HAS_TERMIOS)
+    auto* saved = static_cast<termios*>(savedTermios);
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, saved);
+    delete saved;
+#endif
+}
+
+/**
+ * @brief Возвращает размер окна терминала
+ * @param rows Количество строк
+ * @param columns Количество столбцов
+ * @return false если размер неизвестен
+ */
+bool RawTerminal::size(size_t& rows, size_t& columns) const {
+#if defined(TEXT_EDITOR_HAS_WIN32_CONSOLE)
+    CONSOLE_SCREEN_BUFFER_INFO info;
+    if (!GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info)) return false;
+    rows = static_cast<size_t>(info.srWindow.Bottom - info.srWindow.Top + 1);
+    columns = static_cast<size_t>(info.srWindow.Right - info.srWindow.Left + 1);
+    return true;
+#elif defined(TEXT_EDITOR_HAS_TERMIOS)
+    winsize window;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &window) != 0 || window.ws_row == 0 || window.ws_col == 0) {
+        return false;
+    }
+    rows = window.ws_row;
+    columns = window.ws_col;
+    return true;
+#else
+    (void)rows;
+    (void)columns;
+    return false;
+#endif
+}
+
+/**
+ * @brief Читает доступные байты ввода
+ * @param buffer Буфер
+ * @param capacity Размер буфера
+ * @param timeoutMs Наибольшее время ожидания в миллисекундах
+ * @return Количество прочитанных байтов (0 по истечении времени)
+ */
+size_t RawTerminal::read(char* buffer, size_t capacity, int timeoutMs) {
+    if (!active) return 0;
+#if defined(TEXT_EDITOR_HAS_WIN32_CONSOLE)
+    HANDLE input = GetStdHandle(STD_INPUT_HANDLE);
+    if (WaitForSingleObject(input, static_cast<DWORD>(timeoutMs)) != WAIT_OBJECT_0) return 0;
+    DWORD count = 0;
+    if (!ReadFile(input, buffer, static_cast<DWORD>(capacity), &count, nullptr)) return 0;
+    return count;
+#elif defined(TEXT_EDITOR_HAS_TERMIOS)
+    pollfd request{STDIN_FILENO, POLLIN, 0};
+    if (poll(&request, 1, timeoutMs) <= 0) return 0;
+    ssize_t count = ::read(STDIN_FILENO, buffer, capacity);
+    return count > 0 ? static_cast<size_t>(count) : 0;
+#else
+    (void)buffer;
+    (void)capacity;
+    (void)timeoutMs;
+    return 0;
+#endif
+}
+
+/**
+ * @brief Выводит байты одной записью
+ * @param bytes Данные
+ * @return true если записано все
+ */
+bool RawTerminal::write(std::string_view bytes) {
+#if defined(TEXT_EDITOR_HAS_WIN32_CONSOLE)
+    DWORD written = 0;
+    return WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), bytes.data(), static_cast<DWORD>(bytes.size()),
+                     &written, nullptr) && written == bytes.size();
+#elif defined(TEXT_EDITOR_HAS_TERMIOS)
+    // A frame normally goes out in one call; partial writes only continue it
+    while (!bytes.empty()) {
+        ssize_t count = ::write(STDOUT_FILENO, bytes.data(), bytes.size());
+        if (count <= 0) return false;
+        bytes.remove_prefix(static_cast<size_t>(count));
+    }
+    return true;
+#else
+    return bytes.empty();
+#endif
+}
+
+/**
+ * @brief Настраивает консоль на ввод и вывод в UTF-8
+ */
+void enableUtf8Console() {
+#if defined(TEXT_EDITOR_HAS_WIN32_CONSOLE)
+    SetConsoleOutputCP(CP_UTF8);
+    SetConsoleCP(CP_UTF8);
+#endif
+}
+
+/**
+ * @brief Проверяет, подключен ли стандартный ввод к терминалу
+ * @return false если ввод перенаправлен из файла или канала
+ */
+bool isInteractiveInput() {
+#if defined(TEXT_EDITOR_HAS_WIN32_CONSOLE)
+    DWORD mode = 0;
+    return GetConsoleMode(GetStdHandle(STD_INPUT_HANDLE), &mode) != 0;
+#elif defined(TEXT_EDITOR_HAS_TERMIOS)
+    return isatty(STDIN_FILENO) != 0;
+#else
+    return true;
+#endif
+}
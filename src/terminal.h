@@ -0,0 +1,148 @@
+#ifndef TERMINAL_H
+#define TERMINAL_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Вид нажатой клавиши
+ */
+enum class KeyType {
+    None,      ///< Неизвестная последовательность
+    Char,      ///< Печатный символ (text)
+    Enter,     ///< Ввод
+    Backspace, ///< Удаление символа слева
+    Delete,    ///< Удаление символа справа
+    Up,        ///< Стрелка вверх
+    Down,      ///< Стрелка вниз
+    Left,      ///< Стрелка влево
+    Right,     ///< Стрелка вправо
+    Home,      ///< Начало строки
+    End,       ///< Конец строки
+    PageUp,    ///< Страница вверх
+    PageDown,  ///< Страница вниз
+    Escape,    ///< Одиночный Esc
+    Save,      ///< Ctrl-S
+    Quit,      ///< Ctrl-Q
+    Undo,      ///< Ctrl-Z
+    Redo       ///< Ctrl-Y
+};
+
+/**
+ * @brief Нажатая клавиша
+ */
+struct Key {
+    KeyType type = KeyType::None; ///< Вид клавиши
+    std::string text;             ///< Символ UTF-8 для KeyType::Char
+};
+
+/**
+ * @class KeyDecoder
+ * @brief Разбирает байты ввода терминала на клавиши
+ *
+ * Понимает управляющие символы, последовательности CSI и SS3 для стрелок и
+ * клавиш навигации и многобайтовые символы UTF-8. Неполная последовательность
+ * ждет следующих байтов; одиночный Esc выдается через expire().
+ */
+class KeyDecoder {
+public:
+    /**
+     * @brief Добавляет прочитанные байты
+     * @param bytes Байты ввода
+     */
+    void feed(std::string_view bytes);
+
+    /**
+     * @brief Извлекает следующую полную клавишу
+     * @param key Клавиша
+     * @return false если полной клавиши нет
+     */
+    bool next(Key& key);
+
+    /**
+     * @brief Завершает неполную последовательность, если ввод закончился
+     * @param key Одиночный Esc или неизвестная клавиша
+     * @return false если незавершенных байтов нет
+     */
+    bool expire(Key& key);
+
+private:
+    std::string pending; ///< Непрочитанные байты
+};
+
+/**
+ * @class RawTerminal
+ * @brief Терминал в неканоническом режиме без эха на время жизни объекта
+ *
+ * Включает альтернативный экран; деструктор возвращает прежний режим и экран.
+ * На POSIX используется termios, в Windows - консоль с обработкой
+ * VT-последовательностей.
+ */
+class RawTerminal {
+public:
+    /**
+     * @brief Переводит терминал в неканонический режим
+     */
+    RawTerminal();
+
+    /**
+     * @brief Восстанавливает режим терминала
+     */
+    ~RawTerminal();
+
+    RawTerminal(const RawTerminal&) = delete;
+    RawTerminal& operator=(const RawTerminal&) = delete;
+
+    /**
+     * @brief Проверяет, удалось ли включить режим
+     * @return false если ввод или вывод не является терминалом
+     */
+    bool isActive() const { return active; }
+
+    /**
+     * @brief Возвращает размер окна терминала
+     * @param rows Количество строк
+     * @param columns Количество столбцов
+     * @return false если размер неизвестен
+     */
+    bool size(size_t& rows, size_t& columns) const;
+
+    /**
+     * @brief Читает доступные байты ввода
+     * @param buffer Буфер
+     * @param capacity Размер буфера
+     * @param timeoutMs Наибольшее время ожидания в миллисекундах
+     * @return Количество прочитанных байтов (0 по истечении времени)
+     */
+    size_t read(char* buffer, size_t capacity, int timeoutMs);
+
+    /**
+     * @brief Выводит байты одной записью
+     * @param bytes Данные
+     * @return true если записано все
+     */
+    bool write(std::string_view bytes);
+
+private:
+    bool active;              ///< Режим включен
+    unsigned long savedInput; ///< Прежний режим ввода консоли (Windows)
+    unsigned long savedOutput; ///< Прежний режим вывода консоли (Windows)
+    void* savedTermios;       ///< Прежние настройки termios (POSIX)
+};
+
+/**
+ * @brief Настраивает консоль на ввод и вывод в UTF-8
+ *
+ * В Windows переключает кодовые страницы консоли; терминалы POSIX передают
+ * байты UTF-8 без преобразования, и там функция ничего не делает.
+ */
+void enableUtf8Console();
+
+/**
+ * @brief Проверяет, подключен ли стандартный ввод к терминалу
+ * @return false если ввод перенаправлен из файла или канала
+ */
+bool isInteractiveInput();
+
+#endif // TERMINAL_H
@@ -2,10 +2,37 @@
 // test_editor.cpp
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include "doctest.h"
+#include "chacha20.h"
+#include "commands.h"
 #include "editor.h"
+#include "encrypted_file.h"
+#include "file_writer.h"
+#include "full_screen_editor.h"
+#include "keyword_tables.h"
+#include "line_ids.h"
+#include "piece_table.h"
+#include "poly1305.h"
+#include "rope.h"
+#include "screen_buffer.h"
+#include "sha256.h"
+#include "spsc_queue.h"
+#include "syntax_highlighter.h"
+#include "terminal.h"
+#include "text_kernels.h"
+#include "thread_pool.h"
+#include <atomic>
+#include <condition_variable>
+#include <random>
 #include <fstream>
 #include <filesystem>
+#include <functional>
+#include <future>
 #include <locale>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <sstream>
+#include <thread>
 /**
  * @file tests.cpp
  * @brief Модульные тесты для класса TextEditor
@@ -50,6 +77,42 @@ TEST_SUITE("TextEditor Tests") {
             std::filesystem::remove(newFile);
         }
 
+        SUBCASE("Saving replaces the file safely") {
+            namespace fs = std::filesystem;
+            auto readAll = [](const std::string& path) {
+                std::ifstream in(path, std::ios::binary);
+                return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            };
+            {
+                std::ofstream stale(testFile + ".tmp");
+                stale << "not ours";
+            }
+            const fs::perms mode = fs::perms::owner_read | fs::perms::owner_write | fs::perms::group_read;
+            fs::permissions(testFile, mode);
+            editor.loadFile(testFile);
+            editor.addLine("Line 4");
+            CHECK(editor.saveToFile());
+            CHECK(readAll(testFile) == testContent + "\nLine 4\n");
+            CHECK(readAll(testFile + ".tmp") == "not ours");
+            CHECK(fs::status(testFile).permissions() == mode);
+
+            std::error_code linked;
+            fs::create_symlink(testFile, "test_link.txt", linked);
+            if (!linked) {
+                CHECK(editor.saveToFile("test_link.txt"));
+                CHECK(fs::is_symlink("test_link.txt"));
+                CHECK(readAll(testFile) == testContent + "\nLine 4\n");
+                fs::remove("test_link.txt");
+            }
+
+            size_t leftovers = 0;
+            for (const auto& entry : fs::directory_iterator(".")) {
+                leftovers += entry.path().filename().string().rfind("." + testFile, 0) == 0;
+            }
+            CHECK(leftovers == 0);
+            fs::remove(testFile + ".tmp");
+        }
+
         SUBCASE("Create new file") {
             editor.createNewFile();
             CHECK(editor.getLines().empty());
@@ -168,6 +231,55 @@ TEST_SUITE("TextEditor Tests") {
         }
     }
 
+    TEST_CASE("UTF-8 case conversion") {
+        auto convert = [](std::string text, LetterCase mode) {
+            convertCase(&text[0], text.size(), mode);
+            return text;
+        };
+
+        SUBCASE("Alphabets") {
+            CHECK(convert("Привет, мир! Ёлка", LetterCase::Upper) == "ПРИВЕТ, МИР! ЁЛКА");
+            CHECK(convert("ПРИВЕТ, МИР! ЁЛКА", LetterCase::Lower) == "привет, мир! ёлка");
+            CHECK(convert("Ελληνικά γράμματα ς", LetterCase::Upper) == "ΕΛΛΗΝΙΚΆ ΓΡΆΜΜΑΤΑ Σ");
+            CHECK(convert("Àéîõü ÿ Łódź", LetterCase::Upper) == "ÀÉÎÕÜ Ÿ ŁÓDŹ");
+            CHECK(convert("ÀÉÎÕÜ Ÿ ŁÓDŹ", LetterCase::Lower) == "àéîõü ÿ łódź");
+            CHECK(convert("привет мИР и ещё", LetterCase::Title) == "Привет Мир И Ещё");
+        }
+
+        SUBCASE("Length-changing and invalid sequences are kept") {
+            CHECK(convert("straße ı", LetterCase::Upper) == "STRAßE ı");
+            std::string invalid = "a\xC3 b\xE2\x82 \xFF\x80z";
+            CHECK(convert(invalid, LetterCase::Upper) == "A\xC3 B\xE2\x82 \xFF\x80Z");
+        }
+
+        SUBCASE("Vector path matches per-character conversion") {
+            const std::vector<std::string> pool = {"a", "Z", " ", "q", "Ж", "я", "Ω", "ά", "é", "Ŧ",
+                                                   "€", "7", "\xC3", "\xE2", "ß"};
+            std::mt19937 rng(5);
+            for (int round = 0; round < 300; ++round) {
+                std::string text, upper, lower;
+                size_t pieces = rng() % 120;
+                for (size_t i = 0; i < pieces; ++i) {
+                    const std::string& piece = pool[rng() % pool.size()];
+                    text += piece;
+                    upper += convert(piece, LetterCase::Upper);
+                    lower += convert(piece, LetterCase::Lower);
+                }
+                CHECK(convert(text, LetterCase::Upper) == upper);
+                CHECK(convert(text, LetterCase::Lower) == lower);
+            }
+        }
+
+        SUBCASE("Editor line commands") {
+            TextEditor editor;
+            editor.addLine("съешь же ещё этих мягких французских булок");
+            CHECK(editor.toTitleCase(1));
+            CHECK(editor.getLine(1) == "Съешь Же Ещё Этих Мягких Французских Булок");
+            editor.changeAllLinesCase(1);
+            CHECK(editor.getLine(1) == "СЪЕШЬ ЖЕ ЕЩЁ ЭТИХ МЯГКИХ ФРАНЦУЗСКИХ БУЛОК");
+        }
+    }
+
     TEST_CASE("Undo/Redo") {
         TextEditor editor;
         editor.addLine("First line");
@@ -192,6 +304,44 @@ TEST_SUITE("TextEditor Tests") {
             TextEditor newEditor;
             CHECK_FALSE(newEditor.redo());
         }
+
+        SUBCASE("Undo and redo a chain of line edits") {
+            editor.addLine("Second line");
+            editor.addLine("Third line");
+            editor.replaceLine(2, "Changed");
+            editor.deleteLine(1);
+            CHECK(editor.getLines() == std::vector<std::string>{"Changed", "Third line"});
+
+            CHECK(editor.undo());
+            CHECK(editor.getLines() == std::vector<std::string>{"First line", "Changed", "Third line"});
+            CHECK(editor.undo());
+            CHECK(editor.getLines() == std::vector<std::string>{"First line", "Second line", "Third line"});
+            CHECK(editor.redo());
+            CHECK(editor.redo());
+            CHECK(editor.getLines() == std::vector<std::string>{"Changed", "Third line"});
+            CHECK_FALSE(editor.redo());
+        }
+
+        SUBCASE("Undo whole-document operations") {
+            editor.addLine("apple");
+            editor.filterLines("apple");
+            CHECK(editor.getLineCount() == 1);
+            editor.clearText();
+            CHECK(editor.getLineCount() == 0);
+
+            CHECK(editor.undo());
+            CHECK(editor.getLines() == std::vector<std::string>{"apple"});
+            CHECK(editor.undo());
+            CHECK(editor.getLines() == std::vector<std::string>{"First line", "apple"});
+            CHECK(editor.redo());
+            CHECK(editor.getLines() == std::vector<std::string>{"apple"});
+        }
+
+        SUBCASE("New edit clears redo") {
+            editor.undo();
+            editor.addLine("Other");
+            CHECK_FALSE(editor.redo());
+        }
     }
 
     TEST_CASE("Statistics") {
@@ -213,6 +363,39 @@ TEST_SUITE("TextEditor Tests") {
             size_t expected = strlen("First line") + strlen("Second line with more words") + strlen("Third");
             CHECK(editor.getCharCount() == expected);
         }
+
+        SUBCASE("Counters follow every edit") {
+            auto recount = [&] {
+                size_t words = 0;
+                for (const auto& line : editor.getLines()) {
+                    std::istringstream iss(line);
+                    std::string word;
+                    while (iss >> word) words++;
+                }
+                return words;
+            };
+            editor.insertLine(2, "  spaced\tout   words ");
+            CHECK(editor.getWordCount() == recount());
+            editor.replaceLine(1, "");
+            CHECK(editor.getWordCount() == recount());
+            editor.deleteLine(3);
+            CHECK(editor.getWordCount() == recount());
+            editor.toTitleCase(2);
+            editor.filterLines("o");
+            CHECK(editor.getWordCount() == recount());
+            editor.changeAllLinesCase(1);
+            CHECK(editor.getWordCount() == recount());
+            while (editor.undo()) {
+                CHECK(editor.getWordCount() == recount());
+            }
+            CHECK(editor.getWordCount() == 0);
+            while (editor.redo()) {
+                CHECK(editor.getWordCount() == recount());
+            }
+            editor.clearText();
+            CHECK(editor.getWordCount() == 0);
+            CHECK(editor.getCharCount() == 0);
+        }
     }
 
     TEST_CASE("Encryption/Decryption") {
@@ -220,6 +403,11 @@ TEST_SUITE("TextEditor Tests") {
         editor.addLine("This is a secret message");
         editor.addLine("Another line to encrypt");
         const std::string password = "strongPassword123";
+        const std::string path = "test_encrypted.txt";
+        auto readRaw = [&] {
+            std::ifstream in(path, std::ios::binary);
+            return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        };
 
         SUBCASE("Encrypt with empty password") {
             CHECK_FALSE(editor.encryptFile(""));
@@ -227,26 +415,1616 @@ TEST_SUITE("TextEditor Tests") {
 
         SUBCASE("Successful encryption/decryption") {
             CHECK(editor.encryptFile(password));
-            auto encryptedLines = editor.getLines();
+            // The document itself stays plain text; only the saved file is encrypted
+            CHECK(editor.getLines()[0] == "This is a secret message");
+            CHECK(editor.saveToFile(path));
+            CHECK(readRaw().find("secret message") == std::string::npos);
 
-            // Encrypted lines shouldn't match original
-            CHECK(encryptedLines[0] != "This is a secret message");
+            TextEditor reader;
+            CHECK_FALSE(reader.loadFile(path));
+            CHECK(reader.getLineCount() == 0);
+            CHECK(reader.decryptFile(password));
+            CHECK(reader.getLines() == editor.getLines());
+            CHECK(reader.getWordCount() == editor.getWordCount());
+            CHECK_FALSE(reader.hasUnsavedChanges());
 
-            // Test decryption
-            CHECK(editor.decryptFile(password));
-            CHECK(editor.getLines()[0] == "This is a secret message");
+            // Saving a decrypted file encrypts it again
+            reader.addLine("Added after decryption");
+            CHECK(reader.saveToFile());
+            CHECK(readRaw().find("Added after") == std::string::npos);
         }
 
         SUBCASE("Decryption with wrong password") {
             editor.encryptFile(password);
             CHECK_FALSE(editor.decryptFile("wrongPassword"));
+
+            editor.saveToFile(path);
+            TextEditor reader;
+            reader.loadFile(path);
+            CHECK_FALSE(reader.decryptFile("wrongPassword"));
+            CHECK(reader.getLineCount() == 0);
+            CHECK(reader.decryptFile(password));
+            CHECK(reader.getLineCount() == 2);
         }
 
         SUBCASE("Password clearing") {
             editor.encryptFile(password);
             editor.clearPassword();
-            // Can't directly check if password was cleared, but shouldn't crash
+            // Without a password the file is saved as plain text
+            CHECK(editor.saveToFile(path));
+            CHECK(readRaw() == "This is a secret message\nAnother line to encrypt\n");
         }
+
+        SUBCASE("Decrypting turns encryption off") {
+            editor.encryptFile(password);
+            CHECK(editor.decryptFile(password));
+            CHECK(editor.saveToFile(path));
+            CHECK(readRaw() == "This is a secret message\nAnother line to encrypt\n");
+        }
+
+        SUBCASE("A failed encrypted load is forgotten after an edit") {
+            editor.encryptFile(password);
+            editor.saveToFile(path);
+            editor.clearPassword();
+
+            TextEditor reader;
+            reader.addLine("Unsaved work");
+            CHECK_FALSE(reader.loadFile(path));
+            CHECK(reader.hasPendingEncryptedFile());
+            reader.addLine("More unsaved work");
+            CHECK_FALSE(reader.hasPendingEncryptedFile());
+            // decrypt now means "stop encrypting" and must not replace the edited document
+            CHECK_FALSE(reader.decryptFile(password));
+            CHECK(reader.getLines() == std::vector<std::string>{"Unsaved work", "More unsaved work"});
+
+            CHECK_FALSE(reader.loadFile(path));
+            CHECK_FALSE(reader.loadFile("missing_file.txt"));
+            CHECK_FALSE(reader.hasPendingEncryptedFile());
+        }
+
+        SUBCASE("Plain text is not decrypted") {
+            CHECK_FALSE(editor.decryptFile(password));
+            CHECK(editor.getLine(1) == "This is a secret message");
+        }
+
+        SUBCASE("Large documents use the thread pool") {
+            editor.setThreadCount(4);
+            for (int i = 0; i < 20000; ++i) {
+                editor.addLine("Line " + std::to_string(i) + " of a document spanning several chunks");
+            }
+            editor.encryptFile(password);
+            CHECK(editor.saveToFile(path));
+
+            TextEditor reader;
+            reader.setThreadCount(4);
+            reader.loadFile(path);
+            CHECK(reader.decryptFile(password));
+            CHECK(reader.getLines() == editor.getLines());
+        }
+
+        SUBCASE("Line breaks and non-ASCII text survive a round trip") {
+            editor.replaceLine(2, "Строка не из ASCII\r");
+            editor.addLine("");
+            editor.encryptFile(password);
+            editor.saveToFile(path);
+
+            TextEditor reader;
+            reader.loadFile(path);
+            CHECK(reader.decryptFile(password));
+            CHECK(reader.getLines() == std::vector<std::string>{"This is a secret message",
+                                                                "Строка не из ASCII", ""});
+        }
+
+        std::filesystem::remove(path);
     }
-}
 
+    TEST_CASE("Stream cipher") {
+        auto hex = [](const uint8_t* data, size_t size) {
+            static const char digits[] = "0123456789abcdef";
+            std::string result;
+            for (size_t i = 0; i < size; ++i) {
+                result += digits[data[i] >> 4];
+                result += digits[data[i] & 0xf];
+            }
+            return result;
+        };
+
+        SUBCASE("SHA-256 and HMAC vectors") {
+            auto empty = Sha256::hash("", 0);
+            CHECK(hex(empty.data(), empty.size()) ==
+                  "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+            Sha256 sha;
+            sha.update("a", 1);
+            sha.update("bc", 2);
+            auto abc = sha.finish();
+            CHECK(hex(abc.data(), abc.size()) ==
+                  "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+
+            HmacSha256 mac("Jefe", 4);
+            mac.update("what do ya want for nothing?", 28);
+            auto tag = mac.finish();
+            CHECK(hex(tag.data(), tag.size()) ==
+                  "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+        }
+
+        SUBCASE("PBKDF2 vectors") {
+            const uint8_t salt[] = {'s', 'a', 'l', 't'};
+            uint8_t key[32];
+            pbkdf2HmacSha256("password", salt, sizeof(salt), 1, key, sizeof(key));
+            CHECK(hex(key, sizeof(key)) == "120fb6cffcf8b32c43e7225256c4f837a86548c92ccc35480805987cb70be17b");
+            pbkdf2HmacSha256("password", salt, sizeof(salt), 4096, key, sizeof(key));
+            CHECK(hex(key, sizeof(key)) == "c5e478d59288c841aa530db6845c4c8d962893a001ce4e11a4963873aa98134a");
+
+            uint8_t longKey[64];
+            pbkdf2HmacSha256("passwd", salt, sizeof(salt), 1, longKey, sizeof(longKey));
+            CHECK(hex(longKey, sizeof(longKey)) ==
+                  "55ac046e56e3089fec1691c22544b605f94185216dde0465e68b9d57c20dacbc"
+                  "49ca9cccf179b645991664b39d77ef317c71b845b1e30bd509112041d3a19783");
+        }
+
+        uint8_t key[ChaCha20::kKeySize];
+        for (size_t i = 0; i < sizeof(key); ++i) key[i] = static_cast<uint8_t>(i);
+
+        SUBCASE("RFC 8439 block") {
+            const uint8_t nonce[] = {0, 0, 0, 9, 0, 0, 0, 0x4a, 0, 0, 0, 0};
+            ChaCha20 cipher(key, nonce, 1);
+            uint8_t block[ChaCha20::kBlockSize] = {};
+            cipher.apply(block, sizeof(block));
+            CHECK(hex(block, sizeof(block)) ==
+                  "10f1e7e4d13b5915500fdd1fa32071c4c7d1f4c733c068030422aa9ac3d46c4e"
+                  "d2826446079faa0914c2d705d98b02a2b5129cd1de164eb9cbd083e8a2503c4e");
+        }
+
+        SUBCASE("RFC 8439 encryption") {
+            const uint8_t nonce[] = {0, 0, 0, 0, 0, 0, 0, 0x4a, 0, 0, 0, 0};
+            std::string text = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip "
+                               "for the future, sunscreen would be it.";
+            ChaCha20 cipher(key, nonce, 1);
+            cipher.apply(&text[0], text.size());
+            CHECK(hex(reinterpret_cast<const uint8_t*>(text.data()), text.size()) ==
+                  "6e2e359a2568f98041ba0728dd0d6981e97e7aec1d4360c20a27afccfd9fae0b"
+                  "f91b65c5524733ab8f593dabcd62b3571639d624e65152ab8f530c359f0861d8"
+                  "07ca0dbf500d6a6156a38e088a22b65e52bc514d16ccf806818ce91ab7793736"
+                  "5af90bbf74a35be6b40b8eedf2785e42874d");
+        }
+
+        SUBCASE("RFC 8439 Poly1305 and AEAD") {
+            const uint8_t macKey[] = {0x85, 0xd6, 0xbe, 0x78, 0x57, 0x55, 0x6d, 0x33, 0x7f, 0x44, 0x52,
+                                      0xfe, 0x42, 0xd5, 0x06, 0xa8, 0x01, 0x03, 0x80, 0x8a, 0xfb, 0x0d,
+                                      0xb2, 0xfd, 0x4a, 0xbf, 0xf6, 0xaf, 0x41, 0x49, 0xf5, 0x1b};
+            Poly1305 mac(macKey);
+            mac.update("Cryptographic Forum", 19);
+            mac.update(" Research Group", 15);
+            auto tag = mac.finish();
+            CHECK(hex(tag.data(), tag.size()) == "a8061dc1305136c6c22b8baf0c0127a9");
+
+            uint8_t aeadKey[32];
+            for (size_t i = 0; i < sizeof(aeadKey); ++i) aeadKey[i] = static_cast<uint8_t>(0x80 + i);
+            const uint8_t nonce[] = {7, 0, 0, 0, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47};
+            const uint8_t aad[] = {0x50, 0x51, 0x52, 0x53, 0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7};
+            const std::string plain = "Ladies and Gentlemen of the class of '99: If I could offer you only one "
+                                      "tip for the future, sunscreen would be it.";
+            std::string text = plain;
+            auto sealed = sealChaCha20Poly1305(aeadKey, nonce, aad, sizeof(aad), &text[0], text.size());
+            CHECK(hex(sealed.data(), sealed.size()) == "1ae10b594f09e26a7e902ecbd0600691");
+            CHECK(hex(reinterpret_cast<const uint8_t*>(text.data()), 4) == "d31a8d34");
+
+            std::string forged = text;
+            forged[10] ^= 1;
+            CHECK_FALSE(openChaCha20Poly1305(aeadKey, nonce, aad, sizeof(aad), &forged[0], forged.size(),
+                                             sealed.data()));
+            CHECK(openChaCha20Poly1305(aeadKey, nonce, aad, sizeof(aad), &text[0], text.size(), sealed.data()));
+            CHECK(text == plain);
+        }
+
+        SUBCASE("Seeking matches a single pass") {
+            const uint8_t nonce[ChaCha20::kNonceSize] = {};
+            std::string whole(5000, 'x');
+            for (size_t i = 0; i < whole.size(); ++i) whole[i] = static_cast<char>(i * 7);
+            std::string pieces = whole;
+            const std::string original = whole;
+
+            ChaCha20 single(key, nonce);
+            single.apply(&whole[0], whole.size());
+            CHECK(single.tell() == whole.size());
+
+            // Pieces of odd sizes, applied out of order
+            ChaCha20 seeking(key, nonce);
+            const size_t cuts[] = {0, 1, 63, 64, 65, 511, 512, 1000, 4097, 5000};
+            for (size_t i = std::size(cuts) - 1; i > 0; --i) {
+                seeking.seek(cuts[i - 1]);
+                seeking.apply(&pieces[cuts[i - 1]], cuts[i] - cuts[i - 1]);
+            }
+            CHECK(pieces == whole);
+
+            ChaCha20 decrypt(key, nonce);
+            decrypt.apply(&pieces[0], pieces.size());
+            CHECK(pieces == original);
+        }
+    }
+
+    TEST_CASE("Encrypted file") {
+        const std::string path = "test_encrypted.bin";
+        const size_t chunk = EncryptedFileWriter::kChunkSize;
+        auto writeFile = [&](const std::string& text) {
+            EncryptedFileWriter writer;
+            REQUIRE(writer.open(path, "secret", 1000));
+            // Uneven pieces cross chunk boundaries
+            for (size_t offset = 0; offset < text.size(); offset += 1000) {
+                writer.write(std::string_view(text).substr(offset, 1000));
+            }
+            REQUIRE(writer.close());
+        };
+        auto readAll = [&](const EncryptedFileReader& reader) {
+            std::string text(static_cast<size_t>(reader.size()), '\0');
+            bool ok = reader.read(0, &text[0], text.size());
+            return ok ? text : std::string("<failed>");
+        };
+
+        SUBCASE("Round trip at chunk boundaries") {
+            for (size_t size : {size_t(0), size_t(1), chunk, chunk + 1, 3 * chunk + 17}) {
+                std::string text(size, ' ');
+                for (size_t i = 0; i < size; ++i) text[i] = static_cast<char>('a' + i % 23);
+                writeFile(text);
+
+                EncryptedFileReader reader;
+                REQUIRE(reader.open(path, "secret") == EncryptedFileStatus::Ok);
+                CHECK(reader.size() == size);
+                CHECK(reader.chunkCount() == std::max<size_t>(1, (size + chunk - 1) / chunk));
+                CHECK(readAll(reader) == text);
+            }
+        }
+
+        std::string text(2 * chunk + 500, ' ');
+        for (size_t i = 0; i < text.size(); ++i) text[i] = static_cast<char>('A' + i % 26);
+        writeFile(text);
+
+        SUBCASE("Random access decrypts only the touched chunks") {
+            EncryptedFileReader reader;
+            REQUIRE(reader.open(path, "secret") == EncryptedFileStatus::Ok);
+            std::string piece(100, '\0');
+            CHECK(reader.read(chunk - 50, &piece[0], piece.size()));
+            CHECK(piece == text.substr(chunk - 50, 100));
+            CHECK_FALSE(reader.read(text.size() - 10, &piece[0], piece.size()));
+        }
+
+        SUBCASE("Wrong password and foreign files are rejected") {
+            EncryptedFileReader reader;
+            CHECK(reader.open(path, "Secret") == EncryptedFileStatus::WrongPassword);
+            std::ofstream("test_plain.txt") << "just text\n";
+            CHECK(reader.open("test_plain.txt", "secret") == EncryptedFileStatus::NotEncrypted);
+            CHECK(reader.open("missing_file.bin", "secret") == EncryptedFileStatus::Unreadable);
+            std::filesystem::remove("test_plain.txt");
+        }
+
+        auto corrupt = [&](const std::function<void(std::string&)>& change) {
+            std::string bytes;
+            {
+                std::ifstream in(path, std::ios::binary);
+                bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            }
+            change(bytes);
+            std::ofstream(path, std::ios::binary | std::ios::trunc) << bytes;
+        };
+
+        SUBCASE("Tampered chunk fails authentication") {
+            corrupt([&](std::string& bytes) { bytes[bytes.size() - chunk] ^= 1; });
+            EncryptedFileReader reader;
+            REQUIRE(reader.open(path, "secret") == EncryptedFileStatus::Ok);
+            std::vector<char> out(chunk);
+            CHECK(reader.readChunk(0, out.data()));
+            CHECK_FALSE(reader.readChunk(1, out.data()));
+        }
+
+        SUBCASE("Chunks are sealed and opened in parallel") {
+            ThreadPool pool(4);
+            std::string big(20 * chunk + 123, ' ');
+            for (size_t i = 0; i < big.size(); ++i) big[i] = static_cast<char>('a' + i % 19);
+            {
+                EncryptedFileWriter writer(&pool);
+                REQUIRE(writer.open(path, "secret", 1000));
+                for (size_t offset = 0; offset < big.size(); offset += 100000) {
+                    writer.write(std::string_view(big).substr(offset, 100000));
+                }
+                REQUIRE(writer.close());
+            }
+
+            EncryptedFileReader reader;
+            REQUIRE(reader.open(path, "secret") == EncryptedFileStatus::Ok);
+            CHECK(reader.chunkCount() == 21);
+            std::string out(big.size(), '\0');
+            CHECK(reader.readAll(&out[0], &pool));
+            CHECK(out == big);
+            CHECK(readAll(reader) == big);
+
+            corrupt([&](std::string& bytes) { bytes[bytes.size() / 2] ^= 1; });
+            REQUIRE(reader.open(path, "secret") == EncryptedFileStatus::Ok);
+            CHECK_FALSE(reader.readAll(&out[0], &pool));
+        }
+
+        SUBCASE("Header limits are checked before deriving the key") {
+            EncryptedFileWriter writer;
+            CHECK_FALSE(writer.open(path + ".big", "secret", kMaxKdfIterations + 1));
+            std::filesystem::remove(path + ".big");
+
+            // A huge iteration count would take hours of PBKDF2; it is refused at once
+            corrupt([&](std::string& bytes) { bytes.replace(12, 4, "\xff\xff\xff\xff"); });
+            EncryptedFileReader reader;
+            CHECK(reader.open(path, "secret") == EncryptedFileStatus::Corrupted);
+            corrupt([&](std::string& bytes) {
+                bytes.replace(12, 4, std::string("\xe8\x03\0\0", 4));
+                bytes[16] ^= 1;
+            });
+            CHECK(reader.open(path, "secret") == EncryptedFileStatus::Corrupted);
+            corrupt([&](std::string& bytes) { bytes[16] ^= 1; });
+            CHECK(reader.open(path, "secret") == EncryptedFileStatus::Ok);
+        }
+
+        SUBCASE("Dropping the last chunk is detected") {
+            corrupt([&](std::string& bytes) { bytes.resize(bytes.size() - (500 + 28)); });
+            EncryptedFileReader reader;
+            REQUIRE(reader.open(path, "secret") == EncryptedFileStatus::Ok);
+            CHECK(reader.chunkCount() == 2);
+            std::vector<char> out(chunk);
+            CHECK_FALSE(reader.readChunk(1, out.data()));
+        }
+
+        std::filesystem::remove(path);
+    }
+
+    TEST_CASE("Piece Table") {
+        PieceTable table;
+        table.assignLines({"one", "two", "three"});
+
+        SUBCASE("Initial content") {
+            CHECK(table.lineCount() == 3);
+            CHECK(table.byteCount() == 11);
+            CHECK(table.line(1) == "two");
+            CHECK(table.pieceCount() == 1);
+        }
+
+        SUBCASE("Insert in the middle") {
+            table.insertLines(1, {"a", "b"});
+            CHECK(table.lineCount() == 5);
+            CHECK(table.line(0) == "one");
+            CHECK(table.line(1) == "a");
+            CHECK(table.line(2) == "b");
+            CHECK(table.line(3) == "two");
+            CHECK(table.byteCount() == 13);
+        }
+
+        SUBCASE("Erase and replace") {
+            table.eraseLines(0, 2);
+            CHECK(table.lineCount() == 1);
+            CHECK(table.line(0) == "three");
+            table.replaceLines(0, 1, {"3"});
+            CHECK(table.line(0) == "3");
+            CHECK(table.byteCount() == 1);
+        }
+
+        SUBCASE("Appends extend one piece") {
+            for (int i = 0; i < 100; ++i) {
+                table.insertLines(table.lineCount(), {std::to_string(i)});
+            }
+            CHECK(table.lineCount() == 103);
+            CHECK(table.pieceCount() == 2);
+            CHECK(table.line(102) == "99");
+        }
+
+        SUBCASE("Copies are independent") {
+            PieceTable copy = table;
+            table.replaceLines(0, 1, {"changed"});
+            CHECK(copy.line(0) == "one");
+            CHECK(table.line(0) == "changed");
+        }
+
+        SUBCASE("Ranged iteration") {
+            std::vector<std::string> seen;
+            table.insertLines(2, {"x"});
+            table.forEachLine(1, 3, [&](size_t, std::string_view line) {
+                seen.emplace_back(line);
+            });
+            REQUIRE(seen.size() == 2);
+            CHECK(seen[0] == "two");
+            CHECK(seen[1] == "x");
+        }
+    }
+
+    TEST_CASE("Rope") {
+        Rope rope;
+
+        SUBCASE("Matches vector model under random edits") {
+            std::vector<std::string> model;
+            std::mt19937 rng(42);
+            for (int step = 0; step < 3000; ++step) {
+                size_t at = model.empty() ? 0 : rng() % (model.size() + 1);
+                int op = static_cast<int>(rng() % 4);
+                if (op < 2 || model.empty()) {
+                    std::vector<std::string> batch;
+                    size_t n = 1 + rng() % 40;
+                    for (size_t i = 0; i < n; ++i) {
+                        batch.push_back(std::string(rng() % 200, static_cast<char>('a' + step % 26)));
+                    }
+                    rope.insertLines(at, batch);
+                    model.insert(model.begin() + at, batch.begin(), batch.end());
+                } else if (op == 2) {
+                    at = std::min(at, model.size() - 1);
+                    size_t n = std::min<size_t>(1 + rng() % 60, model.size() - at);
+                    rope.eraseLines(at, n);
+                    model.erase(model.begin() + at, model.begin() + at + n);
+                } else {
+                    at = std::min(at, model.size() - 1);
+                    rope.replaceLines(at, 1, {"replaced " + std::to_string(step)});
+                    model[at] = "replaced " + std::to_string(step);
+                }
+            }
+            REQUIRE(rope.lineCount() == model.size());
+            size_t bytes = 0;
+            for (size_t i = 0; i < model.size(); ++i) {
+                CHECK(rope.line(i) == model[i]);
+                bytes += model[i].size();
+            }
+            CHECK(rope.byteCount() == bytes);
+        }
+
+        SUBCASE("Stays shallow for many lines") {
+            std::vector<std::string> lines(200000, "short line");
+            rope.assignLines(lines);
+            CHECK(rope.lineCount() == 200000);
+            CHECK(rope.height() <= 4);
+            rope.insertLines(100000, {"middle"});
+            CHECK(rope.line(100000) == "middle");
+            CHECK(rope.line(100001) == "short line");
+        }
+
+        SUBCASE("Erase everything") {
+            rope.assignLines(std::vector<std::string>(5000, "x"));
+            rope.eraseLines(0, 5000);
+            CHECK(rope.lineCount() == 0);
+            CHECK(rope.height() == 1);
+            rope.insertLines(0, {"again"});
+            CHECK(rope.line(0) == "again");
+        }
+    }
+
+    TEST_CASE("Storage engines in editor") {
+        TextEditor editor;
+        editor.addLine("one");
+        editor.addLine("three");
+
+        SUBCASE("Insert line in the middle") {
+            CHECK(editor.insertLine(2, "two"));
+            CHECK(editor.getLine(2) == "two");
+            CHECK(editor.getLine(3) == "three");
+            CHECK_FALSE(editor.insertLine(0, "bad"));
+            CHECK_FALSE(editor.insertLine(5, "bad"));
+        }
+
+        SUBCASE("Switching engines keeps content") {
+            editor.setStorageEngine(StorageEngine::Rope);
+            CHECK(editor.getStorageEngine() == StorageEngine::Rope);
+            CHECK(editor.insertLine(2, "two"));
+            CHECK(editor.getLines() == std::vector<std::string>{"one", "two", "three"});
+            CHECK(editor.undo());
+            CHECK(editor.getLineCount() == 2);
+            editor.setStorageEngine(StorageEngine::PieceTable);
+            CHECK(editor.getLines() == std::vector<std::string>{"one", "three"});
+        }
+
+        SUBCASE("Whole-document undo after switching engines") {
+            editor.changeAllLinesCase(1);
+            editor.filterLines("ONE");
+            editor.setStorageEngine(StorageEngine::Rope);
+            CHECK(editor.undo());
+            CHECK(editor.undo());
+            CHECK(editor.getStorageEngine() == StorageEngine::Rope);
+            CHECK(editor.getLines() == std::vector<std::string>{"one", "three"});
+            editor.setStorageEngine(StorageEngine::PieceTable);
+            CHECK(editor.redo());
+            CHECK(editor.getLines() == std::vector<std::string>{"ONE", "THREE"});
+            CHECK(editor.redo());
+            CHECK(editor.getLines() == std::vector<std::string>{"ONE"});
+            CHECK(editor.insertLine(1, "zero"));
+            CHECK(editor.getLines() == std::vector<std::string>{"zero", "ONE"});
+        }
+    }
+
+    TEST_CASE("Newline scanner") {
+        SUBCASE("Matches naive split on random text") {
+            std::mt19937 rng(7);
+            const char alphabet[] = {'a', 'b', '\n', '\r', ' '};
+            std::string text;
+            for (int i = 0; i < 5000; ++i) {
+                text += alphabet[rng() % 5];
+            }
+
+            std::vector<LineSpan> expected;
+            size_t start = 0;
+            while (start < text.size()) {
+                size_t end = text.find('\n', start);
+                if (end == std::string::npos) end = text.size();
+                size_t length = end - start;
+                if (length > 0 && text[end - 1] == '\r') --length;
+                expected.push_back({start, length});
+                start = end + 1;
+            }
+
+            std::vector<LineSpan> spans;
+            scanLines(text.data(), text.size(), spans);
+            REQUIRE(spans.size() == expected.size());
+            for (size_t i = 0; i < spans.size(); ++i) {
+                CHECK(spans[i].offset == expected[i].offset);
+                CHECK(spans[i].length == expected[i].length);
+            }
+        }
+
+        SUBCASE("Edge cases") {
+            std::vector<LineSpan> spans;
+            scanLines("", 0, spans);
+            CHECK(spans.empty());
+            scanLines("\n\n", 2, spans);
+            CHECK(spans.size() == 2);
+            spans.clear();
+            scanLines("tail", 4, spans);
+            REQUIRE(spans.size() == 1);
+            CHECK(spans[0].length == 4);
+        }
+    }
+
+    TEST_CASE("Word counter") {
+        std::mt19937 rng(3);
+        const char alphabet[] = {' ', '\t', '\n', '\v', '\f', '\r', 'a', 'b', '\x08', '\x0e',
+                                 '\x85', '\xa0', '\xd0', '\xff', '!'};
+        for (int round = 0; round < 500; ++round) {
+            std::string text(rng() % 300, ' ');
+            for (auto& c : text) c = alphabet[rng() % sizeof(alphabet)];
+
+            std::istringstream iss(text);
+            std::string word;
+            size_t expected = 0;
+            while (iss >> word) expected++;
+            CHECK(countWords(text.data(), text.size()) == expected);
+
+            // Splitting the text anywhere must not change the total
+            size_t split = text.empty() ? 0 : rng() % text.size();
+            bool inWord = false;
+            size_t streamed = countWords(text.data(), split, inWord);
+            streamed += countWords(text.data() + split, text.size() - split, inWord);
+            CHECK(streamed == expected);
+        }
+    }
+
+    TEST_CASE("Substring search") {
+        SUBCASE("Matches std::string_view::find") {
+            std::mt19937 rng(7);
+            for (int round = 0; round < 3000; ++round) {
+                // Small alphabets produce many candidates and periodic patterns
+                char alphabet = static_cast<char>('a' + 1 + rng() % 3);
+                std::string text(rng() % 200, 'a');
+                for (auto& c : text) c = static_cast<char>('a' + rng() % (alphabet - 'a' + 1));
+                std::string needle(rng() % 12, 'a');
+                for (auto& c : needle) c = static_cast<char>('a' + rng() % (alphabet - 'a' + 1));
+                size_t from = text.empty() ? 0 : rng() % (text.size() + 1);
+
+                SubstringSearcher searcher(needle);
+                CHECK(searcher.find(text, from) == std::string_view(text).find(needle, from));
+            }
+        }
+
+        SUBCASE("Pathological pattern") {
+            std::string text(200000, 'a');
+            text += 'b';
+            std::string needle(64, 'a');
+            needle += 'b';
+            SubstringSearcher searcher(needle);
+            CHECK(searcher.find(text) == text.size() - needle.size());
+            CHECK_FALSE(SubstringSearcher("ab" + std::string(64, 'a')).containedIn(text));
+
+            // Dense candidates switch the search to Two-Way partway through the text
+            std::mt19937 rng(11);
+            for (int round = 0; round < 50; ++round) {
+                std::string sparse(20000, 'a');
+                for (auto& c : sparse) if (rng() % 50 == 0) c = 'b';
+                std::string pattern(20 + rng() % 40, 'a');
+                for (auto& c : pattern) if (rng() % 30 == 0) c = 'b';
+                CHECK(SubstringSearcher(pattern).find(sparse) == sparse.find(pattern));
+            }
+        }
+
+        SUBCASE("Filter uses the same search") {
+            TextEditor editor;
+            editor.addLine("the quick brown fox");
+            editor.addLine("jumps over");
+            editor.addLine("the lazy dog");
+            editor.filterLines("the ");
+            CHECK(editor.getLineCount() == 2);
+            CHECK(editor.getLine(2) == "the lazy dog");
+        }
+    }
+
+    TEST_CASE("Parallel case conversion") {
+        const std::string testFile = "test_case.txt";
+        const size_t lineCount = 60000;
+        {
+            std::ofstream out(testFile);
+            for (size_t i = 0; i < lineCount; ++i) {
+                out << "line " << i << (i % 2 ? " мягкие булки" : " quick Brown fox") << "\n";
+            }
+        }
+        TextEditor serial;
+        TextEditor parallel;
+        REQUIRE(serial.loadFile(testFile));
+        REQUIRE(parallel.loadFile(testFile));
+        serial.setThreadCount(1);
+        parallel.setThreadCount(4);
+
+        for (int mode : {3, 1, 2}) {
+            serial.changeAllLinesCase(mode);
+            parallel.changeAllLinesCase(mode);
+            CHECK(parallel.getLineCount() == lineCount);
+            CHECK(parallel.getLines() == serial.getLines());
+        }
+        CHECK(parallel.getLine(2) == "line 1 мягкие булки");
+        CHECK(parallel.getWordCount() == serial.getWordCount());
+
+        parallel.undo();
+        parallel.undo();
+        parallel.undo();
+        CHECK(parallel.getLine(1) == "line 0 quick Brown fox");
+        std::filesystem::remove(testFile);
+    }
+
+    TEST_CASE("Per-operation thread counts") {
+        const std::string testFile = "test_operations.cpp";
+        const size_t lineCount = 60000;
+        {
+            std::ofstream out(testFile);
+            for (size_t i = 0; i < lineCount; ++i) {
+                // The block comment crosses the first shard boundary
+                out << (i == 4094 ? "/* " : "") << (i % 5 == 0 ? "for needle " : "haystack ")
+                    << i << " word" << (i == 4098 ? " */" : "") << "\n";
+            }
+        }
+        TextEditor serial;
+        TextEditor parallel;
+        serial.setThreadCount(1);
+        parallel.setThreadCount(1);
+        CHECK(parallel.getThreadCount(BulkOperation::Search) == 1);
+
+        parallel.setThreadCount(BulkOperation::Search, 3);
+        parallel.setThreadCount(BulkOperation::Filter, 4);
+        parallel.setThreadCount(BulkOperation::WordCount, 2);
+        parallel.setThreadCount(BulkOperation::Highlight, 4);
+        CHECK(parallel.getThreadCount(BulkOperation::Search) == 3);
+        CHECK(parallel.getThreadCount(BulkOperation::ChangeCase) == 1);
+        REQUIRE(serial.loadFile(testFile));
+        REQUIRE(parallel.loadFile(testFile));
+
+        CHECK(parallel.getWordCount() == serial.getWordCount());
+        CHECK(parallel.searchText("needle") == serial.searchText("needle"));
+        CHECK(parallel.searchText("needle").size() == lineCount / 5);
+
+        serial.highlightSyntax();
+        parallel.highlightSyntax();
+        bool sameTokens = true;
+        for (size_t line = 4090; line < 4110; ++line) {
+            sameTokens = sameTokens && parallel.getLineTokens(line) == serial.getLineTokens(line);
+        }
+        CHECK(sameTokens);
+        CHECK(parallel.getLineTokens(4097).size() == 1);
+
+        serial.filterLines("needle");
+        parallel.filterLines("needle");
+        CHECK(parallel.getLines() == serial.getLines());
+        CHECK(parallel.getLineCount() == lineCount / 5);
+
+        parallel.setThreadCount(BulkOperation::Search, 0);
+        CHECK(parallel.getThreadCount(BulkOperation::Search) == 1);
+        std::filesystem::remove(testFile);
+    }
+
+    TEST_CASE("Syntax highlighter") {
+        using Tokens = std::vector<TokenSpan>;
+        PieceTable text;
+        text.assignLines({"int x = 42; // answer", "/* open", "still comment", "close */ return x;",
+                          "auto s = \"for\";", "format(x);"});
+        SyntaxHighlighter highlighter;
+        highlighter.reset(text.lineCount());
+        CHECK(highlighter.refresh(text, text.lineCount()) == 6);
+
+        SUBCASE("Tokens") {
+            CHECK(highlighter.tokens(0) == Tokens{{0, 3, TokenKind::Keyword}, {8, 2, TokenKind::Number},
+                                                  {12, 9, TokenKind::Comment}});
+            CHECK(highlighter.endState(1) == LexState::BlockComment);
+            CHECK(highlighter.tokens(2) == Tokens{{0, 13, TokenKind::Comment}});
+            CHECK(highlighter.tokens(3) == Tokens{{0, 8, TokenKind::Comment}, {9, 6, TokenKind::Keyword}});
+            CHECK(highlighter.tokens(4) == Tokens{{0, 4, TokenKind::Keyword}, {9, 5, TokenKind::String}});
+            CHECK(highlighter.tokens(5).empty());
+
+            std::string out;
+            SyntaxHighlighter::render(text.line(0), highlighter.tokens(0), out);
+            CHECK(out == "\033[1;32mint\033[0m x = \033[36m42\033[0m; \033[90m// answer\033[0m");
+        }
+
+        SUBCASE("Only edited lines are lexed again") {
+            text.replaceLines(5, 1, {"while (x) {}"});
+            highlighter.update(5, 1, 1);
+            CHECK(highlighter.refresh(text, text.lineCount()) == 1);
+            CHECK(highlighter.tokens(5) == Tokens{{0, 5, TokenKind::Keyword}});
+            CHECK(highlighter.refresh(text, text.lineCount()) == 0);
+        }
+
+        SUBCASE("Changed end state propagates downstream") {
+            text.replaceLines(1, 1, {"// no longer open"});
+            highlighter.update(1, 1, 1);
+            // Lines 2 and 3 start in a new state; line 4 starts as before
+            CHECK(highlighter.refresh(text, text.lineCount()) == 3);
+            CHECK(highlighter.tokens(2).empty());
+            CHECK(highlighter.tokens(3) == Tokens{{9, 6, TokenKind::Keyword}});
+        }
+
+        SUBCASE("Refresh stops at the requested line") {
+            text.insertLines(0, {"/*"});
+            highlighter.update(0, 0, 1);
+            CHECK(highlighter.refresh(text, 2) == 2);
+            // "/* open" now starts inside the comment but still ends inside it
+            CHECK(highlighter.refresh(text, text.lineCount()) == 1);
+            CHECK(highlighter.tokens(1) == Tokens{{0, 21, TokenKind::Comment}});
+            CHECK(highlighter.tokens(4) == Tokens{{0, 8, TokenKind::Comment}, {9, 6, TokenKind::Keyword}});
+        }
+
+        SUBCASE("Editor keeps the text unchanged") {
+            TextEditor editor;
+            editor.addLine("for (int i = 0; i < n; ++i) {}");
+            editor.addLine("/* comment");
+            editor.addLine("for */ x");
+            editor.highlightSyntax();
+            CHECK(editor.getLine(1) == "for (int i = 0; i < n; ++i) {}");
+            CHECK(editor.getLineTokens(1).size() == 3);
+            CHECK(editor.getLineTokens(3).front().kind == TokenKind::Comment);
+
+            editor.replaceLine(2, "// comment");
+            CHECK(editor.getLineTokens(3).front() == TokenSpan{0, 3, TokenKind::Keyword});
+            editor.undo();
+            CHECK(editor.getLineTokens(3).front().kind == TokenKind::Comment);
+
+            std::ostringstream captured;
+            std::streambuf* previous = std::cout.rdbuf(captured.rdbuf());
+            editor.displayText();
+            std::cout.rdbuf(previous);
+            CHECK(captured.str().find("1: \033[1;32mfor\033[0m (") == 0);
+            CHECK(editor.getLines()[0] == "for (int i = 0; i < n; ++i) {}");
+        }
+    }
+
+    TEST_CASE("Viewport highlighting") {
+        using Tokens = std::vector<TokenSpan>;
+        const size_t lineCount = 200000;
+        std::vector<std::string> source(lineCount, "int x = 1;");
+        PieceTable text;
+        text.assignLines(source);
+        SyntaxHighlighter highlighter;
+        const size_t window = 50;
+        const size_t top = 150000;
+
+        // Only the window and the lookback before it are lexed
+        CHECK(highlighter.prepare(text, top, top + window) == window + SyntaxHighlighter::kLookbackLines);
+        CHECK(highlighter.cachedLines() == window + SyntaxHighlighter::kLookbackLines);
+        CHECK_FALSE(highlighter.isValid());
+        CHECK(highlighter.tokens(top) == Tokens{{0, 3, TokenKind::Keyword}, {8, 1, TokenKind::Number}});
+        CHECK(highlighter.prepare(text, top, top + window) == 0);
+
+        SUBCASE("Scrolling lexes only the new lines") {
+            CHECK(highlighter.prepare(text, top + 10, top + window + 10) == 10);
+        }
+
+        SUBCASE("Edits invalidate only the edited lines") {
+            text.replaceLines(top + 5, 1, {"for (;;) {}"});
+            highlighter.update(top + 5, 1, 1);
+            CHECK(highlighter.prepare(text, top, top + window) == 1);
+            CHECK(highlighter.tokens(top + 5) == Tokens{{0, 3, TokenKind::Keyword}});
+
+            text.insertLines(top - 1, {"/*"});
+            highlighter.update(top - 1, 0, 1);
+            // The shifted window now starts inside the comment opened just above it
+            highlighter.prepare(text, top + 1, top + window + 1);
+            CHECK(highlighter.tokens(top + 1) == Tokens{{0, 10, TokenKind::Comment}});
+            CHECK(highlighter.tokens(top + 6) == Tokens{{0, 11, TokenKind::Comment}});
+        }
+
+        SUBCASE("Editor highlights the shown range") {
+            TextEditor editor;
+            for (size_t i = 0; i < 3; ++i) editor.addLine(i == 1 ? "return 0;" : "x");
+            editor.setSyntaxHighlightEnabled(true);
+            std::ostringstream captured;
+            std::streambuf* previous = std::cout.rdbuf(captured.rdbuf());
+            bool shown = editor.displayText(2, 3);
+            bool rejected = !editor.displayText(5, 6) && !editor.displayText(3, 2);
+            std::cout.rdbuf(previous);
+            CHECK(shown);
+            CHECK(rejected);
+            CHECK(captured.str() == "2: \033[1;32mreturn\033[0m \033[36m0\033[0m;\n3: x\n");
+            CHECK(editor.getLine(2) == "return 0;");
+        }
+    }
+
+    TEST_CASE("Ranged display") {
+        // Counts how many times the stream hands data to its buffer
+        struct CountingBuffer : std::stringbuf {
+            size_t writes = 0;
+            std::streamsize xsputn(const char* s, std::streamsize n) override {
+                ++writes;
+                return std::stringbuf::xsputn(s, n);
+            }
+        };
+
+        TextEditor editor;
+        for (size_t i = 1; i <= 120; ++i) editor.addLine("line " + std::to_string(i));
+        CountingBuffer counted;
+        std::streambuf* previous = std::cout.rdbuf(&counted);
+        bool shown = editor.displayText(8, 11);
+        std::cout.rdbuf(previous);
+        CHECK(shown);
+        CHECK(counted.writes == 1);
+        // Numbers are right-aligned to the widest number in the range
+        CHECK(counted.str() == " 8: line 8\n 9: line 9\n10: line 10\n11: line 11\n");
+        CHECK(editor.getLastRenderTime().count() > 0);
+
+        std::ostringstream captured;
+        previous = std::cout.rdbuf(captured.rdbuf());
+        editor.displayText(119, 500);
+        std::cout.rdbuf(previous);
+        CHECK(captured.str() == "119: line 119\n120: line 120\n");
+    }
+
+    TEST_CASE("Screen diff") {
+        ScreenBuffer previous(3, 10);
+        previous.write(0, 0, "hello", CellColor::Default);
+        ScreenBuffer next = previous;
+
+        SUBCASE("A resized screen is cleared and drawn whole") {
+            std::string out;
+            CHECK(diffScreens(ScreenBuffer(), previous, 0, 5, out) == 5);
+            CHECK(out.find("\033[2J") != std::string::npos);
+            CHECK(out.find("hello") != std::string::npos);
+        }
+
+        SUBCASE("Only changed cells are emitted") {
+            std::string out;
+            CHECK(diffScreens(previous, next, 0, 5, out) == 0);
+            CHECK(out == "\033[?25l\033[1;6H\033[?25h");
+
+            next.write(0, 1, "a", CellColor::Default);
+            next.write(2, 3, "xy", CellColor::Keyword);
+            out.clear();
+            CHECK(diffScreens(previous, next, 2, 5, out) == 3);
+            // Adjacent cells share one cursor move; the color is set once and reset
+            CHECK(out == "\033[?25l\033[1;2Ha\033[3;4H\033[0;1;32mxy\033[0m\033[3;6H\033[?25h");
+        }
+
+        SUBCASE("UTF-8 characters take one cell") {
+            CHECK(next.write(1, 0, "\xD0\xB4\xD0\xB0\tb", CellColor::Default) == 4);
+            CHECK(next.rowText(1) == "\xD0\xB4\xD0\xB0 b      ");
+            CHECK(next.write(1, 8, "abc", CellColor::Default) == 10);
+        }
+    }
+
+    TEST_CASE("Key decoding") {
+        KeyDecoder decoder;
+        Key key;
+        decoder.feed("a\xD0");
+        REQUIRE(decoder.next(key));
+        CHECK((key.type == KeyType::Char && key.text == "a"));
+        // Incomplete characters and sequences wait for the rest of their bytes
+        CHECK_FALSE(decoder.next(key));
+        decoder.feed("\xB4\033[A\033[5~\033OH\r\x7f\x11\033[");
+        REQUIRE(decoder.next(key));
+        CHECK((key.type == KeyType::Char && key.text == "\xD0\xB4"));
+        std::vector<KeyType> types;
+        while (decoder.next(key)) types.push_back(key.type);
+        CHECK(types == std::vector<KeyType>{KeyType::Up, KeyType::PageUp, KeyType::Home, KeyType::Enter,
+                                            KeyType::Backspace, KeyType::Quit});
+        decoder.feed("1;5C\033");
+        REQUIRE(decoder.next(key));
+        CHECK(key.type == KeyType::Right);
+        CHECK_FALSE(decoder.next(key));
+        REQUIRE(decoder.expire(key));
+        CHECK(key.type == KeyType::Escape);
+        CHECK_FALSE(decoder.expire(key));
+    }
+
+    TEST_CASE("Full-screen editing") {
+        auto press = [](FullScreenEditor& screen, KeyType type, const std::string& text = "") {
+            Key key;
+            key.type = type;
+            key.text = text;
+            return screen.handleKey(key);
+        };
+
+        SUBCASE("Typing redraws only the changed cells") {
+            TextEditor editor;
+            editor.addLine("int x;");
+            editor.addLine("y");
+            FullScreenEditor screen(editor, 4, 20);
+            std::string out;
+            screen.render(out);
+            CHECK(screen.frame().rowText(0) == "1 int x;            ");
+            CHECK(screen.frame().rowText(2) == "                    ");
+
+            press(screen, KeyType::End);
+            press(screen, KeyType::Char, "z");
+            out.clear();
+            size_t drawn = screen.render(out);
+            CHECK(editor.getLine(1) == "int x;z");
+            CHECK(screen.frame().rowText(0) == "1 int x;z           ");
+            // The new character plus the changed part of the status line
+            CHECK(drawn < 40);
+            CHECK(screen.getCursorOffset() == 7);
+
+            press(screen, KeyType::Left);
+            press(screen, KeyType::Left);
+            press(screen, KeyType::Enter);
+            press(screen, KeyType::Backspace);
+            press(screen, KeyType::Enter);
+            CHECK(editor.getLines() == std::vector<std::string>{"int x", ";z", "y"});
+            CHECK(screen.getCursorLine() == 2);
+            press(screen, KeyType::Delete);
+            press(screen, KeyType::Up);
+            press(screen, KeyType::End);
+            press(screen, KeyType::Delete);
+            CHECK(editor.getLines() == std::vector<std::string>{"int xz", "y"});
+            CHECK(screen.getCursorOffset() == 5);
+        }
+
+        SUBCASE("Scrolling keeps the cursor visible") {
+            TextEditor editor;
+            for (size_t i = 1; i <= 100; ++i) editor.addLine(i == 60 ? "\tlong line" : "line " + std::to_string(i));
+            FullScreenEditor screen(editor, 5, 12);
+            std::string out;
+            screen.render(out);
+            press(screen, KeyType::PageDown);
+            press(screen, KeyType::PageDown);
+            screen.render(out);
+            CHECK(screen.getCursorLine() == 7);
+            CHECK(screen.frame().rowText(3) == "  7 line 7  ");
+
+            screen.goToLine(60);
+            press(screen, KeyType::End);
+            screen.render(out);
+            // Tabs expand to four columns and the text scrolls horizontally
+            CHECK(screen.frame().rowText(3) == " 60 ng line ");
+            CHECK(screen.frame().rowText(2) == " 59 9       ");
+            press(screen, KeyType::Home);
+            screen.render(out);
+            CHECK(screen.frame().rowText(3) == " 60     long");
+        }
+
+        SUBCASE("Quitting with unsaved changes needs confirmation") {
+            TextEditor editor;
+            FullScreenEditor screen(editor, 3, 80);
+            press(screen, KeyType::Char, "a");
+            CHECK(press(screen, KeyType::Quit));
+            CHECK_FALSE(press(screen, KeyType::Quit));
+            press(screen, KeyType::Undo);
+            CHECK(editor.getLineCount() == 0);
+            press(screen, KeyType::Undo);
+            std::string out;
+            screen.render(out);
+            CHECK(screen.frame().rowText(2).find("Nothing to undo") != std::string::npos);
+        }
+    }
+
+    TEST_CASE("Batch command scripts") {
+        TextEditor editor;
+        std::istringstream script(
+            "# build a small document\n"
+            "add\nfirst line\n"
+            "insert 1 zero\n"
+            "\n"
+            "edit 2\nFIRST\n"
+            "upper 1\n"
+            "show\n"
+            "tui\n"
+            "exit\n"
+            "add\nnever added\n");
+        CommandSession session{editor, script, false};
+        std::ostringstream captured;
+        std::streambuf* previous = std::cout.rdbuf(captured.rdbuf());
+        runCommands(session);
+        std::cout.rdbuf(previous);
+
+        // No prompts or banners: only the output of the commands themselves
+        CHECK(editor.getLines() == std::vector<std::string>{"ZERO", "FIRST"});
+        CHECK(captured.str() == "1: ZERO\n2: FIRST\nError: Full-screen mode is not available in batch mode.\n");
+        // exit ends the script even with unsaved changes; nothing after it is read
+        CHECK(session.pipeline == nullptr);
+        std::string rest;
+        CHECK((std::getline(script, rest) && rest == "add"));
+    }
+
+    TEST_CASE("Batch script on an input that stays open") {
+        // Like a pipe whose writer keeps it open: after the script, reads block until close()
+        class OpenPipe : public std::streambuf {
+        public:
+            explicit OpenPipe(std::string text) : text(std::move(text)) {}
+            void close() {
+                std::lock_guard<std::mutex> lock(mutex);
+                closed = true;
+                changed.notify_all();
+            }
+
+        protected:
+            int_type underflow() override {
+                if (!served) {
+                    served = true;
+                    setg(text.data(), text.data(), text.data() + text.size());
+                    return traits_type::to_int_type(text[0]);
+                }
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] { return closed; });
+                return traits_type::eof();
+            }
+
+        private:
+            std::string text;
+            bool served = false;
+            bool closed = false;
+            std::mutex mutex;
+            std::condition_variable changed;
+        };
+
+        // The second exit is a reply to add, so reading goes on past it
+        OpenPipe pipe("add\nexit\nshow\nexit\n");
+        std::istream input(&pipe);
+        TextEditor editor;
+        CommandSession session{editor, input, false};
+        std::ostringstream captured;
+        std::streambuf* previous = std::cout.rdbuf(captured.rdbuf());
+        auto done = std::async(std::launch::async, [&] { runCommands(session); });
+        const bool returned = done.wait_for(std::chrono::seconds(10)) == std::future_status::ready;
+        // A hung reader is released so that a failure does not hang the tests
+        pipe.close();
+        done.wait();
+        std::cout.rdbuf(previous);
+
+        CHECK(returned);
+        CHECK(editor.getLines() == std::vector<std::string>{"exit"});
+        CHECK(captured.str() == "1: exit\n");
+    }
+
+    TEST_CASE("Batch script opens an encrypted document") {
+        const std::string path = "test_batch_encrypted.txt";
+        {
+            TextEditor writer;
+            writer.addLine("secret line");
+            writer.encryptFile("pw");
+            REQUIRE(writer.saveToFile(path));
+        }
+
+        TextEditor editor;
+        std::ostringstream captured;
+        std::streambuf* previous = std::cout.rdbuf(captured.rdbuf());
+        std::streambuf* previousError = std::cerr.rdbuf(captured.rdbuf());
+        // As in main: the failed load leaves the file waiting for the script's decrypt
+        CHECK_FALSE(editor.loadFile(path));
+        CHECK(editor.hasPendingEncryptedFile());
+        captured.str("");
+        std::istringstream script("decrypt\npw\nshow\n");
+        CommandSession session{editor, script, false};
+        runCommands(session);
+        std::cerr.rdbuf(previousError);
+        std::cout.rdbuf(previous);
+
+        CHECK_FALSE(editor.hasPendingEncryptedFile());
+        CHECK(editor.getLines() == std::vector<std::string>{"secret line"});
+        CHECK(captured.str() == "File loaded: " + path + " (decrypted)\nFile decrypted.\n1: secret line\n");
+        std::filesystem::remove(path);
+    }
+
+    TEST_CASE("Pipelined command dispatch") {
+        SUBCASE("Queue hands values over in order between threads") {
+            SpscQueue<size_t, 8> queue;
+            const size_t count = 100000;
+            std::thread producer([&] {
+                for (size_t i = 0; i < count; ++i) {
+                    size_t value = i;
+                    while (!queue.tryPush(value)) std::this_thread::yield();
+                }
+            });
+            bool ordered = true;
+            for (size_t expected = 0; expected < count;) {
+                size_t value;
+                if (!queue.tryPop(value)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                ordered = ordered && value == expected;
+                ++expected;
+            }
+            producer.join();
+            size_t extra;
+            CHECK(ordered);
+            CHECK_FALSE(queue.tryPop(extra));
+        }
+
+        SUBCASE("Read-ahead keeps commands and replies in order") {
+            std::string text;
+            const size_t count = 5000;
+            for (size_t i = 0; i < count; ++i) {
+                text += i % 2 ? "add\nline " + std::to_string(i) + "\n" : "  insert 1  \tfirst " + std::to_string(i) + "\n";
+            }
+            text += "replace 2 second\nupper   2\nfrobnicate\ndelete\n";
+            std::istringstream script(text);
+            TextEditor editor;
+            CommandSession session{editor, script, false};
+            std::ostringstream captured;
+            std::streambuf* previous = std::cout.rdbuf(captured.rdbuf());
+            runCommands(session);
+            std::cout.rdbuf(previous);
+
+            REQUIRE(editor.getLineCount() == count);
+            CHECK(editor.getLine(1) == "first " + std::to_string(count - 2));
+            CHECK(editor.getLine(2) == "SECOND");
+            CHECK(editor.getLine(count / 2 + 1) == "line 1");
+            CHECK(editor.getLine(count) == "line " + std::to_string(count - 1));
+            CHECK(captured.str() == "Unknown command. Type 'help' for command list.\nError: Specify line number.\n");
+        }
+
+        SUBCASE("Command names are found by the perfect hash") {
+            static_assert(kCppKeywords.find("for") >= 0 && kCppKeywords.find("fork") < 0);
+            TextEditor editor;
+            std::istringstream input;
+            CommandSession session{editor, input, false};
+            std::ostringstream captured;
+            std::streambuf* previous = std::cout.rdbuf(captured.rdbuf());
+            bool kept = executeCommand(session, "# comment") && executeCommand(session, "   ") &&
+                        executeCommand(session, "saveas") && executeCommand(session, "shows");
+            bool exited = !executeCommand(session, "exit now");
+            std::cout.rdbuf(previous);
+            CHECK(kept);
+            CHECK(exited);
+            CHECK(captured.str() == "Error: Specify file path.\nUnknown command. Type 'help' for command list.\n");
+        }
+    }
+
+    TEST_CASE("Keyword tables and languages") {
+        using Tokens = std::vector<TokenSpan>;
+        static_assert(kCppKeywords.contains("for") && kCppKeywords.contains("reinterpret_cast"));
+        static_assert(!kCppKeywords.contains("fork") && !kCppKeywords.contains("For"));
+        static_assert(kPythonKeywords.contains("lambda") && !kPythonKeywords.contains("lambdas"));
+        static_assert(kShellKeywords.contains("esac") && !kShellKeywords.contains("int"));
+
+        SUBCASE("Every keyword is found") {
+            bool all = true;
+            for (std::string_view word : kCppKeywords.words) all = all && kCppKeywords.contains(word);
+            for (std::string_view word : kPythonKeywords.words) all = all && kPythonKeywords.contains(word);
+            for (std::string_view word : kShellKeywords.words) all = all && kShellKeywords.contains(word);
+            CHECK(all);
+            CHECK_FALSE(kCppKeywords.contains(""));
+            CHECK_FALSE(kCppKeywords.contains("char64_t"));
+        }
+
+        SUBCASE("Language from extension") {
+            CHECK(languageFromPath("") == Language::Cpp);
+            CHECK(languageFromPath("src/main.CPP") == Language::Cpp);
+            CHECK(languageFromPath("tool.py") == Language::Python);
+            CHECK(languageFromPath("dir.sh/build.bash") == Language::Shell);
+            CHECK(languageFromPath("dir.py/README") == Language::PlainText);
+            CHECK(languageFromPath("notes.txt") == Language::PlainText);
+        }
+
+        SUBCASE("Python and shell rules") {
+            LexState state = LexState::Normal;
+            Tokens tokens;
+            SyntaxHighlighter::lexLine("def f(): return \"\"\"doc", Language::Python, state, tokens);
+            CHECK(tokens == Tokens{{0, 3, TokenKind::Keyword}, {9, 6, TokenKind::Keyword},
+                                   {16, 6, TokenKind::String}});
+            CHECK(state == LexState::TripleDoubleString);
+            tokens.clear();
+            SyntaxHighlighter::lexLine("end\"\"\" if x # note", Language::Python, state, tokens);
+            CHECK(tokens == Tokens{{0, 6, TokenKind::String}, {7, 2, TokenKind::Keyword},
+                                   {12, 6, TokenKind::Comment}});
+            CHECK(state == LexState::Normal);
+
+            tokens.clear();
+            SyntaxHighlighter::lexLine("for f in $done; do echo 'a#b' # c", Language::Shell, state, tokens);
+            CHECK(tokens == Tokens{{0, 3, TokenKind::Keyword}, {6, 2, TokenKind::Keyword},
+                                   {16, 2, TokenKind::Keyword}, {19, 4, TokenKind::Keyword},
+                                   {24, 5, TokenKind::String}, {30, 3, TokenKind::Comment}});
+
+            tokens.clear();
+            SyntaxHighlighter::lexLine("for x", Language::PlainText, state, tokens);
+            CHECK(tokens.empty());
+        }
+
+        SUBCASE("Editor follows the file extension") {
+            const std::string script = "test_highlight.py";
+            TextEditor editor;
+            editor.addLine("import os  # int");
+            editor.highlightSyntax();
+            CHECK(editor.getSyntaxLanguage() == Language::Cpp);
+            CHECK(editor.getLineTokens(1) == Tokens{{0, 6, TokenKind::Keyword}, {13, 3, TokenKind::Keyword}});
+
+            REQUIRE(editor.saveToFile(script));
+            CHECK(editor.getSyntaxLanguage() == Language::Python);
+            CHECK(editor.getLineTokens(1) == Tokens{{0, 6, TokenKind::Keyword}, {11, 5, TokenKind::Comment}});
+            CHECK(editor.getLine(1) == "import os  # int");
+            std::filesystem::remove(script);
+        }
+    }
+
+    TEST_CASE("Word index") {
+        TextEditor indexed;
+        TextEditor plain;
+        auto both = [&](auto&& action) {
+            action(indexed);
+            action(plain);
+        };
+        auto same = [&](const std::string& word) {
+            return indexed.searchText(word) == plain.searchText(word);
+        };
+
+        both([](TextEditor& e) {
+            e.addLine("alpha beta");
+            e.addLine("gamma alpha");
+            e.addLine("beta-delta alpha2");
+        });
+        indexed.setWordIndexEnabled(true);
+        CHECK(indexed.searchText("alpha") == std::vector<size_t>{1, 2});
+        CHECK(same("beta"));
+        CHECK(same("delta"));
+        CHECK(same("alpha2"));
+
+        SUBCASE("Line edits") {
+            both([](TextEditor& e) {
+                e.insertLine(1, "delta first");
+                e.deleteLine(3);
+                e.replaceLine(2, "beta again");
+                e.toUpperCase(1);
+                e.addLine("alpha at the end");
+            });
+            for (auto word : {"alpha", "beta", "delta", "DELTA", "gamma", "first", "FIRST"}) {
+                CHECK(same(word));
+            }
+            both([](TextEditor& e) { e.undo(); e.undo(); e.undo(); });
+            for (auto word : {"alpha", "beta", "delta", "DELTA", "gamma", "first", "FIRST"}) {
+                CHECK(same(word));
+            }
+            both([](TextEditor& e) { e.redo(); });
+            CHECK(same("gamma"));
+            CHECK(same("again"));
+        }
+
+        SUBCASE("Whole document changes") {
+            both([](TextEditor& e) { e.filterLines("alpha"); });
+            CHECK(same("alpha"));
+            CHECK(same("beta"));
+            CHECK(indexed.searchText("gamma") == std::vector<size_t>{2});
+
+            both([](TextEditor& e) { e.changeAllLinesCase(1); });
+            CHECK(same("ALPHA"));
+            both([](TextEditor& e) { e.undo(); e.undo(); });
+            CHECK(same("gamma"));
+        }
+
+        SUBCASE("Phrases fall back to scanning") {
+            CHECK(same("beta-delta"));
+            CHECK(same("alpha beta"));
+        }
+
+        SUBCASE("Edits spread over a long document") {
+            both([](TextEditor& e) {
+                for (int i = 0; i < 5000; ++i) {
+                    e.addLine("line " + std::to_string(i % 97) + (i % 7 == 0 ? " seven" : ""));
+                }
+            });
+            std::mt19937 rng(11);
+            for (int step = 0; step < 400; ++step) {
+                const size_t at = 1 + rng() % indexed.getLineCount();
+                const std::string text = "edit " + std::to_string(step % 13) + " seven";
+                switch (rng() % 3) {
+                    case 0: both([&](TextEditor& e) { e.insertLine(at, text); }); break;
+                    case 1: both([&](TextEditor& e) { e.deleteLine(at); }); break;
+                    default: both([&](TextEditor& e) { e.replaceLine(at, text); }); break;
+                }
+            }
+            for (auto word : {"seven", "edit", "5", "96", "alpha"}) {
+                CHECK(same(word));
+            }
+            both([](TextEditor& e) { e.filterLines("seven"); });
+            CHECK(same("seven"));
+            CHECK(same("12"));
+        }
+    }
+
+    TEST_CASE("Stable line ids") {
+        LineIds ids;
+        std::vector<uint32_t> model(3000);
+        std::iota(model.begin(), model.end(), 0u);
+        ids.reset(model.size());
+        auto matches = [&] {
+            bool same = ids.size() == model.size();
+            for (size_t i = 0; same && i < model.size(); ++i) {
+                same = ids.idAt(i) == model[i] && ids.positionOf(model[i]) == i;
+            }
+            return same;
+        };
+
+        SUBCASE("Matches vector model under random edits") {
+            std::mt19937 rng(9);
+            for (int step = 0; step < 3000; ++step) {
+                const size_t first = rng() % (model.size() + 1);
+                // Occasional large ranges split and merge blocks
+                const size_t span = step % 50 == 0 ? 1500 : 4;
+                const size_t removed = std::min<size_t>(rng() % span, model.size() - first);
+                const size_t added = rng() % span;
+                const std::vector<uint32_t> range = ids.replace(first, removed, added);
+                REQUIRE(range.size() == added);
+                for (size_t i = 0; i < std::min(removed, added); ++i) {
+                    CHECK(range[i] == model[first + i]);
+                }
+                model.erase(model.begin() + first, model.begin() + first + removed);
+                model.insert(model.begin() + first, range.begin(), range.end());
+            }
+            CHECK(matches());
+            CHECK(std::set<uint32_t>(model.begin(), model.end()).size() == model.size());
+
+            ids.replace(0, model.size(), 0);
+            model.clear();
+            CHECK(matches());
+            model = ids.replace(0, 0, 3);
+            CHECK(matches());
+        }
+
+        SUBCASE("Positions are sorted") {
+            ids.replace(10, 0, 2);
+            model.insert(model.begin() + 10, {3000, 3001});
+            CHECK(ids.positions(Postings{5, 20, 3001}) == std::vector<size_t>{5, 11, 22});
+        }
+
+        SUBCASE("Retained ids stay in id order") {
+            ids.replace(100, 0, 1);
+            model.insert(model.begin() + 100, 3000);
+            std::vector<size_t> kept;
+            for (size_t i = 0; i < model.size(); i += 3) kept.push_back(i);
+            const std::vector<uint32_t> renumber = ids.retain(kept);
+            REQUIRE(ids.size() == kept.size());
+            uint32_t previous = 0;
+            bool ordered = true;
+            for (uint32_t id = 0; id < renumber.size(); ++id) {
+                if (renumber[id] == kDroppedLine) continue;
+                ordered = ordered && (id == 0 || renumber[id] >= previous);
+                previous = renumber[id];
+            }
+            CHECK(ordered);
+            for (size_t i = 0; i < kept.size(); ++i) {
+                CHECK(ids.idAt(i) == renumber[model[kept[i]]]);
+            }
+        }
+    }
+
+    TEST_CASE("Trigram index") {
+        TextEditor indexed;
+        TextEditor plain;
+        auto both = [&](auto&& action) {
+            action(indexed);
+            action(plain);
+        };
+        both([](TextEditor& e) {
+            for (int i = 0; i < 200; ++i) {
+                e.addLine("row " + std::to_string(i) + (i % 3 == 0 ? " fizz" : "") + (i % 5 == 0 ? " buzz" : ""));
+            }
+        });
+        indexed.setTrigramIndexEnabled(true);
+        REQUIRE(indexed.isTrigramIndexEnabled());
+
+        SUBCASE("Filter after edits") {
+            both([](TextEditor& e) {
+                e.insertLine(1, "fizzbuzz first");
+                e.deleteLine(10);
+                e.replaceLine(20, "no match here");
+                e.undo();
+                e.filterLines("fizz");
+            });
+            CHECK(indexed.getLines() == plain.getLines());
+            CHECK(indexed.searchText("buzz") == plain.searchText("buzz"));
+
+            both([](TextEditor& e) { e.filterLines("zz b"); });
+            CHECK(indexed.getLines() == plain.getLines());
+            CHECK(indexed.getLineCount() > 0);
+        }
+
+        SUBCASE("Edits spread over a long document") {
+            both([](TextEditor& e) {
+                for (int i = 0; i < 4000; ++i) e.addLine("bulk " + std::to_string(i % 89) + " fizz");
+            });
+            std::mt19937 rng(13);
+            for (int step = 0; step < 400; ++step) {
+                const size_t at = 1 + rng() % indexed.getLineCount();
+                const std::string text = "typed " + std::to_string(step % 17) + " buzz";
+                switch (rng() % 3) {
+                    case 0: both([&](TextEditor& e) { e.insertLine(at, text); }); break;
+                    case 1: both([&](TextEditor& e) { e.deleteLine(at); }); break;
+                    default: both([&](TextEditor& e) { e.replaceLine(at, text); }); break;
+                }
+            }
+            REQUIRE(indexed.isTrigramIndexEnabled());
+            for (auto pattern : {"buzz", "fizz", "ped 1", "bulk 8"}) {
+                CHECK(indexed.searchText(pattern) == plain.searchText(pattern));
+            }
+            both([](TextEditor& e) { e.filterLines("buzz"); });
+            CHECK(indexed.getLines() == plain.getLines());
+        }
+
+        SUBCASE("Short and missing patterns") {
+            both([](TextEditor& e) { e.filterLines("7"); });
+            CHECK(indexed.getLines() == plain.getLines());
+            both([](TextEditor& e) { e.filterLines("xyz"); });
+            CHECK(indexed.getLineCount() == 0);
+        }
+
+        SUBCASE("Memory limit falls back to scanning") {
+            TextEditor limited;
+            limited.addLine("some fizz text");
+            limited.addLine("other text");
+            limited.setTrigramIndexMemoryLimit(64);
+            limited.setTrigramIndexEnabled(true);
+            CHECK_FALSE(limited.isTrigramIndexEnabled());
+            limited.filterLines("fizz");
+            CHECK(limited.getLineCount() == 1);
+        }
+    }
+
+    TEST_CASE("Large file is memory mapped") {
+        const std::string testFile = "test_large.txt";
+        const size_t lineCount = 100000;
+        {
+            std::ofstream out(testFile);
+            for (size_t i = 0; i < lineCount; ++i) {
+                out << "line number " << i << "\n";
+            }
+        }
+        REQUIRE(std::filesystem::file_size(testFile) > (1u << 20));
+
+        TextEditor editor;
+        REQUIRE(editor.loadFile(testFile));
+        CHECK(editor.getLineCount() == lineCount);
+        CHECK(editor.getLine(1) == "line number 0");
+        CHECK(editor.getLine(lineCount) == "line number 99999");
+
+        // Saving over the mapped file must not disturb the open document
+        editor.replaceLine(1, "edited");
+        CHECK(editor.saveToFile());
+        CHECK(editor.getLine(2) == "line number 1");
+        CHECK(editor.undo());
+        CHECK(editor.getLine(1) == "line number 0");
+
+        TextEditor reloaded;
+        REQUIRE(reloaded.loadFile(testFile));
+        CHECK(reloaded.getLine(1) == "edited");
+        CHECK(reloaded.getLineCount() == lineCount);
+        std::filesystem::remove(testFile);
+    }
+
+    TEST_CASE("Buffered file writer") {
+        const std::string testFile = "test_writer.txt";
+        std::string expected;
+        {
+            FileWriter writer;
+            REQUIRE(writer.open(testFile));
+            // Small pieces cross the buffer boundary, large ones bypass the buffer
+            for (size_t i = 0; i < 3000; ++i) {
+                std::string piece(i % 97 == 0 ? 100000 : 700, static_cast<char>('a' + i % 26));
+                CHECK(writer.write(piece));
+                expected += piece;
+            }
+            CHECK(writer.close());
+        }
+
+        std::ifstream in(testFile, std::ios::binary);
+        std::string actual((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+        CHECK(actual.size() == expected.size());
+        CHECK(actual == expected);
+
+        // Reopening drops the first file's unwritten buffer; bytes are written untranslated
+        const std::string binary("\r\n\x1a\0\n", 5);
+        {
+            FileWriter writer;
+            REQUIRE(writer.open(testFile));
+            CHECK(writer.write("discarded"));
+            REQUIRE(writer.open(testFile));
+            CHECK(writer.write(binary));
+            CHECK(writer.close());
+        }
+        in.open(testFile, std::ios::binary);
+        actual.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        in.close();
+        CHECK(actual == binary);
+        std::filesystem::remove(testFile);
+    }
+
+    TEST_CASE("Load CRLF file") {
+        const std::string testFile = "test_crlf.txt";
+        {
+            std::ofstream out(testFile, std::ios::binary);
+            out << "first\r\nsecond\r\n";
+        }
+        TextEditor editor;
+        CHECK(editor.loadFile(testFile));
+        CHECK(editor.getLineCount() == 2);
+        CHECK(editor.getLine(1) == "first");
+        CHECK(editor.getLine(2) == "second");
+        std::filesystem::remove(testFile);
+    }
+
+    TEST_CASE("Thread pool") {
+        ThreadPool pool(4);
+        CHECK(pool.size() == 4);
+
+        SUBCASE("Every index is visited once") {
+            std::vector<std::atomic<int>> visits(10007);
+            pool.parallelFor(0, visits.size(), 100, [&](size_t from, size_t to) {
+                for (size_t i = from; i < to; ++i) visits[i]++;
+            });
+            bool allOnce = true;
+            for (auto& v : visits) allOnce = allOnce && v.load() == 1;
+            CHECK(allOnce);
+        }
+
+        SUBCASE("Chunks stay aligned to the grain") {
+            std::atomic<bool> aligned{true};
+            std::atomic<size_t> total{0};
+            pool.parallelFor(5, 1005, 64, [&](size_t from, size_t to) {
+                if ((from - 5) % 64 != 0 || (to != 1005 && to - from != 64)) aligned = false;
+                total += to - from;
+            });
+            CHECK(aligned);
+            CHECK(total == 1000);
+        }
+
+        SUBCASE("Participation can be limited") {
+            std::mutex mutex;
+            std::set<std::thread::id> threads;
+            pool.parallelFor(0, 1000, 1, [&](size_t, size_t) {
+                std::lock_guard<std::mutex> lock(mutex);
+                threads.insert(std::this_thread::get_id());
+            }, 2);
+            CHECK(threads.size() <= 2);
+        }
+
+        SUBCASE("Exceptions reach the caller") {
+            CHECK_THROWS_AS(pool.parallelFor(0, 100, 1, [](size_t from, size_t) {
+                if (from == 42) throw std::runtime_error("fail");
+            }), std::runtime_error);
+        }
+    }
+
+    TEST_CASE("Parallel search") {
+        const std::string testFile = "test_search.txt";
+        const size_t lineCount = 120000;
+        {
+            std::ofstream out(testFile);
+            for (size_t i = 0; i < lineCount; ++i) {
+                out << (i % 7 == 0 ? "needle in line " : "haystack line ") << i << "\n";
+            }
+        }
+        TextEditor editor;
+        REQUIRE(editor.loadFile(testFile));
+
+        editor.setThreadCount(1);
+        auto serial = editor.searchText("needle");
+        editor.setThreadCount(4);
+        auto parallel = editor.searchText("needle");
+
+        CHECK(serial.size() == (lineCount + 6) / 7);
+        CHECK(parallel == serial);
+        CHECK(editor.searchText("needles").empty());
+
+        TextEditor indexed;
+        indexed.setWordIndexEnabled(true);
+        REQUIRE(indexed.loadFile(testFile));
+        CHECK(indexed.searchText("needle") == serial);
+        std::filesystem::remove(testFile);
+    }
+}
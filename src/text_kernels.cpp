@@ -0,0 +1,894 @@
+#include "text_kernels.h"
+#include "cpu_features.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+/**
+ * @brief Возвращает номер младшего установленного бита
+ * @param mask Ненулевая маска
+ * @return Номер бита
+ */
+inline unsigned countTrailingZeros(uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+/**
+ * @brief Накопитель таблицы строк по найденным позициям '\n'
+ */
+class LineCollector {
+public:
+    LineCollector(const char* data, std::vector<LineSpan>& spans) : data(data), spans(spans), start(0) {}
+
+    /**
+     * @brief Закрывает строку, оканчивающуюся переводом строки в позиции pos
+     * @param pos Позиция символа '\n'
+     */
+    void newline(size_t pos) {
+        push(pos);
+        start = pos + 1;
+    }
+
+    /**
+     * @brief Добавляет последнюю строку, если текст не оканчивается '\n'
+     * @param size Размер текста
+     */
+    void finish(size_t size) {
+        if (start < size) push(size);
+    }
+
+private:
+    const char* data;             ///< Начало текста
+    std::vector<LineSpan>& spans; ///< Заполняемая таблица строк
+    size_t start;                 ///< Начало текущей строки
+
+    /**
+     * @brief Добавляет строку [start, end) без завершающего '\r'
+     * @param end Позиция конца строки
+     */
+    void push(size_t end) {
+        size_t length = end - start;
+        if (length > 0 && data[end - 1] == '\r') --length;
+        spans.push_back({start, length});
+    }
+};
+
+/**
+ * @brief Скалярный поиск переводов строк (memchr)
+ * @param data Начало текста
+ * @param size Размер текста
+ * @param from Позиция начала поиска
+ * @param lines Накопитель строк
+ */
+void scanLinesScalar(const char* data, size_t size, size_t from, LineCollector& lines) {
+    const char* p = data + from;
+    const char* end = data + size;
+    while (p < end) {
+        const void* hit = std::memchr(p, '\n', static_cast<size_t>(end - p));
+        if (!hit) break;
+        const char* nl = static_cast<const char*>(hit);
+        lines.newline(static_cast<size_t>(nl - data));
+        p = nl + 1;
+    }
+}
+
+#if defined(CPU_FEATURES_X86)
+/**
+ * @brief Поиск переводов строк блоками по 16 байт (SSE2)
+ * @param data Начало текста
+ * @param size Размер текста
+ * @param lines Накопитель строк
+ */
+void scanLinesSse2(const char* data, size_t size, LineCollector& lines) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+        while (mask) {
+            lines.newline(i + countTrailingZeros(mask));
+            mask &= mask - 1;
+        }
+    }
+    scanLinesScalar(data, size, i, lines);
+}
+
+/**
+ * @brief Поиск переводов строк блоками по 32 байта (AVX2)
+ * @param data Начало текста
+ * @param size Размер текста
+ * @param lines Накопитель строк
+ */
+CPU_TARGET_AVX2
+void scanLinesAvx2(const char* data, size_t size, LineCollector& lines) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline)));
+        while (mask) {
+            lines.newline(i + countTrailingZeros(mask));
+            mask &= mask - 1;
+        }
+    }
+    scanLinesScalar(data, size, i, lines);
+}
+#endif
+
+/**
+ * @brief Проверяет, является ли байт пробельным символом классической локали
+ * @param c Байт
+ * @return true для ' ', '\t', '\n', '\v', '\f' и '\r'
+ */
+inline bool isSpace(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+/**
+ * @brief Подсчитывает установленные биты (без инструкции popcnt)
+ * @param mask Маска
+ * @return Количество единичных битов
+ */
+inline unsigned popCount(uint64_t mask) {
+    mask = mask - ((mask >> 1) & 0x5555555555555555ull);
+    mask = (mask & 0x3333333333333333ull) + ((mask >> 2) & 0x3333333333333333ull);
+    mask = (mask + (mask >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    return static_cast<unsigned>((mask * 0x0101010101010101ull) >> 56);
+}
+
+/**
+ * @brief Скалярный подсчет слов с сохранением состояния
+ * @param data Начало текста
+ * @param size Размер текста
+ * @param inWord Находится ли позиция перед data внутри слова (обновляется)
+ * @return Количество начал слов
+ */
+size_t countWordsScalar(const char* data, size_t size, bool& inWord) {
+    size_t count = 0;
+    bool state = inWord;
+    for (size_t i = 0; i < size; ++i) {
+        bool word = !isSpace(data[i]);
+        count += word && !state;
+        state = word;
+    }
+    inWord = state;
+    return count;
+}
+
+#if defined(CPU_FEATURES_X86)
+/**
+ * @brief Маска непробельных байт блока из 16 байт (SSE2)
+ * @param p Начало блока
+ * @return 16-битная маска: бит установлен для байта, не являющегося пробельным
+ */
+inline uint32_t nonSpaceMask16(const char* p) {
+    const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    // '\t'..'\r' become 0..4 after subtracting 9; unsigned min detects the range
+    const __m128i shifted = _mm_sub_epi8(chunk, _mm_set1_epi8('\t'));
+    const __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(4)), shifted);
+    const __m128i space = _mm_or_si128(control, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')));
+    return static_cast<uint32_t>(~_mm_movemask_epi8(space)) & 0xFFFF;
+}
+
+/**
+ * @brief Подсчет слов блоками по 64 байта (SSE2)
+ * @param data Начало текста
+ * @param size Размер текста
+ * @param inWord Находится ли позиция перед data внутри слова (обновляется)
+ * @return Количество начал слов
+ */
+size_t countWordsSse2(const char* data, size_t size, bool& inWord) {
+    auto nonSpaceMask64 = [](const char* p) {
+        return uint64_t(nonSpaceMask16(p))
+             | uint64_t(nonSpaceMask16(p + 16)) << 16
+             | uint64_t(nonSpaceMask16(p + 32)) << 32
+             | uint64_t(nonSpaceMask16(p + 48)) << 48;
+    };
+
+    size_t count = 0;
+    uint64_t carry = inWord ? 1 : 0;
+    size_t i = 0;
+    for (; i + 64 <= size; i += 64) {
+        uint64_t word = nonSpaceMask64(data + i);
+        // A word starts where a non-space byte follows a space byte
+        count += popCount(word & ~((word << 1) | carry));
+        carry = word >> 63;
+    }
+
+    // The tail is padded with spaces to a whole block
+    if (size_t rest = size - i) {
+        char tail[64];
+        std::memset(tail, ' ', sizeof(tail));
+        std::memcpy(tail, data + i, rest);
+        uint64_t word = nonSpaceMask64(tail);
+        count += popCount(word & ~((word << 1) | carry));
+        carry = (word >> (rest - 1)) & 1;
+    }
+    inWord = carry != 0;
+    return count;
+}
+
+/**
+ * @brief Маска пробельных байт блока из 32 байт (AVX2)
+ * @param p Начало блока
+ * @return 32-битная маска: бит установлен для пробельного байта
+ */
+CPU_TARGET_AVX2
+inline uint32_t spaceMask32(const char* p) {
+    const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    const __m256i shifted = _mm256_sub_epi8(chunk, _mm256_set1_epi8('\t'));
+    const __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8(4)), shifted);
+    const __m256i space = _mm256_or_si256(control, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(space));
+}
+
+/**
+ * @brief Подсчет слов блоками по 64 байта (AVX2)
+ * @param data Начало текста
+ * @param size Размер текста
+ * @param inWord Находится ли позиция перед data внутри слова (обновляется)
+ * @return Количество начал слов
+ */
+CPU_TARGET_AVX2
+size_t countWordsAvx2(const char* data, size_t size, bool& inWord) {
+    size_t count = 0;
+    uint64_t carry = inWord ? 1 : 0;
+    size_t i = 0;
+    for (; i + 64 <= size; i += 64) {
+        uint64_t word = ~(uint64_t(spaceMask32(data + i)) | uint64_t(spaceMask32(data + i + 32)) << 32);
+        // A word starts where a non-space byte follows a space byte
+        count += static_cast<size_t>(_mm_popcnt_u64(word & ~((word << 1) | carry)));
+        carry = word >> 63;
+    }
+
+    // The tail is padded with spaces to a whole block
+    if (size_t rest = size - i) {
+        char tail[64];
+        std::memset(tail, ' ', sizeof(tail));
+        std::memcpy(tail, data + i, rest);
+        uint64_t word = ~(uint64_t(spaceMask32(tail)) | uint64_t(spaceMask32(tail + 32)) << 32);
+        count += static_cast<size_t>(_mm_popcnt_u64(word & ~((word << 1) | carry)));
+        carry = (word >> (rest - 1)) & 1;
+    }
+    inWord = carry != 0;
+    return count;
+}
+#endif
+
+/// Первый кодовый пункт таблиц регистра (ASCII обрабатывается отдельно)
+constexpr uint32_t kCaseTableBase = 0x80;
+
+/// Кодовый пункт за концом таблиц регистра (двухбайтовые символы до кириллицы включительно)
+constexpr uint32_t kCaseTableEnd = 0x500;
+
+/**
+ * @brief Диапазон заглавных букв со строчными парами, смещенными на delta
+ *
+ * Буквы first, first + stride, ... до last включительно; stride равен 2 для
+ * блоков, где заглавные и строчные чередуются.
+ */
+struct CaseRange {
+    uint16_t first;  ///< Первая заглавная буква
+    uint16_t last;   ///< Последняя заглавная буква
+    int16_t delta;   ///< Смещение строчной пары
+    uint16_t stride; ///< Шаг между заглавными буквами
+};
+
+/// Пары букв, у которых обе формы кодируются двумя байтами UTF-8
+constexpr CaseRange kCaseRanges[] = {
+    // Latin-1
+    {0x00C0, 0x00D6, 32, 1},
+    {0x00D8, 0x00DE, 32, 1},
+    // Latin Extended-A (U+0130 and U+0131 map to ASCII and are skipped)
+    {0x0100, 0x012E, 1, 2},
+    {0x0132, 0x0136, 1, 2},
+    {0x0139, 0x0147, 1, 2},
+    {0x014A, 0x0176, 1, 2},
+    {0x0178, 0x0178, -121, 1},
+    {0x0179, 0x017D, 1, 2},
+    // Greek
+    {0x0386, 0x0386, 38, 1},
+    {0x0388, 0x038A, 37, 1},
+    {0x038C, 0x038C, 64, 1},
+    {0x038E, 0x038F, 63, 1},
+    {0x0391, 0x03A1, 32, 1},
+    {0x03A3, 0x03AB, 32, 1},
+    {0x03D8, 0x03EE, 1, 2},
+    // Cyrillic
+    {0x0400, 0x040F, 80, 1},
+    {0x0410, 0x042F, 32, 1},
+    {0x0460, 0x0480, 1, 2},
+    {0x048A, 0x04BE, 1, 2},
+    {0x04C0, 0x04C0, 15, 1},
+    {0x04C1, 0x04CD, 1, 2},
+    {0x04D0, 0x04FE, 1, 2},
+};
+
+/**
+ * @brief Таблицы преобразования регистра для кодовых пунктов [kCaseTableBase, kCaseTableEnd)
+ *
+ * Ноль означает, что символ не меняется.
+ */
+struct CaseTables {
+    std::array<uint16_t, kCaseTableEnd - kCaseTableBase> upper{}; ///< Заглавная форма
+    std::array<uint16_t, kCaseTableEnd - kCaseTableBase> lower{}; ///< Строчная форма
+};
+
+/**
+ * @brief Строит таблицы регистра из диапазонов kCaseRanges при компиляции
+ * @return Таблицы регистра
+ */
+constexpr CaseTables makeCaseTables() {
+    CaseTables tables{};
+    for (const CaseRange& range : kCaseRanges) {
+        for (uint32_t upper = range.first; upper <= range.last; upper += range.stride) {
+            uint32_t lower = static_cast<uint32_t>(static_cast<int32_t>(upper) + range.delta);
+            tables.lower[upper - kCaseTableBase] = static_cast<uint16_t>(lower);
+            tables.upper[lower - kCaseTableBase] = static_cast<uint16_t>(upper);
+        }
+    }
+    // Letters whose uppercase form has a different lowercase pair
+    tables.upper[0x00B5 - kCaseTableBase] = 0x039C; // micro sign -> capital mu
+    tables.upper[0x03C2 - kCaseTableBase] = 0x03A3; // final sigma -> capital sigma
+    return tables;
+}
+
+/// Таблицы регистра, построенные при компиляции
+constexpr CaseTables kCaseTables = makeCaseTables();
+
+static_assert(kCaseTables.lower[0x0416 - kCaseTableBase] == 0x0436, "Cyrillic zhe");
+static_assert(kCaseTables.upper[0x00FF - kCaseTableBase] == 0x0178, "y with diaeresis");
+
+/**
+ * @brief Меняет регистр ASCII-буквы
+ * @param c Байт ASCII
+ * @param upper true для заглавной формы
+ * @return Преобразованный байт
+ */
+inline char convertAscii(char c, bool upper) {
+    if (upper ? (c >= 'a' && c <= 'z') : (c >= 'A' && c <= 'Z')) {
+        return static_cast<char>(c ^ 0x20);
+    }
+    return c;
+}
+
+/**
+ * @brief Преобразует один символ UTF-8 на месте
+ *
+ * Для вида Title состояние newWord следует правилам прежнего toTitle: первая
+ * буква после пробельного символа становится заглавной, остальные строчными.
+ *
+ * @param data Начало текста
+ * @param size Размер текста
+ * @param i Позиция первого байта символа
+ * @param mode Вид преобразования
+ * @param newWord Ожидается ли начало слова (для Title, обновляется)
+ * @return Позиция следующего символа
+ */
+size_t convertCodePoint(char* data, size_t size, size_t i, LetterCase mode, bool& newWord) {
+    const unsigned char c = static_cast<unsigned char>(data[i]);
+    if (c < 0x80) {
+        if (mode != LetterCase::Title) {
+            data[i] = convertAscii(data[i], mode == LetterCase::Upper);
+        } else if (newWord && ((c | 0x20) >= 'a' && (c | 0x20) <= 'z')) {
+            data[i] = convertAscii(data[i], true);
+            newWord = false;
+        } else if (isSpace(data[i])) {
+            newWord = true;
+        } else {
+            data[i] = convertAscii(data[i], false);
+        }
+        return i + 1;
+    }
+
+    // Only two-byte sequences have table entries; others are skipped whole
+    const unsigned char next = i + 1 < size ? static_cast<unsigned char>(data[i + 1]) : 0;
+    if ((c & 0xE0) != 0xC0 || (next & 0xC0) != 0x80) {
+        size_t length = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : 1;
+        size_t end = i + 1;
+        while (end < size && end < i + length && (static_cast<unsigned char>(data[end]) & 0xC0) == 0x80) {
+            ++end;
+        }
+        return end;
+    }
+
+    const uint32_t cp = (uint32_t(c & 0x1F) << 6) | (next & 0x3F);
+    if (cp >= kCaseTableBase && cp < kCaseTableEnd) {
+        const uint16_t upper = kCaseTables.upper[cp - kCaseTableBase];
+        const uint16_t lower = kCaseTables.lower[cp - kCaseTableBase];
+        uint16_t mapped = 0;
+        switch (mode) {
+            case LetterCase::Upper: mapped = upper; break;
+            case LetterCase::Lower: mapped = lower; break;
+            case LetterCase::Title:
+                if (upper == 0 && lower == 0) break;
+                mapped = newWord ? upper : lower;
+                newWord = false;
+                break;
+        }
+        if (mapped) {
+            data[i] = static_cast<char>(0xC0 | (mapped >> 6));
+            data[i + 1] = static_cast<char>(0x80 | (mapped & 0x3F));
+        }
+    }
+    return i + 2;
+}
+
+/**
+ * @brief Скалярное преобразование регистра участка текста
+ * @param data Начало текста
+ * @param size Размер текста
+ * @param from Позиция начала участка (начало символа)
+ * @param to Позиция, до которой нужно дойти (последний символ может выйти за нее)
+ * @param mode Вид преобразования
+ * @param newWord Ожидается ли начало слова (для Title, обновляется)
+ * @return Позиция после последнего обработанного символа
+ */
+size_t convertCaseScalar(char* data, size_t size, size_t from, size_t to, LetterCase mode, bool& newWord) {
+    size_t i = from;
+    if (mode == LetterCase::Title) {
+        // ASCII is handled inline; other characters go through the tables
+        bool state = newWord;
+        while (i < to) {
+            const char c = data[i];
+            if (static_cast<unsigned char>(c) >= 0x80) {
+                bool wordState = state;
+                i = convertCodePoint(data, size, i, mode, wordState);
+                state = wordState;
+                continue;
+            }
+            // Branch-free: word starts are too irregular to predict
+            const bool letter = static_cast<unsigned char>((c | 0x20) - 'a') < 26;
+            const char cased = state ? static_cast<char>(c & ~0x20) : static_cast<char>(c | 0x20);
+            data[i] = letter ? cased : c;
+            state = isSpace(c) | (state & !letter);
+            ++i;
+        }
+        newWord = state;
+        return i;
+    }
+    while (i < to) {
+        i = convertCodePoint(data, size, i, mode, newWord);
+    }
+    return i;
+}
+
+#if defined(CPU_FEATURES_X86)
+/**
+ * @brief Преобразование регистра с обработкой ASCII блоками по 16 байт (SSE2)
+ * @param data Начало текста
+ * @param size Размер текста
+ * @param upper true для верхнего регистра, false для нижнего
+ */
+void convertCaseSse2(char* data, size_t size, bool upper) {
+    const __m128i below = _mm_set1_epi8(upper ? 'a' - 1 : 'A' - 1);
+    const __m128i above = _mm_set1_epi8(upper ? 'z' + 1 : 'Z' + 1);
+    const __m128i flip = _mm_set1_epi8(0x20);
+    const LetterCase mode = upper ? LetterCase::Upper : LetterCase::Lower;
+    bool newWord = true;
+    size_t i = 0;
+    while (i + 16 <= size) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        if (_mm_movemask_epi8(chunk) != 0) {
+            // Non-ASCII bytes: convert this block character by character
+            i = convertCaseScalar(data, size, i, i + 16, mode, newWord);
+            continue;
+        }
+        __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(chunk, below), _mm_cmplt_epi8(chunk, above));
+        chunk = _mm_xor_si128(chunk, _mm_and_si128(letters, flip));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), chunk);
+        i += 16;
+    }
+    convertCaseScalar(data, size, i, size, mode, newWord);
+}
+
+/**
+ * @brief Преобразование регистра с обработкой ASCII блоками по 32 байта (AVX2)
+ * @param data Начало текста
+ * @param size Размер текста
+ * @param upper true для верхнего регистра, false для нижнего
+ */
+CPU_TARGET_AVX2
+void convertCaseAvx2(char* data, size_t size, bool upper) {
+    const __m256i below = _mm256_set1_epi8(upper ? 'a' - 1 : 'A' - 1);
+    const __m256i above = _mm256_set1_epi8(upper ? 'z' + 1 : 'Z' + 1);
+    const __m256i flip = _mm256_set1_epi8(0x20);
+    const LetterCase mode = upper ? LetterCase::Upper : LetterCase::Lower;
+    bool newWord = true;
+    size_t i = 0;
+    while (i + 32 <= size) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        if (_mm256_movemask_epi8(chunk) != 0) {
+            // Non-ASCII bytes: convert this block character by character
+            i = convertCaseScalar(data, size, i, i + 32, mode, newWord);
+            continue;
+        }
+        __m256i letters = _mm256_and_si256(_mm256_cmpgt_epi8(chunk, below), _mm256_cmpgt_epi8(above, chunk));
+        chunk = _mm256_xor_si256(chunk, _mm256_and_si256(letters, flip));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), chunk);
+        i += 32;
+    }
+    convertCaseScalar(data, size, i, size, mode, newWord);
+}
+#endif
+
+/// Число байт, которые векторный поиск может проверить сверх просмотренного текста
+constexpr size_t kVerifyBudget = 4096;
+
+/**
+ * @brief Скалярный поиск образца: memchr по первому байту и memcmp остатка
+ *
+ * Используется для текстов, в которых образец может начинаться лишь
+ * в нескольких позициях.
+ *
+ * @param text Начало текста
+ * @param size Размер текста (не меньше длины образца)
+ * @param needle Образец
+ * @param length Длина образца (не меньше 2)
+ * @return Позиция вхождения или npos
+ */
+size_t findScalar(const char* text, size_t size, const char* needle, size_t length) {
+    const char* p = text;
+    const char* last = text + (size - length);
+    while (p <= last) {
+        const void* hit = std::memchr(p, needle[0], static_cast<size_t>(last - p) + 1);
+        if (!hit) break;
+        p = static_cast<const char*>(hit);
+        if (std::memcmp(p + 1, needle + 1, length - 1) == 0) {
+            return static_cast<size_t>(p - text);
+        }
+        ++p;
+    }
+    return SubstringSearcher::npos;
+}
+
+#if defined(CPU_FEATURES_X86)
+/**
+ * @brief Векторный поиск образца по 16 позициям за шаг (SSE2)
+ * @param text Начало текста
+ * @param size Размер текста (образец может начинаться не менее чем в 16 позициях)
+ * @param needle Образец
+ * @param length Длина образца (не меньше 2)
+ * @param stoppedAt Позиция, с которой поиск нужно продолжить другим алгоритмом,
+ *                  или size, если текст просмотрен полностью
+ * @return Позиция вхождения или npos
+ */
+size_t findSse2(const char* text, size_t size, const char* needle, size_t length, size_t& stoppedAt) {
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[length - 1]);
+    const size_t positions = size - length + 1;
+    size_t work = 0;
+    stoppedAt = size;
+    for (size_t i = 0; i < positions; i += 16) {
+        // The final block overlaps the previous one; its checked positions are masked off
+        size_t block = std::min(i, positions - 16);
+        __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + block));
+        __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + block + length - 1));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, last))));
+        if (block < i) mask &= ~0u << (i - block);
+        while (mask) {
+            size_t pos = block + countTrailingZeros(mask);
+            if (std::memcmp(text + pos + 1, needle + 1, length - 2) == 0) return pos;
+            work += length;
+            mask &= mask - 1;
+        }
+        if (work > 4 * i + kVerifyBudget) {
+            stoppedAt = block + 16;
+            return SubstringSearcher::npos;
+        }
+    }
+    return SubstringSearcher::npos;
+}
+
+/**
+ * @brief Векторный поиск образца по 32 позициям за шаг (AVX2)
+ * @param text Начало текста
+ * @param size Размер текста (образец может начинаться не менее чем в 32 позициях)
+ * @param needle Образец
+ * @param length Длина образца (не меньше 2)
+ * @param stoppedAt Позиция, с которой поиск нужно продолжить другим алгоритмом,
+ *                  или size, если текст просмотрен полностью
+ * @return Позиция вхождения или npos
+ */
+CPU_TARGET_AVX2
+size_t findAvx2(const char* text, size_t size, const char* needle, size_t length, size_t& stoppedAt) {
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[length - 1]);
+    const size_t positions = size - length + 1;
+    size_t work = 0;
+    stoppedAt = size;
+    for (size_t i = 0; i < positions; i += 32) {
+        // The final block overlaps the previous one; its checked positions are masked off
+        size_t block = std::min(i, positions - 32);
+        __m256i head = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + block));
+        __m256i tail = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + block + length - 1));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(head, first), _mm256_cmpeq_epi8(tail, last))));
+        if (block < i) mask &= ~0u << (i - block);
+        while (mask) {
+            size_t pos = block + countTrailingZeros(mask);
+            if (std::memcmp(text + pos + 1, needle + 1, length - 2) == 0) return pos;
+            work += length;
+            mask &= mask - 1;
+        }
+        if (work > 4 * i + kVerifyBudget) {
+            stoppedAt = block + 32;
+            return SubstringSearcher::npos;
+        }
+    }
+    return SubstringSearcher::npos;
+}
+#endif
+
+/**
+ * @brief Находит критическое разбиение образца (максимальный суффикс)
+ * @param needle Образец
+ * @param length Длина образца
+ * @param period Период правой части разбиения
+ * @return Позиция разбиения
+ */
+size_t criticalFactorization(const char* needle, size_t length, size_t& period) {
+    if (length < 3) {
+        period = 1;
+        return length - 1;
+    }
+
+    // Maximal suffix for "<" and for ">"; indices start at SIZE_MAX and wrap to 0
+    size_t maxSuffix = SIZE_MAX;
+    size_t j = 0, k = 1, p = 1;
+    while (j + k < length) {
+        unsigned char a = static_cast<unsigned char>(needle[j + k]);
+        unsigned char b = static_cast<unsigned char>(needle[maxSuffix + k]);
+        if (a < b) {
+            j += k;
+            k = 1;
+            p = j - maxSuffix;
+        } else if (a == b) {
+            if (k != p) {
+                ++k;
+            } else {
+                j += p;
+                k = 1;
+            }
+        } else {
+            maxSuffix = j++;
+            k = p = 1;
+        }
+    }
+    period = p;
+
+    size_t maxSuffixRev = SIZE_MAX;
+    j = 0;
+    k = p = 1;
+    while (j + k < length) {
+        unsigned char a = static_cast<unsigned char>(needle[j + k]);
+        unsigned char b = static_cast<unsigned char>(needle[maxSuffixRev + k]);
+        if (b < a) {
+            j += k;
+            k = 1;
+            p = j - maxSuffixRev;
+        } else if (a == b) {
+            if (k != p) {
+                ++k;
+            } else {
+                j += p;
+                k = 1;
+            }
+        } else {
+            maxSuffixRev = j++;
+            k = p = 1;
+        }
+    }
+
+    if (maxSuffixRev + 1 < maxSuffix + 1) {
+        return maxSuffix + 1;
+    }
+    period = p;
+    return maxSuffixRev + 1;
+}
+
+} // namespace
+
+/**
+ * @brief Подсчитывает слова, разделенные пробельными символами
+ * @param data Начало текста
+ * @param size Размер текста в байтах
+ * @return Количество слов
+ */
+size_t countWords(const char* data, size_t size) {
+    bool inWord = false;
+    return countWords(data, size, inWord);
+}
+
+/**
+ * @brief Подсчитывает начала слов во фрагменте потока текста
+ * @param data Начало фрагмента
+ * @param size Размер фрагмента в байтах
+ * @param inWord Окончился ли предыдущий фрагмент внутри слова (обновляется)
+ * @return Количество слов, начинающихся во фрагменте
+ */
+size_t countWords(const char* data, size_t size, bool& inWord) {
+    switch (instructionSet()) {
+#if defined(CPU_FEATURES_X86)
+        case InstructionSet::Avx2: return countWordsAvx2(data, size, inWord);
+        case InstructionSet::Sse2: return countWordsSse2(data, size, inWord);
+#endif
+        default: return countWordsScalar(data, size, inWord);
+    }
+}
+
+/**
+ * @brief Преобразует регистр текста в кодировке UTF-8 на месте
+ * @param data Начало текста
+ * @param size Размер текста в байтах
+ * @param mode Вид преобразования
+ */
+void convertCase(char* data, size_t size, LetterCase mode) {
+    bool newWord = true;
+    if (mode == LetterCase::Title) {
+        convertCaseScalar(data, size, 0, size, mode, newWord);
+        return;
+    }
+    switch (instructionSet()) {
+#if defined(CPU_FEATURES_X86)
+        case InstructionSet::Avx2: convertCaseAvx2(data, size, mode == LetterCase::Upper); break;
+        case InstructionSet::Sse2: convertCaseSse2(data, size, mode == LetterCase::Upper); break;
+#endif
+        default: convertCaseScalar(data, size, 0, size, mode, newWord); break;
+    }
+}
+
+/**
+ * @brief Подготавливает поиск образца
+ * @param needle Искомая подстрока
+ */
+SubstringSearcher::SubstringSearcher(std::string_view needle)
+    : needle(needle), criticalPos(0), period(1), periodic(false) {
+    if (needle.size() >= 2) {
+        criticalPos = criticalFactorization(needle.data(), needle.size(), period);
+        periodic = std::memcmp(needle.data(), needle.data() + period, criticalPos) == 0;
+        if (!periodic) {
+            period = std::max(criticalPos, needle.size() - criticalPos) + 1;
+        }
+    }
+}
+
+/**
+ * @brief Ищет первое вхождение образца
+ * @param text Текст
+ * @param from Позиция начала поиска
+ * @return Позиция вхождения или npos (пустой образец находится в позиции from)
+ */
+size_t SubstringSearcher::find(std::string_view text, size_t from) const {
+    if (from > text.size()) return npos;
+    const char* data = text.data() + from;
+    const size_t size = text.size() - from;
+    const size_t length = needle.size();
+    if (length == 0) return from;
+    if (length > size) return npos;
+    if (length == 1) {
+        const void* hit = std::memchr(data, needle[0], size);
+        return hit ? static_cast<size_t>(static_cast<const char*>(hit) - text.data()) : npos;
+    }
+
+    const size_t positions = size - length + 1;
+    size_t found = npos;
+    size_t stoppedAt = size;
+    switch (instructionSet()) {
+#if defined(CPU_FEATURES_X86)
+        case InstructionSet::Avx2:
+            if (positions >= 32) {
+                found = findAvx2(data, size, needle.data(), length, stoppedAt);
+                break;
+            }
+            [[fallthrough]];
+        case InstructionSet::Sse2:
+            if (positions >= 16) {
+                found = findSse2(data, size, needle.data(), length, stoppedAt);
+            } else {
+                found = findScalar(data, size, needle.data(), length);
+            }
+            break;
+#endif
+        default:
+            if (positions >= 16) {
+                stoppedAt = 0;
+            } else {
+                found = findScalar(data, size, needle.data(), length);
+            }
+            break;
+    }
+
+    if (found == npos && stoppedAt < size) {
+        found = findTwoWay(data + stoppedAt, size - stoppedAt);
+        if (found != npos) found += stoppedAt;
+    }
+    return found == npos ? npos : found + from;
+}
+
+/**
+ * @brief Поиск алгоритмом Two-Way (Crochemore-Perrin)
+ * @param text Начало текста
+ * @param size Размер текста
+ * @return Позиция вхождения или npos
+ */
+size_t SubstringSearcher::findTwoWay(const char* text, size_t size) const {
+    const size_t length = needle.size();
+    if (length > size) return npos;
+    const char* p = needle.data();
+    size_t j = 0;
+
+    if (periodic) {
+        // Prefix up to the already matched period does not need rechecking
+        size_t memory = 0;
+        while (j <= size - length) {
+            size_t i = std::max(criticalPos, memory);
+            while (i < length && p[i] == text[i + j]) ++i;
+            if (i >= length) {
+                i = criticalPos - 1;
+                while (memory < i + 1 && p[i] == text[i + j]) --i;
+                if (i + 1 < memory + 1) return j;
+                j += period;
+                memory = length - period;
+            } else {
+                j += i - criticalPos + 1;
+                memory = 0;
+            }
+        }
+    } else {
+        while (j <= size - length) {
+            size_t i = criticalPos;
+            while (i < length && p[i] == text[i + j]) ++i;
+            if (i >= length) {
+                i = criticalPos - 1;
+                while (i != SIZE_MAX && p[i] == text[i + j]) --i;
+                if (i == SIZE_MAX) return j;
+                j += period;
+            } else {
+                j += i - criticalPos + 1;
+            }
+        }
+    }
+    return npos;
+}
+
+/**
+ * @brief Строит таблицу строк текста, разделенного символами '\n'
+ * @param data Начало текста
+ * @param size Размер текста в байтах
+ * @param spans Вектор, в конец которого добавляются найденные строки
+ */
+void scanLines(const char* data, size_t size, std::vector<LineSpan>& spans) {
+    LineCollector lines(data, spans);
+    switch (instructionSet()) {
+#if defined(CPU_FEATURES_X86)
+        case InstructionSet::Avx2: scanLinesAvx2(data, size, lines); break;
+        case InstructionSet::Sse2: scanLinesSse2(data, size, lines); break;
+#endif
+        default: scanLinesScalar(data, size, 0, lines); break;
+    }
+    lines.finish(size);
+}
+
+/**
+ * @brief Возвращает название используемого набора инструкций
+ * @return "avx2", "sse2" или "scalar"
+ */
+const char* kernelInstructionSet() {
+    switch (instructionSet()) {
+        case InstructionSet::Avx2: return "avx2";
+        case InstructionSet::Sse2: return "sse2";
+        case InstructionSet::Scalar: break;
+    }
+    return "scalar";
+}
@@ -0,0 +1,141 @@
+#ifndef TEXT_KERNELS_H
+#define TEXT_KERNELS_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "text_storage.h"
+
+/**
+ * @file text_kernels.h
+ * @brief Векторизованные низкоуровневые функции обработки текста
+ *
+ * Каждая функция выбирает реализацию (AVX2, SSE2 или скалярную) один раз
+ * при первом вызове в зависимости от возможностей процессора.
+ */
+
+/**
+ * @brief Строит таблицу строк текста, разделенного символами '\n'
+ *
+ * Завершающий '\r' строки в нее не включается. Последняя строка без '\n'
+ * учитывается, пустой хвост после последнего '\n' — нет (как у std::getline).
+ *
+ * @param data Начало текста
+ * @param size Размер текста в байтах
+ * @param spans Вектор, в конец которого добавляются найденные строки
+ */
+void scanLines(const char* data, size_t size, std::vector<LineSpan>& spans);
+
+/**
+ * @brief Подсчитывает слова, разделенные пробельными символами
+ *
+ * Пробельными считаются ' ', '\t', '\n', '\v', '\f' и '\r' (как у
+ * operator>> в классической локали).
+ *
+ * @param data Начало текста
+ * @param size Размер текста в байтах
+ * @return Количество слов
+ */
+size_t countWords(const char* data, size_t size);
+
+/**
+ * @brief Подсчитывает начала слов во фрагменте потока текста
+ *
+ * Позволяет считать слова в тексте, разбитом на произвольные фрагменты
+ * (например, при чтении файла блоками): состояние переносится между вызовами.
+ *
+ * @param data Начало фрагмента
+ * @param size Размер фрагмента в байтах
+ * @param inWord Окончился ли предыдущий фрагмент внутри слова (обновляется)
+ * @return Количество слов, начинающихся во фрагменте
+ */
+size_t countWords(const char* data, size_t size, bool& inWord);
+
+/**
+ * @brief Вид преобразования регистра
+ */
+enum class LetterCase {
+    Upper, ///< ВЕРХНИЙ РЕГИСТР
+    Lower, ///< нижний регистр
+    Title  ///< Первая Буква Слова Заглавная
+};
+
+/**
+ * @brief Преобразует регистр текста в кодировке UTF-8 на месте
+ *
+ * Помимо ASCII преобразуются буквы Latin-1, Latin Extended-A, греческого
+ * алфавита и кириллицы. Учитываются только соответствия, не меняющие длину
+ * символа в байтах (например, 'ß' и турецкая 'ı' не преобразуются), поэтому
+ * размер текста не изменяется. Некорректные последовательности UTF-8
+ * остаются без изменений.
+ *
+ * @param data Начало текста
+ * @param size Размер текста в байтах
+ * @param mode Вид преобразования
+ */
+void convertCase(char* data, size_t size, LetterCase mode);
+
+/**
+ * @class SubstringSearcher
+ * @brief Поиск подстроки, подготовленный для одного образца
+ *
+ * Кандидаты отбираются векторным сравнением первого и последнего байта
+ * образца сразу для 16/32 позиций, после чего середина проверяется memcmp.
+ * Если проверок становится слишком много (образцы вида "aaaa" в тексте
+ * "aaaa..."), поиск продолжается алгоритмом Two-Way с линейной оценкой.
+ * Образец подготавливается один раз и используется для множества строк.
+ */
+class SubstringSearcher {
+public:
+    static constexpr size_t npos = std::string_view::npos; ///< Признак отсутствия вхождения
+
+    /**
+     * @brief Подготавливает поиск образца
+     * @param needle Искомая подстрока
+     */
+    explicit SubstringSearcher(std::string_view needle);
+
+    /**
+     * @brief Ищет первое вхождение образца
+     * @param text Текст
+     * @param from Позиция начала поиска
+     * @return Позиция вхождения или npos (пустой образец находится в позиции from)
+     */
+    size_t find(std::string_view text, size_t from = 0) const;
+
+    /**
+     * @brief Проверяет, входит ли образец в текст
+     * @param text Текст
+     * @return true если вхождение найдено
+     */
+    bool containedIn(std::string_view text) const { return find(text) != npos; }
+
+    /**
+     * @brief Возвращает длину образца
+     * @return Длина в байтах
+     */
+    size_t size() const { return needle.size(); }
+
+private:
+    std::string needle;  ///< Образец
+    size_t criticalPos;  ///< Позиция критического разбиения образца (Two-Way)
+    size_t period;       ///< Период правой части образца (Two-Way)
+    bool periodic;       ///< Левая часть образца повторяется с периодом period
+
+    /**
+     * @brief Поиск алгоритмом Two-Way (Crochemore-Perrin)
+     * @param text Начало текста
+     * @param size Размер текста
+     * @return Позиция вхождения или npos
+     */
+    size_t findTwoWay(const char* text, size_t size) const;
+};
+
+/**
+ * @brief Возвращает название используемого набора инструкций
+ * @return "avx2", "sse2" или "scalar"
+ */
+const char* kernelInstructionSet();
+
+#endif // TEXT_KERNELS_H
@@ -0,0 +1,66 @@
+#include "text_storage.h"
+#include "piece_table.h"
+#include "rope.h"
+
+/**
+ * @brief Заменяет содержимое непрерывным текстом
+ * @param text Текст документа
+ * @param spans Положения строк в тексте
+ */
+void TextStorage::assign(std::string text, std::vector<LineSpan> spans) {
+    auto owner = std::make_shared<const std::string>(std::move(text));
+    TextBlock block{owner, std::string_view(*owner)};
+    assignBlock(std::move(block), std::move(spans));
+}
+
+/**
+ * @brief Заменяет содержимое набором строк (одно выделение памяти под текст)
+ * @param lines Строки документа
+ */
+void TextStorage::assignLines(const std::vector<std::string>& lines) {
+    size_t size = 0;
+    for (const auto& line : lines) {
+        size += line.size();
+    }
+
+    std::string text;
+    text.reserve(size);
+    std::vector<LineSpan> spans;
+    spans.reserve(lines.size());
+    for (const auto& line : lines) {
+        spans.push_back({text.size(), line.size()});
+        text += line;
+    }
+    assign(std::move(text), std::move(spans));
+}
+
+/**
+ * @brief Вставляет строки перед указанной позицией
+ * @param index Индекс, на который встанет первая новая строка
+ * @param newLines Вставляемые строки
+ */
+void TextStorage::insertLines(size_t index, const std::vector<std::string>& newLines) {
+    replaceLines(index, 0, newLines);
+}
+
+/**
+ * @brief Удаляет диапазон строк
+ * @param index Индекс первой удаляемой строки
+ * @param count Количество удаляемых строк
+ */
+void TextStorage::eraseLines(size_t index, size_t count) {
+    replaceLines(index, count, {});
+}
+
+/**
+ * @brief Создает пустое хранилище выбранного типа
+ * @param engine Механизм хранения
+ * @return Новое хранилище
+ */
+std::unique_ptr<TextStorage> makeTextStorage(StorageEngine engine) {
+    switch (engine) {
+        case StorageEngine::Rope: return std::make_unique<Rope>();
+        case StorageEngine::PieceTable: break;
+    }
+    return std::make_unique<PieceTable>();
+}
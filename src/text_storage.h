@@ -0,0 +1,138 @@
+#ifndef TEXT_STORAGE_H
+#define TEXT_STORAGE_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @struct LineSpan
+ * @brief Положение строки внутри непрерывного буфера
+ */
+struct LineSpan {
+    size_t offset; ///< Смещение первого байта строки
+    size_t length; ///< Длина строки в байтах (без перевода строки)
+};
+
+/**
+ * @struct TextBlock
+ * @brief Неизменяемый непрерывный блок текста вместе с владельцем его памяти
+ *
+ * Владельцем может быть строка в памяти или отображенный файл; блок остается
+ * действительным, пока жив хотя бы один его владелец.
+ */
+struct TextBlock {
+    std::shared_ptr<const void> owner; ///< Владелец памяти блока
+    std::string_view bytes;            ///< Содержимое блока
+};
+
+/**
+ * @brief Функция обхода строк: fn(индекс строки, содержимое)
+ */
+using LineVisitor = std::function<void(size_t, std::string_view)>;
+
+/**
+ * @brief Доступные механизмы хранения текста
+ */
+enum class StorageEngine {
+    PieceTable, ///< Таблица фрагментов (по умолчанию)
+    Rope        ///< Сбалансированное B-дерево блоков строк
+};
+
+/**
+ * @class TextStorage
+ * @brief Интерфейс хранилища строк документа
+ *
+ * Все индексы строк начинаются с 0. Представления строк, возвращаемые
+ * хранилищем, действительны до следующего изменения.
+ */
+class TextStorage {
+public:
+    virtual ~TextStorage() = default;
+
+    /**
+     * @brief Заменяет содержимое неизменяемым блоком текста
+     * @param block Блок текста документа
+     * @param spans Положения строк в блоке
+     */
+    virtual void assignBlock(TextBlock block, std::vector<LineSpan> spans) = 0;
+
+    /**
+     * @brief Удаляет все строки
+     */
+    virtual void clear() = 0;
+
+    /**
+     * @brief Возвращает количество строк
+     * @return Количество строк
+     */
+    virtual size_t lineCount() const = 0;
+
+    /**
+     * @brief Возвращает суммарный размер строк в байтах
+     * @return Количество байт без переводов строк
+     */
+    virtual size_t byteCount() const = 0;
+
+    /**
+     * @brief Возвращает строку по индексу
+     * @param index Индекс строки
+     * @return Представление строки
+     */
+    virtual std::string_view line(size_t index) const = 0;
+
+    /**
+     * @brief Заменяет диапазон строк новыми строками
+     * @param index Индекс первой заменяемой строки
+     * @param count Количество заменяемых строк
+     * @param newLines Новые строки
+     */
+    virtual void replaceLines(size_t index, size_t count, const std::vector<std::string>& newLines) = 0;
+
+    /**
+     * @brief Последовательно обходит строки диапазона [first, last)
+     * @param first Индекс первой строки
+     * @param last Индекс за последней строкой
+     * @param fn Функция обхода
+     */
+    virtual void forEachLine(size_t first, size_t last, const LineVisitor& fn) const = 0;
+
+    /**
+     * @brief Заменяет содержимое непрерывным текстом
+     * @param text Текст документа
+     * @param spans Положения строк в тексте
+     */
+    void assign(std::string text, std::vector<LineSpan> spans);
+
+    /**
+     * @brief Заменяет содержимое набором строк (одно выделение памяти под текст)
+     * @param lines Строки документа
+     */
+    void assignLines(const std::vector<std::string>& lines);
+
+    /**
+     * @brief Вставляет строки перед указанной позицией
+     * @param index Индекс, на который встанет первая новая строка
+     * @param newLines Вставляемые строки
+     */
+    void insertLines(size_t index, const std::vector<std::string>& newLines);
+
+    /**
+     * @brief Удаляет диапазон строк
+     * @param index Индекс первой удаляемой строки
+     * @param count Количество удаляемых строк
+     */
+    void eraseLines(size_t index, size_t count);
+};
+
+/**
+ * @brief Создает пустое хранилище выбранного типа
+ * @param engine Механизм хранения
+ * @return Новое хранилище
+ */
+std::unique_ptr<TextStorage> makeTextStorage(StorageEngine engine);
+
+#endif // TEXT_STORAGE_H
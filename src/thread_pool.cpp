@@ -0,0 +1,170 @@
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+/**
+ * @brief Запускает рабочие потоки
+ * @param threads Общее число потоков обработки, включая вызывающий (не меньше 1)
+ */
+ThreadPool::ThreadPool(size_t threads) : stopping(false) {
+    size_t helpers = threads > 1 ? threads - 1 : 0;
+    workers.reserve(helpers);
+    for (size_t i = 0; i < helpers; ++i) {
+        workers.emplace_back([this] { workerLoop(); });
+    }
+}
+
+/**
+ * @brief Останавливает и дожидается рабочих потоков
+ */
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    available.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+/**
+ * @brief Возвращает общее число потоков обработки, включая вызывающий
+ * @return Количество потоков
+ */
+size_t ThreadPool::size() const {
+    return workers.size() + 1;
+}
+
+/**
+ * @brief Цикл рабочего потока: выполняет задачи из очереди
+ */
+void ThreadPool::workerLoop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            available.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty()) return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+/**
+ * @brief Обрабатывает диапазон [begin, end) кусками по grain элементов
+ * @param begin Начало диапазона
+ * @param end Конец диапазона
+ * @param grain Размер куска (не меньше 1)
+ * @param fn Функция обработки куска
+ * @param maxThreads Наибольшее число участвующих потоков (0 - все потоки пула)
+ */
+void ThreadPool::parallelFor(size_t begin, size_t end, size_t grain, const RangeTask& fn, size_t maxThreads) {
+    if (begin >= end) return;
+    if (grain == 0) grain = 1;
+    const size_t chunks = (end - begin + grain - 1) / grain;
+    size_t participants = std::min(size(), chunks);
+    if (maxThreads > 0) participants = std::min(participants, maxThreads);
+
+    // Очередь кусков участника: [first, last) в номерах кусков. Участник берет
+    // куски с начала своей очереди, а похитители забирают ее вторую половину
+    struct alignas(64) Slot {
+        std::mutex mutex;
+        size_t first = 0;
+        size_t last = 0;
+    };
+
+    // Состояние живет, пока его держит хотя бы один помощник: помощник,
+    // запущенный после обработки всех кусков, сразу завершается
+    struct State {
+        std::unique_ptr<Slot[]> slots;
+        std::atomic<size_t> nextSlot{1};
+        std::atomic<size_t> done{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::exception_ptr error;
+    };
+    auto state = std::make_shared<State>();
+    state->slots.reset(new Slot[participants]);
+    for (size_t i = 0; i < participants; ++i) {
+        state->slots[i].first = chunks * i / participants;
+        state->slots[i].last = chunks * (i + 1) / participants;
+    }
+
+    auto run = [state, begin, end, grain, chunks, participants, &fn](size_t self) {
+        Slot& own = state->slots[self];
+        for (;;) {
+            size_t chunk;
+            {
+                std::lock_guard<std::mutex> lock(own.mutex);
+                chunk = own.first < own.last ? own.first++ : chunks;
+            }
+
+            if (chunk == chunks) {
+                // Своя очередь пуста: забираем половину самой длинной чужой
+                size_t victim = participants;
+                size_t longest = 0;
+                for (size_t i = 0; i < participants; ++i) {
+                    if (i == self) continue;
+                    std::lock_guard<std::mutex> lock(state->slots[i].mutex);
+                    size_t left = state->slots[i].last - state->slots[i].first;
+                    if (left > longest) {
+                        longest = left;
+                        victim = i;
+                    }
+                }
+                if (victim == participants) return;
+
+                size_t first, last;
+                {
+                    Slot& other = state->slots[victim];
+                    std::lock_guard<std::mutex> lock(other.mutex);
+                    size_t left = other.last - other.first;
+                    if (left == 0) continue;
+                    last = other.last;
+                    first = last - (left + 1) / 2;
+                    other.last = first;
+                }
+                std::lock_guard<std::mutex> lock(own.mutex);
+                own.first = first;
+                own.last = last;
+                continue;
+            }
+
+            size_t from = begin + chunk * grain;
+            size_t to = std::min(end, from + grain);
+            try {
+                fn(from, to);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (!state->error) state->error = std::current_exception();
+            }
+            if (state->done.fetch_add(1) + 1 == chunks) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->finished.notify_all();
+            }
+        }
+    };
+
+    if (participants > 1) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t i = 1; i < participants; ++i) {
+                tasks.emplace_back([state, run] { run(state->nextSlot.fetch_add(1)); });
+            }
+        }
+        available.notify_all();
+    }
+
+    run(0);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&] { return state->done.load() == chunks; });
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class ThreadPool
+ * @brief Пул рабочих потоков для параллельной обработки диапазонов строк
+ *
+ * Диапазон parallelFor делится между участниками на непрерывные части;
+ * участник обрабатывает свою часть с начала, а закончив ее, забирает
+ * половину оставшихся кусков у самого загруженного участника (work stealing).
+ * Так каждый поток идет по соседним строкам, а неравномерная нагрузка
+ * (например, длинные строки в одной части) выравнивается.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Функция обработки поддиапазона [from, to)
+     */
+    using RangeTask = std::function<void(size_t, size_t)>;
+
+    /**
+     * @brief Запускает рабочие потоки
+     * @param threads Общее число потоков обработки, включая вызывающий (не меньше 1)
+     */
+    explicit ThreadPool(size_t threads);
+
+    /**
+     * @brief Останавливает и дожидается рабочих потоков
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Возвращает общее число потоков обработки, включая вызывающий
+     * @return Количество потоков
+     */
+    size_t size() const;
+
+    /**
+     * @brief Обрабатывает диапазон [begin, end) кусками по grain элементов
+     *
+     * Границы кусков всегда кратны grain от begin. Вызывающий поток тоже
+     * обрабатывает куски и возвращается, когда обработаны все. Первое
+     * исключение из fn пробрасывается вызывающему.
+     *
+     * @param begin Начало диапазона
+     * @param end Конец диапазона
+     * @param grain Размер куска (не меньше 1)
+     * @param fn Функция обработки куска
+     * @param maxThreads Наибольшее число участвующих потоков (0 - все потоки пула)
+     */
+    void parallelFor(size_t begin, size_t end, size_t grain, const RangeTask& fn, size_t maxThreads = 0);
+
+private:
+    std::vector<std::thread> workers;        ///< Рабочие потоки
+    std::deque<std::function<void()>> tasks; ///< Очередь задач
+    std::mutex mutex;                        ///< Защита очереди
+    std::condition_variable available;       ///< Сигнал о новой задаче
+    bool stopping;                           ///< Признак остановки пула
+
+    /**
+     * @brief Цикл рабочего потока: выполняет задачи из очереди
+     */
+    void workerLoop();
+};
+
+#endif // THREAD_POOL_H
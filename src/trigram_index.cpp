@@ -0,0 +1,195 @@
+#include "trigram_index.h"
+#include <algorithm>
+#include <functional>
+#include <iterator>
+
+namespace {
+
+/// Оценка накладных расходов на одну триграмму (узел таблицы и вектор)
+constexpr size_t kPerTrigramOverhead = 64;
+
+/**
+ * @brief Вызывает fn для каждой триграммы текста
+ * @param text Текст
+ * @param fn Функция, принимающая триграмму как 24-битное число
+ */
+template <typename Fn>
+void forEachTrigram(std::string_view text, Fn&& fn) {
+    if (text.size() < 3) return;
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(text.data());
+    uint32_t key = (uint32_t(p[0]) << 8) | p[1];
+    for (size_t i = 2; i < text.size(); ++i) {
+        key = ((key << 8) | p[i]) & 0xFFFFFF;
+        fn(key);
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Создает недействительный (непостроенный) индекс
+ * @param memoryLimit Наибольший размер индекса в байтах
+ */
+TrigramIndex::TrigramIndex(size_t memoryLimit) : entries(0), limit(memoryLimit), valid(false) {}
+
+/**
+ * @brief Строит индекс по всему документу
+ * @param storage Хранилище строк
+ * @return false если документ не уложился в лимит памяти (индекс остается недействительным)
+ */
+bool TrigramIndex::build(const TextStorage& storage) {
+    invalidate();
+    if (storage.lineCount() > kMaxIndexedLines) return false;
+
+    // Lines are visited in order, so appending keeps every list sorted
+    bool overflow = false;
+    storage.forEachLine(0, storage.lineCount(), [&](size_t index, std::string_view line) {
+        if (overflow) return;
+        const uint32_t entry = static_cast<uint32_t>(index);
+        forEachTrigram(line, [&](uint32_t key) {
+            Postings& lines = postings[key];
+            if (lines.empty() || lines.back() != entry) {
+                lines.push_back(entry);
+                ++entries;
+            }
+        });
+        overflow = memoryUsage() > limit;
+    });
+    // Ids start out equal to line numbers
+    if (!overflow) {
+        lines.reset(storage.lineCount());
+        overflow = memoryUsage() > limit;
+    }
+    if (overflow) {
+        invalidate();
+        return false;
+    }
+    valid = true;
+    return true;
+}
+
+/**
+ * @brief Освобождает индекс и помечает его недействительным
+ */
+void TrigramIndex::invalidate() {
+    std::unordered_map<uint32_t, Postings>().swap(postings);
+    lines.clear();
+    entries = 0;
+    valid = false;
+}
+
+/**
+ * @brief Задает лимит памяти; больший текущего размера индекс освобождается
+ * @param bytes Наибольший размер индекса в байтах
+ */
+void TrigramIndex::setMemoryLimit(size_t bytes) {
+    limit = bytes;
+    if (memoryUsage() > limit) invalidate();
+}
+
+/**
+ * @brief Оценивает занимаемую индексом память
+ * @return Размер в байтах
+ */
+size_t TrigramIndex::memoryUsage() const {
+    return entries * sizeof(uint32_t) + postings.size() * kPerTrigramOverhead + lines.memoryUsage();
+}
+
+/**
+ * @brief Добавляет триграммы строки в индекс
+ * @param id Идентификатор строки
+ * @param line Содержимое строки
+ */
+void TrigramIndex::addLine(uint32_t id, std::string_view line) {
+    forEachTrigram(line, [&](uint32_t key) {
+        if (insertPosting(postings[key], id)) ++entries;
+    });
+}
+
+/**
+ * @brief Удаляет триграммы строки из индекса
+ * @param id Идентификатор строки
+ * @param line Содержимое строки
+ */
+void TrigramIndex::removeLine(uint32_t id, std::string_view line) {
+    forEachTrigram(line, [&](uint32_t key) {
+        auto found = postings.find(key);
+        if (found == postings.end()) return;
+        if (erasePosting(found->second, id)) --entries;
+        if (found->second.empty()) postings.erase(found);
+    });
+}
+
+/**
+ * @brief Учитывает замену диапазона строк
+ * @param first Индекс первой замененной строки
+ * @param removed Строки, бывшие в диапазоне до замены
+ * @param added Строки, занявшие диапазон после замены
+ */
+void TrigramIndex::update(size_t first, const std::vector<std::string>& removed,
+                          const std::vector<std::string>& added) {
+    if (!valid) return;
+
+    for (size_t i = 0; i < removed.size(); ++i) {
+        removeLine(lines.idAt(first + i), removed[i]);
+    }
+
+    // Lines after the range keep their ids, so a keystroke touches only its own line
+    const std::vector<uint32_t> ids = lines.replace(first, removed.size(), added.size());
+    for (size_t i = 0; i < added.size(); ++i) {
+        addLine(ids[i], added[i]);
+    }
+
+    if (memoryUsage() > limit) invalidate();
+}
+
+/**
+ * @brief Оставляет в индексе только указанные строки с новой нумерацией подряд
+ * @param kept Отсортированные индексы сохраненных строк
+ */
+void TrigramIndex::retainLines(const std::vector<size_t>& kept) {
+    if (!valid) return;
+
+    const std::vector<uint32_t> renumber = lines.retain(kept);
+    entries = 0;
+    for (auto it = postings.begin(); it != postings.end();) {
+        renumberPostings(it->second, renumber);
+        entries += it->second.size();
+        it = it->second.empty() ? postings.erase(it) : std::next(it);
+    }
+}
+
+/**
+ * @brief Возвращает строки, которые могут содержать образец
+ * @param pattern Образец не короче трех байт
+ * @return Отсортированные индексы строк-кандидатов (начиная с 0)
+ */
+std::vector<size_t> TrigramIndex::candidates(std::string_view pattern) const {
+    std::vector<const Postings*> lists;
+    bool missing = false;
+    forEachTrigram(pattern, [&](uint32_t key) {
+        auto found = postings.find(key);
+        if (found == postings.end()) {
+            missing = true;
+        } else {
+            lists.push_back(&found->second);
+        }
+    });
+    if (missing || lists.empty()) return {};
+
+    // Intersect starting from the shortest list so the working set only shrinks
+    std::sort(lists.begin(), lists.end(), [](const Postings* a, const Postings* b) {
+        return a->size() != b->size() ? a->size() < b->size() : std::less<const Postings*>()(a, b);
+    });
+    lists.erase(std::unique(lists.begin(), lists.end()), lists.end());
+
+    Postings result = *lists[0];
+    Postings next;
+    for (size_t i = 1; i < lists.size() && !result.empty(); ++i) {
+        next.clear();
+        std::set_intersection(result.begin(), result.end(),
+                              lists[i]->begin(), lists[i]->end(), std::back_inserter(next));
+        result.swap(next);
+    }
+    return lines.positions(result);
+}
@@ -0,0 +1,122 @@
+#ifndef TRIGRAM_INDEX_H
+#define TRIGRAM_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "line_ids.h"
+#include "postings.h"
+#include "text_storage.h"
+
+/**
+ * @class TrigramIndex
+ * @brief Индекс триграмм: три подряд идущих байта -> отсортированный список строк
+ *
+ * Строка может содержать подстроку, только если содержит все ее триграммы,
+ * поэтому пересечение списков триграмм образца дает строки-кандидаты, которые
+ * затем проверяются обычным поиском. Образцы короче трех байт индекс не
+ * сужает. Списки хранят устойчивые идентификаторы строк (LineIds), так что
+ * правка не перенумеровывает весь индекс. Если индекс перерастает лимит памяти, он освобождается и поиск
+ * возвращается к полному просмотру.
+ */
+class TrigramIndex {
+public:
+    static constexpr size_t kDefaultMemoryLimit = size_t(256) << 20; ///< Лимит памяти по умолчанию
+
+    /**
+     * @brief Создает недействительный (непостроенный) индекс
+     * @param memoryLimit Наибольший размер индекса в байтах
+     */
+    explicit TrigramIndex(size_t memoryLimit = kDefaultMemoryLimit);
+
+    /**
+     * @brief Строит индекс по всему документу
+     * @param storage Хранилище строк
+     * @return false если документ не уложился в лимит памяти (индекс остается недействительным)
+     */
+    bool build(const TextStorage& storage);
+
+    /**
+     * @brief Освобождает индекс и помечает его недействительным
+     */
+    void invalidate();
+
+    /**
+     * @brief Проверяет, соответствует ли индекс текущему документу
+     * @return true если индекс построен и актуален
+     */
+    bool isValid() const { return valid; }
+
+    /**
+     * @brief Задает лимит памяти; больший текущего размера индекс освобождается
+     * @param bytes Наибольший размер индекса в байтах
+     */
+    void setMemoryLimit(size_t bytes);
+
+    /**
+     * @brief Возвращает лимит памяти
+     * @return Лимит в байтах
+     */
+    size_t memoryLimit() const { return limit; }
+
+    /**
+     * @brief Оценивает занимаемую индексом память
+     * @return Размер в байтах
+     */
+    size_t memoryUsage() const;
+
+    /**
+     * @brief Учитывает замену диапазона строк
+     * @param first Индекс первой замененной строки
+     * @param removed Строки, бывшие в диапазоне до замены
+     * @param added Строки, занявшие диапазон после замены
+     */
+    void update(size_t first, const std::vector<std::string>& removed,
+                const std::vector<std::string>& added);
+
+    /**
+     * @brief Оставляет в индексе только указанные строки с новой нумерацией подряд
+     * @param kept Отсортированные индексы сохраненных строк
+     */
+    void retainLines(const std::vector<size_t>& kept);
+
+    /**
+     * @brief Возвращает строки, которые могут содержать образец
+     * @param pattern Образец не короче трех байт
+     * @return Отсортированные индексы строк-кандидатов (начиная с 0)
+     */
+    std::vector<size_t> candidates(std::string_view pattern) const;
+
+    /**
+     * @brief Проверяет, может ли индекс сузить поиск образца
+     * @param pattern Образец
+     * @return true если образец не короче трех байт
+     */
+    static bool canNarrow(std::string_view pattern) { return pattern.size() >= 3; }
+
+private:
+    std::unordered_map<uint32_t, Postings> postings; ///< Триграмма -> идентификаторы строк
+    LineIds lines;  ///< Идентификаторы строк в порядке документа
+    size_t entries; ///< Суммарная длина списков
+    size_t limit;   ///< Лимит памяти в байтах
+    bool valid;     ///< Индекс соответствует документу
+
+    /**
+     * @brief Добавляет триграммы строки в индекс
+     * @param id Идентификатор строки
+     * @param line Содержимое строки
+     */
+    void addLine(uint32_t id, std::string_view line);
+
+    /**
+     * @brief Удаляет триграммы строки из индекса
+     * @param id Идентификатор строки
+     * @param line Содержимое строки
+     */
+    void removeLine(uint32_t id, std::string_view line);
+};
+
+#endif // TRIGRAM_INDEX_H
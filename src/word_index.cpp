@@ -0,0 +1,155 @@
+#include "word_index.h"
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+/**
+ * @brief Проверяет, является ли байт символом слова
+ * @param c Байт
+ * @return true для букв и цифр
+ */
+inline bool isWordChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) != 0;
+}
+
+/**
+ * @brief Вызывает fn для каждого слова строки
+ * @param line Строка
+ * @param fn Функция, принимающая std::string_view слова
+ */
+template <typename Fn>
+void forEachWord(std::string_view line, Fn&& fn) {
+    size_t i = 0;
+    while (i < line.size()) {
+        while (i < line.size() && !isWordChar(line[i])) ++i;
+        size_t start = i;
+        while (i < line.size() && isWordChar(line[i])) ++i;
+        if (i > start) fn(line.substr(start, i - start));
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Создает недействительный (непостроенный) индекс
+ */
+WordIndex::WordIndex() : valid(false) {}
+
+/**
+ * @brief Строит индекс по всему документу
+ * @param storage Хранилище строк
+ * @return false если документ слишком велик для индекса (индекс остается недействительным)
+ */
+bool WordIndex::build(const TextStorage& storage) {
+    invalidate();
+    if (storage.lineCount() > kMaxIndexedLines) return false;
+
+    // Lines are visited in order, so appending keeps every list sorted
+    std::string key;
+    storage.forEachLine(0, storage.lineCount(), [&](size_t index, std::string_view line) {
+        const uint32_t entry = static_cast<uint32_t>(index);
+        forEachWord(line, [&](std::string_view word) {
+            key.assign(word.data(), word.size());
+            Postings& lines = postings[key];
+            if (lines.empty() || lines.back() != entry) lines.push_back(entry);
+        });
+    });
+    // Ids start out equal to line numbers
+    lines.reset(storage.lineCount());
+    valid = true;
+    return true;
+}
+
+/**
+ * @brief Освобождает индекс и помечает его недействительным
+ */
+void WordIndex::invalidate() {
+    std::unordered_map<std::string, Postings>().swap(postings);
+    lines.clear();
+    valid = false;
+}
+
+/**
+ * @brief Добавляет слова строки в индекс
+ * @param id Идентификатор строки
+ * @param line Содержимое строки
+ */
+void WordIndex::addLine(uint32_t id, std::string_view line) {
+    std::string key;
+    forEachWord(line, [&](std::string_view word) {
+        key.assign(word.data(), word.size());
+        insertPosting(postings[key], id);
+    });
+}
+
+/**
+ * @brief Удаляет слова строки из индекса
+ * @param id Идентификатор строки
+ * @param line Содержимое строки
+ */
+void WordIndex::removeLine(uint32_t id, std::string_view line) {
+    std::string key;
+    forEachWord(line, [&](std::string_view word) {
+        key.assign(word.data(), word.size());
+        auto found = postings.find(key);
+        if (found == postings.end()) return;
+        erasePosting(found->second, id);
+        if (found->second.empty()) postings.erase(found);
+    });
+}
+
+/**
+ * @brief Учитывает замену диапазона строк
+ * @param first Индекс первой замененной строки
+ * @param removed Строки, бывшие в диапазоне до замены
+ * @param added Строки, занявшие диапазон после замены
+ */
+void WordIndex::update(size_t first, const std::vector<std::string>& removed,
+                       const std::vector<std::string>& added) {
+    if (!valid) return;
+
+    for (size_t i = 0; i < removed.size(); ++i) {
+        removeLine(lines.idAt(first + i), removed[i]);
+    }
+
+    // Lines after the range keep their ids, so their postings stay untouched
+    const std::vector<uint32_t> ids = lines.replace(first, removed.size(), added.size());
+    for (size_t i = 0; i < added.size(); ++i) {
+        addLine(ids[i], added[i]);
+    }
+}
+
+/**
+ * @brief Оставляет в индексе только указанные строки с новой нумерацией подряд
+ * @param kept Отсортированные индексы сохраненных строк
+ */
+void WordIndex::retainLines(const std::vector<size_t>& kept) {
+    if (!valid) return;
+
+    const std::vector<uint32_t> renumber = lines.retain(kept);
+    for (auto it = postings.begin(); it != postings.end();) {
+        renumberPostings(it->second, renumber);
+        it = it->second.empty() ? postings.erase(it) : std::next(it);
+    }
+}
+
+/**
+ * @brief Возвращает строки, содержащие слово
+ * @param word Слово
+ * @return Отсортированные индексы строк (начиная с 0)
+ */
+std::vector<size_t> WordIndex::find(const std::string& word) const {
+    auto found = postings.find(word);
+    if (found == postings.end()) return {};
+    return lines.positions(found->second);
+}
+
+/**
+ * @brief Проверяет, может ли индекс ответить на поиск этого текста
+ * @param keyword Искомый текст
+ * @return true если текст непуст и целиком состоит из символов слова
+ */
+bool WordIndex::canAnswer(std::string_view keyword) {
+    return !keyword.empty() && std::all_of(keyword.begin(), keyword.end(), isWordChar);
+}
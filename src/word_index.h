@@ -0,0 +1,103 @@
+#ifndef WORD_INDEX_H
+#define WORD_INDEX_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "line_ids.h"
+#include "postings.h"
+#include "text_storage.h"
+
+/**
+ * @class WordIndex
+ * @brief Инвертированный индекс слов: слово -> отсортированный список строк
+ *
+ * Словом считается максимальная последовательность символов, для которых
+ * std::isalnum истинно, — ровно то, что searchText считает целым словом.
+ * Списки хранят устойчивые идентификаторы строк (LineIds), поэтому правка
+ * затрагивает только слова измененных строк, а не весь индекс. Замена
+ * документа целиком делает индекс недействительным до следующего построения.
+ */
+class WordIndex {
+public:
+    /**
+     * @brief Создает недействительный (непостроенный) индекс
+     */
+    WordIndex();
+
+    /**
+     * @brief Строит индекс по всему документу
+     * @param storage Хранилище строк
+     * @return false если документ слишком велик для индекса (индекс остается недействительным)
+     */
+    bool build(const TextStorage& storage);
+
+    /**
+     * @brief Освобождает индекс и помечает его недействительным
+     */
+    void invalidate();
+
+    /**
+     * @brief Проверяет, соответствует ли индекс текущему документу
+     * @return true если индекс построен и актуален
+     */
+    bool isValid() const { return valid; }
+
+    /**
+     * @brief Учитывает замену диапазона строк
+     * @param first Индекс первой замененной строки
+     * @param removed Строки, бывшие в диапазоне до замены
+     * @param added Строки, занявшие диапазон после замены
+     */
+    void update(size_t first, const std::vector<std::string>& removed,
+                const std::vector<std::string>& added);
+
+    /**
+     * @brief Оставляет в индексе только указанные строки с новой нумерацией подряд
+     * @param kept Отсортированные индексы сохраненных строк
+     */
+    void retainLines(const std::vector<size_t>& kept);
+
+    /**
+     * @brief Возвращает строки, содержащие слово
+     * @param word Слово
+     * @return Отсортированные индексы строк (начиная с 0)
+     */
+    std::vector<size_t> find(const std::string& word) const;
+
+    /**
+     * @brief Возвращает количество различных слов
+     * @return Размер словаря
+     */
+    size_t wordCount() const { return postings.size(); }
+
+    /**
+     * @brief Проверяет, может ли индекс ответить на поиск этого текста
+     * @param keyword Искомый текст
+     * @return true если текст непуст и целиком состоит из символов слова
+     */
+    static bool canAnswer(std::string_view keyword);
+
+private:
+    std::unordered_map<std::string, Postings> postings; ///< Слово -> идентификаторы строк
+    LineIds lines; ///< Идентификаторы строк в порядке документа
+    bool valid;    ///< Индекс соответствует документу
+
+    /**
+     * @brief Добавляет слова строки в индекс
+     * @param id Идентификатор строки
+     * @param line Содержимое строки
+     */
+    void addLine(uint32_t id, std::string_view line);
+
+    /**
+     * @brief Удаляет слова строки из индекса
+     * @param id Идентификатор строки
+     * @param line Содержимое строки
+     */
+    void removeLine(uint32_t id, std::string_view line);
+};
+
+#endif // WORD_INDEX_H